@@ -0,0 +1,34 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 热点路径微基准：目标上由 BENCH 命令运行（DWT周期数），主机上由 Host/tm_micro 运行（纳秒）。
+// 调用方逐项取结果，目标上每次主循环只测一项并输出一行，避免发送队列溢出。
+// 每项测量 BENCH_SAMPLES 次，每次连续调用 batch 次取平均，并扣除空函数按相同方式调用的计时开销。
+
+#define BENCH_SAMPLES 32
+
+// 有副作用的项（驱动电机、开关或擦写Flash），目标上默认跳过
+#define BENCH_FLAG_SIDE_EFFECTS 0x01
+// 有状态的项（如 MOVE 后再次 MOVE 只会被拒绝）：setup/teardown 在每次调用前后执行，只累计调用本身
+#define BENCH_FLAG_PER_CALL     0x02
+
+typedef uint32_t (*BenchClock_t)(void);
+
+typedef struct {
+    const char *group;
+    const char *name;
+    bool skipped;
+    uint32_t min;       // 每次调用，已扣除计时开销
+    uint32_t median;
+    uint32_t max;
+} BenchResult_t;
+
+// 函数声明
+void Bench_Begin(BenchClock_t clock, uint16_t batch, bool side_effects);
+bool Bench_Next(BenchResult_t *result);  // 每次测量一项，全部完成后返回false
+void Bench_WriteResult(const BenchResult_t *result, const char *unit);
+
+#endif /* __BENCH_H__ */
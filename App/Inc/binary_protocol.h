@@ -0,0 +1,126 @@
+#ifndef __BINARY_PROTOCOL_H__
+#define __BINARY_PROTOCOL_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 二进制控制协议（与ASCII命令共用CDC端点）
+//
+// 帧格式：0x00 | COBS(消息 | CRC16) | 0x00
+//   - 0x00不会出现在ASCII命令中，收到0x00即切换为二进制帧接收
+//   - CRC16为CRC-16/CCITT-FALSE，按小端追加在消息之后
+//   - 消息以 BinHeader_t 开头，后接与操作码对应的定长结构体，全部为小端
+//   - 应答的操作码为请求操作码 | BIN_RESPONSE_FLAG，seq原样返回
+
+#define BIN_MAX_MESSAGE      48
+#define BIN_MAX_FRAME        64   // 编码后帧长度上限（不含分隔符）
+#define BIN_RESPONSE_FLAG    0x80
+
+// 操作码
+typedef enum {
+    BIN_OP_GET    = 0x01,
+    BIN_OP_SET    = 0x02,
+    BIN_OP_MOVE   = 0x03,
+    BIN_OP_SPEED  = 0x04,
+    BIN_OP_HOME   = 0x05,
+    BIN_OP_START  = 0x06,
+    BIN_OP_STATUS = 0x07,
+    BIN_OP_SAVE   = 0x08,
+    BIN_OP_DATA   = 0x09
+} BinOpcode_t;
+
+// 应答状态
+typedef enum {
+    BIN_OK = 0,
+    BIN_ERR_CRC,        // 帧解码或CRC校验失败
+    BIN_ERR_OPCODE,     // 未知操作码
+    BIN_ERR_LENGTH,     // 消息长度与操作码不符
+    BIN_ERR_PARAM,      // 未知参数编号或参数不支持该操作
+    BIN_ERR_REJECTED    // 数值超出范围或当前状态不允许
+} BinStatus_t;
+
+// 方向（与 MotorDirection_t 取值无关，协议中固定）
+#define BIN_DIR_CW       0
+#define BIN_DIR_CCW      1
+#define BIN_DIR_DEFAULT  0xFF  // 仅HOME：使用默认回零方向
+
+#define BIN_RAMP_DEFAULT 0xFFFFFFFFUL  // 仅SPEED：使用 RAMP 参数
+
+#pragma pack(push, 1)
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t seq;
+} BinHeader_t;
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t seq;
+    uint8_t status;
+} BinResponseHeader_t;
+
+// GET：参数编号见 ParamId_t，数值为原始整数（MILLI类型为放大1000倍，BOOL为0/1）
+typedef struct {
+    uint8_t param_id;
+} BinGetRequest_t;
+
+typedef struct {
+    uint8_t param_id;
+    int32_t value;
+} BinSetRequest_t;
+
+typedef struct {
+    int32_t value;
+} BinValueResponse_t;  // GET/SET应答
+
+typedef struct {
+    uint8_t dir;
+    uint16_t steps;
+} BinMoveRequest_t;
+
+typedef struct {
+    uint32_t rate_mhz;
+    uint32_t ramp_mhz_per_s;
+} BinSpeedRequest_t;  // 应答同结构，返回实际生效值
+
+typedef struct {
+    uint8_t dir;
+} BinHomeRequest_t;
+
+// STATUS应答标志位
+#define BIN_STATUS_CURRENT     0x0001
+#define BIN_STATUS_HOLDOFF     0x0002
+#define BIN_STATUS_DIVISION    0x0004
+#define BIN_STATUS_MOVING      0x0008
+#define BIN_STATUS_DIRECTION   0x0010
+#define BIN_STATUS_ZERO_POINT  0x0020
+#define BIN_STATUS_INA236_INIT 0x0040
+#define BIN_STATUS_INA236_READ 0x0080
+#define BIN_STATUS_STALLED     0x0100
+#define BIN_STATUS_PID         0x0200
+
+// STATUS应答：不分等级，一次返回全部状态
+typedef struct {
+    uint32_t freq_mhz;
+    uint32_t rate_mhz;
+    int32_t position;
+    int16_t threshold;
+    int16_t last_current;
+    uint16_t flags;
+    uint16_t target_steps;
+    uint16_t current_steps;
+    uint16_t round_count;
+    uint8_t seq_state;
+    uint8_t home_state;
+} BinStatusResponse_t;
+
+typedef struct {
+    int16_t current[8];
+} BinDataResponse_t;
+
+#pragma pack(pop)
+
+// 函数声明（固件侧）
+void BinaryProtocol_ProcessFrame(const uint8_t *frame, uint16_t len);
+
+#endif /* __BINARY_PROTOCOL_H__ */
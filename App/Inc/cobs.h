@@ -0,0 +1,15 @@
+#ifndef __COBS_H__
+#define __COBS_H__
+
+#include "stdint.h"
+#include <stddef.h>
+
+// COBS（Consistent Overhead Byte Stuffing）编解码
+// 编码后数据不含0x00，0x00用作帧分隔符。编码最多增加 len/254+1 字节。
+#define COBS_MAX_ENCODED_SIZE(len) ((len) + (len) / 254 + 1)
+
+// 函数声明
+size_t Cobs_Encode(const uint8_t *src, size_t len, uint8_t *dst);
+size_t Cobs_Decode(const uint8_t *src, size_t len, uint8_t *dst);  // 返回0表示格式错误
+
+#endif /* __COBS_H__ */
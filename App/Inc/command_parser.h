@@ -4,12 +4,24 @@
 #include "stdint.h"
 #include "stdbool.h"
 
-// 最大命令长度
-#define MAX_CMD_LENGTH 64
+// 最大命令长度（含分号分隔的批量命令）
+#define MAX_CMD_LENGTH 128
+
+// USB接收环形缓冲区大小（必须为2的幂）
+#define CMD_RX_BUFFER_SIZE 512
+// 剩余空间不足一个全速包时暂停接收（端点回NAK），由主循环腾出空间后恢复
+#define CMD_RX_PACKET_SIZE 64
+// 记录到达时间的USB包个数（必须为2的幂），用于PING的接收时间戳
+#define CMD_RX_STAMPS 16
+// 发送队列剩余空间不足时暂缓处理下一条命令（字节）
+#define CMD_TX_RESERVE 128
 
 // 函数声明
 void CommandParser_Init(void);
 void CommandParser_Process(const char *cmd);
-void CommandParser_USBReceiveCallback(uint8_t *buf, uint32_t len);
+void CommandParser_Poll(void);
+
+// USB接收中断中调用：仅拷贝数据，返回false表示缓冲区将满、应暂停接收
+bool CommandParser_USBReceiveCallback(uint8_t *buf, uint32_t len);
 
 #endif /* __COMMAND_PARSER_H__ */
\ No newline at end of file
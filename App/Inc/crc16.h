@@ -0,0 +1,13 @@
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#include "stdint.h"
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE：多项式0x1021，初值0xFFFF
+#define CRC16_INIT 0xFFFF
+
+// 函数声明
+uint16_t Crc16_Update(uint16_t crc, const uint8_t *data, size_t len);
+
+#endif /* __CRC16_H__ */
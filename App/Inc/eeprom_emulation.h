@@ -4,13 +4,18 @@
 #include "stdint.h"
 
 // 虚拟地址定义
-#define EE_ADDR_FREQ        0x0001
+#define EE_ADDR_FREQ_HZ     0x0001  // 旧版固件保存的整数Hz，只在加载时读取
 #define EE_ADDR_THRES       0x0002
 #define EE_ADDR_DEBUG_LEVEL 0x0003
+#define EE_ADDR_FREQ_MHZ    0x0004
+
+// EE_WriteVariables 一次最多写入的变量数
+#define EE_MAX_VARIABLES    8
 
 // 函数声明
 void EE_Init(void);
 uint16_t EE_ReadVariable(uint16_t virt_address, uint32_t* data);
 uint16_t EE_WriteVariable(uint16_t virt_address, uint32_t data);
+uint16_t EE_WriteVariables(const uint16_t virt_address[], const uint32_t data[], uint8_t count);
 
 #endif /* __EEPROM_EMULATION_H__ */
\ No newline at end of file
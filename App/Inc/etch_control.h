@@ -0,0 +1,22 @@
+#ifndef __ETCH_CONTROL_H__
+#define __ETCH_CONTROL_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 电流满量程（uA），误差按此归一化为Q15
+#define PID_CURRENT_FULL_SCALE_UA  8192
+
+// 闭环提拉默认参数
+#define DEFAULT_PID_KP       8192   // 0.25 (Q15)
+#define DEFAULT_PID_KI       328    // 0.01 (Q15)
+#define DEFAULT_PID_KD       0
+#define DEFAULT_PID_MIN_MHZ  1000     // 1Hz
+#define DEFAULT_PID_MAX_MHZ  200000   // 200Hz
+
+// 函数声明
+void EtchControl_Init(void);
+void EtchControl_Reset(void);
+void EtchControl_Sample(int16_t current);
+
+#endif /* __ETCH_CONTROL_H__ */
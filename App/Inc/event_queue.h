@@ -0,0 +1,42 @@
+#ifndef __EVENT_QUEUE_H__
+#define __EVENT_QUEUE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 事件队列长度（必须为2的幂）
+#define EVENT_QUEUE_SIZE     16
+// 每次主循环最多输出的事件数
+#define EVENT_MAX_PER_POLL   4
+// 单条事件消息的最大长度，发送队列空间不足时事件留在队列中
+#define EVENT_TX_RESERVE     72
+
+// 事件类型，编号即 EVENTS 使能掩码中的位号
+typedef enum {
+    EVENT_CUTOFF = 0,    // 电流低于阈值，切断电流  Value: 当前位置
+    EVENT_MOVE_DONE,     // 定步运动完成            Value: 当前位置
+    EVENT_SEQ_STATE,     // 序列状态变化            Value: 新状态
+    EVENT_ZERO_EDGE,     // 原点输入边沿            Value: 电平
+    EVENT_I2C_FAULT,     // INA236通讯失败          Value: 失败阶段
+    EVENT_STALL,         // 失步/堵转               Value: 当前位置
+    EVENT_HOMED,         // 回零结束                Value: 回零状态
+    EVENT_TYPE_COUNT
+} EventType_t;
+
+#define EVENT_MASK_ALL       ((1U << EVENT_TYPE_COUNT) - 1)
+
+// INA236通讯失败阶段
+#define EVENT_I2C_INIT       1
+#define EVENT_I2C_READ_TX    2
+#define EVENT_I2C_READ_RX    3
+
+// 函数声明
+void EventQueue_Init(void);
+void EventQueue_Post(EventType_t type, int32_t value);
+void EventQueue_Process(void);
+
+// 事件使能掩码与丢弃计数
+extern uint8_t event_enable_mask;
+extern uint32_t event_dropped;
+
+#endif /* __EVENT_QUEUE_H__ */
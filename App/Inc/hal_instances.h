@@ -8,6 +8,7 @@
  * 这样任何包含此头文件的 .c 文件都能使用它们。
  */
 extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim2;
 extern I2C_HandleTypeDef hi2c1;
 // 可以根据需要添加其他外设，如 SPI, ADC 等
 
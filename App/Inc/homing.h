@@ -0,0 +1,36 @@
+#ifndef __HOMING_H__
+#define __HOMING_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stepper_motor.h"
+
+// 回零参数
+#define HOME_FAST_RATE_MHZ   2000000  // 快速接近2kHz
+#define HOME_SLOW_RATE_MHZ   100000   // 慢速接近100Hz
+#define HOME_BACKOFF_STEPS   400      // 回退步数
+#define HOME_MAX_STEPS       200000   // 单次接近最大行程，超过则判定失败
+#define HOME_DEFAULT_DIR     MOTOR_DIR_CCW
+
+// 回零状态
+typedef enum {
+    HOME_IDLE = 0,
+    HOME_FAST_APPROACH,
+    HOME_BACKOFF,
+    HOME_SLOW_APPROACH,
+    HOME_DONE,
+    HOME_FAILED
+} HomingState_t;
+
+// 函数声明
+void Homing_Init(void);
+bool Homing_Start(MotorDirection_t dir);
+void Homing_Abort(void);
+void Homing_Process(void);
+bool Homing_IsRunning(void);
+HomingState_t Homing_GetState(void);
+
+// 原点信号（INPUT_ZERO）外部中断处理函数
+void Homing_EXTI4_IRQHandler(void);
+
+#endif /* __HOMING_H__ */
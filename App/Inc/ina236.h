@@ -22,5 +22,6 @@
 // 函数声明
 bool INA236_Init(void);
 bool INA236_ReadCurrent(uint16_t *current);
+uint16_t INA236_ConvertCurrent(const uint8_t data[2]);
 
 #endif /* __INA236_H__ */
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 流式JSON应答输出：直接写入USB发送队列，不使用中间缓冲区和snprintf
+// 一条应答以 Json_Begin 开始、Json_End 结束，期间的输出作为整体发送或整体丢弃。
+// 字符串不做转义，只用于内部固定的标识符。
+
+// 函数声明
+void Json_Begin(const char *cmd, bool success);  // {"Cmd": "<cmd>", "Status": "Success|Error"
+void Json_BeginObject(void);                     // {（不带Cmd/Status的消息）
+void Json_SetRequestId(bool present, uint32_t id); // 之后的 Json_Begin 附带 "Id": <id>
+bool Json_GetRequestId(uint32_t *id);            // 返回是否设置了请求编号
+void Json_SetMuted(bool muted);                  // 静默时只格式化、不写入发送队列（基准测试用）
+void Json_Key(const char *key);                  // , "<key>": （对象中第一个键不带逗号）
+void Json_Int(int32_t value);
+void Json_Uint(uint32_t value);
+void Json_Milli(uint32_t value);                 // 放大1000倍的数值，如 12500 -> 12.5
+void Json_Bool(bool value);
+void Json_String(const char *str);               // 带引号
+void Json_Raw(const char *str);                  // 原样输出
+void Json_Int16Array(const int16_t *values, uint8_t count);
+bool Json_End(void);                             // }\r\n，返回false表示发送队列满被丢弃
+
+#endif /* __JSON_WRITER_H__ */
@@ -0,0 +1,111 @@
+#ifndef __PARAM_REGISTRY_H__
+#define __PARAM_REGISTRY_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include <stddef.h>
+
+// 参数类型（决定存储宽度、SET解析方式和GET输出格式）
+typedef enum {
+    PARAM_BOOL = 0,     // ON/OFF，输出 true/false
+    PARAM_U8,
+    PARAM_I16,
+    PARAM_U16,
+    PARAM_I32,
+    PARAM_U32,
+    PARAM_MILLI,        // uint32，放大1000倍的小数（如 mHz）
+    PARAM_I16_ARRAY     // int16数组，max 为元素个数，只读
+} ParamType_t;
+
+// 参数编号（二进制协议使用），只允许在末尾追加，不得重排
+typedef enum {
+    PARAM_ID_CURRENT = 0,
+    PARAM_ID_CURRENTSTEP,
+    PARAM_ID_DATA,
+    PARAM_ID_DEBUG,
+    PARAM_ID_DIRECTION,
+    PARAM_ID_DIVISION,
+    PARAM_ID_FREQ,
+    PARAM_ID_HOLDOFF,
+    PARAM_ID_HOME,
+    PARAM_ID_INA236INIT,
+    PARAM_ID_INA236READ,
+    PARAM_ID_KD,
+    PARAM_ID_KI,
+    PARAM_ID_KP,
+    PARAM_ID_LASTDATA,
+    PARAM_ID_LEVEL,
+    PARAM_ID_MOVING,
+    PARAM_ID_PHASE,
+    PARAM_ID_PID,
+    PARAM_ID_PIDMAX,
+    PARAM_ID_PIDMIN,
+    PARAM_ID_PIDTARGET,
+    PARAM_ID_POSITION,
+    PARAM_ID_PPR,
+    PARAM_ID_RAMP,
+    PARAM_ID_RATE,
+    PARAM_ID_ROUND,
+    PARAM_ID_RPM,
+    PARAM_ID_SLIPTOL,
+    PARAM_ID_SQSTATE,
+    PARAM_ID_STALL,
+    PARAM_ID_STALLED,
+    PARAM_ID_TARGETSTEP,
+    PARAM_ID_THRES,
+    PARAM_ID_TXHIGH,
+    PARAM_ID_TXOVF,
+    PARAM_ID_ZEROPOINT,
+    PARAM_ID_CMDCYCLES,
+    PARAM_ID_CMDCYCLESMAX,
+    PARAM_ID_STACKPEAK,
+    PARAM_ID_EVENTDROP,
+    PARAM_ID_EVENTS,
+    PARAM_ID_WINDOW,
+    PARAM_ID_TELSKIP,
+    PARAM_ID_COUNT
+} ParamId_t;
+
+// 参数标志
+#define PARAM_FLAG_READONLY  0x01
+
+// 一次批量写入的最大参数个数
+#define PARAM_BATCH_MAX      8
+
+// 参数描述（常量表，存放在Flash中）
+typedef struct {
+    const char *name;         // SET/GET 使用的名称
+    ParamId_t id;
+    ParamType_t type;
+    uint8_t flags;
+    uint8_t status_level;     // 在该STATUS等级中输出，0表示不输出
+    const char *status_key;   // STATUS中的键名，NULL表示与name相同
+    uint16_t ee_addr;         // EEPROM虚拟地址，0表示不保存
+    uint16_t ee_legacy_addr;  // 旧版固件以整数单位保存的地址（PARAM_MILLI），ee_addr无数据时读取并乘以1000
+    void *ptr;                // 存储位置
+    int32_t min;
+    int32_t max;
+    int32_t (*get)(void);     // 计算型参数的读取函数（ptr为NULL时使用）
+    void (*apply)(void);      // 写入后调用，用于同步硬件或复位控制器
+} Param_t;
+
+// 函数声明
+void ParamRegistry_Init(void);
+const Param_t *ParamRegistry_Find(const char *name);
+const Param_t *ParamRegistry_FindById(uint8_t id);
+bool ParamRegistry_Set(const Param_t *param, const char *value);
+bool ParamRegistry_SetValue(const Param_t *param, int32_t value);
+bool ParamRegistry_Parse(const Param_t *param, const char *str, int32_t *value);
+void ParamRegistry_SetBatch(const Param_t *const params[], const int32_t values[], uint8_t count);
+int32_t ParamRegistry_GetValue(const Param_t *param);
+void ParamRegistry_WriteValue(const Param_t *param);
+void ParamRegistry_WriteRaw(const Param_t *param, int32_t value);
+void ParamRegistry_WriteStatus(uint8_t level);
+void ParamRegistry_Save(void);
+void ParamRegistry_Load(void);
+
+// 数值解析：带最多3位小数的非负数（结果放大1000倍）、十进制整数
+bool ParamRegistry_ParseMilli(const char *str, uint32_t *out);
+bool ParamRegistry_ParseInt(const char *str, int32_t *out);
+
+#endif /* __PARAM_REGISTRY_H__ */
@@ -0,0 +1,21 @@
+#ifndef __PERF_MONITOR_H__
+#define __PERF_MONITOR_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 栈填充图案，用于统计栈使用峰值
+#define PERF_STACK_PAINT     0xA5A5A5A5UL
+#define PERF_STACK_MARGIN    64   // 初始化时保留当前SP以下的字节数，不填充
+
+// 函数声明
+void PerfMonitor_Init(void);
+uint32_t PerfMonitor_CycleStart(void);
+void PerfMonitor_CommandDone(uint32_t start);
+uint32_t PerfMonitor_GetStackPeak(void);
+
+// 命令耗时统计（DWT周期数）
+extern uint32_t perf_command_cycles;
+extern uint32_t perf_command_cycles_max;
+
+#endif /* __PERF_MONITOR_H__ */
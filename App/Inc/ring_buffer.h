@@ -0,0 +1,33 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// 单生产者/单消费者字节环形缓冲区（无锁）
+// 生产者只写 head，消费者只写 tail，二者可分别位于中断和主循环中。
+// 索引自由递增、按掩码取模，容量必须为2的幂且不超过32768。
+typedef struct {
+    uint8_t *buffer;
+    uint16_t mask;
+    volatile uint16_t head;  // 写入计数（生产者）
+    volatile uint16_t tail;  // 读取计数（消费者）
+} RingBuffer_t;
+
+// 函数声明
+void RingBuffer_Init(RingBuffer_t *rb, uint8_t *buffer, uint16_t size);
+uint16_t RingBuffer_Count(const RingBuffer_t *rb);
+uint16_t RingBuffer_Free(const RingBuffer_t *rb);
+uint16_t RingBuffer_Write(RingBuffer_t *rb, const uint8_t *data, uint16_t len);
+uint16_t RingBuffer_Read(RingBuffer_t *rb, uint8_t *data, uint16_t len);
+bool RingBuffer_Get(RingBuffer_t *rb, uint8_t *byte);
+
+// 分段写入一条完整消息：先逐段暂存，全部成功后再一次性发布
+bool RingBuffer_Stage(RingBuffer_t *rb, uint16_t staged, const uint8_t *data, uint16_t len);
+void RingBuffer_Commit(RingBuffer_t *rb, uint16_t staged);
+
+// 零拷贝读取：返回从读指针开始的连续数据，处理完后再用 RingBuffer_Skip 释放
+uint16_t RingBuffer_Peek(const RingBuffer_t *rb, uint8_t **data);
+void RingBuffer_Skip(RingBuffer_t *rb, uint16_t len);
+
+#endif /* __RING_BUFFER_H__ */
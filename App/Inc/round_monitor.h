@@ -0,0 +1,22 @@
+#ifndef __ROUND_MONITOR_H__
+#define __ROUND_MONITOR_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// TIM2计数频率（72MHz / 7200）
+#define ROUND_TICK_HZ           10000
+
+// 转动监测默认参数
+#define DEFAULT_PULSES_PER_REV  200  // 每圈脉冲数（需与驱动器细分设置一致）
+#define DEFAULT_SLIP_TOLERANCE  8    // 每圈允许的脉冲偏差
+
+// 函数声明
+void RoundMonitor_Init(void);
+void RoundMonitor_Process(void);
+void RoundMonitor_ResetReference(void);
+
+// TIM2输入捕获（INPUT_ROUNDOUT）中断处理函数
+void RoundMonitor_TIM2_IRQHandler(void);
+
+#endif /* __ROUND_MONITOR_H__ */
@@ -17,6 +17,7 @@ typedef enum {
 // 函数声明
 void SequenceController_Init(void);
 void SequenceController_Start(void);
+void SequenceController_Abort(void);
 void SequenceController_Process(void);
 bool SequenceController_IsRunning(void);
 SequenceState_t SequenceController_GetState(void);
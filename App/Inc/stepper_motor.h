@@ -11,26 +11,34 @@ typedef enum {
     MOTOR_DIR_CCW = false
 } MotorDirection_t;
 
+// 步进速率范围（单位：mHz）
+#define STEPPER_RATE_MIN_MHZ    20UL        // 0.02Hz，PSC/ARR均取最大值时的下限
+#define STEPPER_RATE_MAX_MHZ    50000000UL  // 50kHz
+
 // 脉冲计数回调函数类型
 typedef void (*PulseCompleteCallback_t)(void);
 
 // 函数声明
 void StepperMotor_Init(void);
 void StepperMotor_SetFrequency(uint16_t freq);
+uint32_t StepperMotor_SetRate(uint32_t rate_mhz);
+uint32_t StepperMotor_GetRate(void);
+void StepperMotor_SetTargetRate(uint32_t rate_mhz, uint32_t ramp_mhz_per_s);
 void StepperMotor_Move(MotorDirection_t dir, uint16_t steps);
 void StepperMotor_CountinueMove(MotorDirection_t dir);
 void StepperMotor_Stop(void);
 bool StepperMotor_IsMoving(void);
+MotorDirection_t StepperMotor_GetDirection(void);
 void StepperMotor_UpdateSwitches(bool holdoff, bool division);
 void StepperMotor_Process(void);
 void StepperMotor_SetPulseCompleteCallback(PulseCompleteCallback_t callback);
 uint16_t StepperMotor_GetCurrentPulses(void);
+int32_t StepperMotor_GetPosition(void);
+void StepperMotor_SetPosition(int32_t position);
+void StepperMotor_HaltFromISR(void);
 void StepperMotor_ResetPulseCount(void);
 
 // TIM1中断处理函数
 void StepperMotor_TIM1_Update_IRQHandler(void);
 
-// 原点励磁（中断）计数函数
-void StepperMotor_EXTI3_Update_IRQHandler(void);
-
 #endif /* __STEPPER_MOTOR_H__ */
\ No newline at end of file
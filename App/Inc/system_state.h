@@ -6,6 +6,8 @@
 
 // 系统固定参数
 #define ORIGIN_FREQ 1000 // 默认频率1000Hz
+#define DEFAULT_FREQ_MHZ 25000 // 默认提拉速率25Hz
+#define DEFAULT_RAMP_MHZ_PER_S 10000 // 默认调速斜率10Hz/s
 #define BUFFER_SIZE 8   // 电流缓冲区大小
 
 // 系统状态结构体
@@ -14,9 +16,19 @@ typedef struct {
     // uint16_t origin_freq;
     
     // 用户可调参数
-    uint16_t freq;
+    uint32_t freq_mhz;  // 提拉步进速率（mHz）
+    uint32_t ramp_mhz_per_s; // 运动中调速斜率（mHz/s，0表示直接切换）
     int16_t threshold;
     
+    // 闭环提拉（PID恒电流）
+    bool pid_enabled;
+    int16_t pid_target;       // 目标电流（uA）
+    int16_t pid_kp;           // Q15增益
+    int16_t pid_ki;
+    int16_t pid_kd;
+    uint32_t pid_min_mhz;     // 速率下限
+    uint32_t pid_max_mhz;     // 速率上限
+    
     // 开关状态
     bool switch_current;
     bool switch_holdoff;
@@ -25,10 +37,19 @@ typedef struct {
     // 输入状态
     bool zero_point;
     uint16_t round_count;
+
+    // 转动监测（圈信号输入捕获）
+    uint16_t pulses_per_rev;   // 每圈脉冲数
+    uint16_t slip_tolerance;   // 每圈允许的脉冲偏差
+    bool stall_detect;         // 失步/堵转检测使能
+    bool stall_detected;       // 已检测到失步/堵转
+    uint32_t rpm_milli;        // 实时转速（0.001rpm）
+    uint16_t round_phase;      // 圈信号处的步数相位
     
     // 电流缓冲区
     int16_t current_buffer[BUFFER_SIZE];
     uint8_t buffer_index;
+    uint8_t window;            // 断线判断使用的最近采样数（1..BUFFER_SIZE）
     
     // 调试模式
     uint8_t debug_level;
@@ -51,6 +72,7 @@ extern SystemState_t g_system_state;
 // 函数声明
 void SystemState_Init(void);
 void SystemState_UpdateCurrent(uint16_t current);
+bool SystemState_CurrentBelowThreshold(void);
 void SystemState_ResetRoundCount(void);
 void SystemState_ZeroPoint(void);
 void SystemState_SaveToEEPROM(void);
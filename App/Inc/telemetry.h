@@ -0,0 +1,26 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "param_registry.h"
+
+// 遥测订阅参数
+#define TELEMETRY_MAX_SUBSCRIPTIONS  4
+#define TELEMETRY_MAX_FIELDS         8
+#define TELEMETRY_MIN_PERIOD_MS      5
+#define TELEMETRY_MAX_PERIOD_MS      3600000
+#define TELEMETRY_DEBUG_PERIOD_MS    1000   // DEBUG ON 时 STATUS 输出周期
+#define TELEMETRY_DEBUG_RESERVE      256    // DEBUG ON 时 STATUS 的最大长度
+
+// 函数声明
+void Telemetry_Init(void);
+int8_t Telemetry_Subscribe(uint32_t period_ms, const Param_t *const fields[], uint8_t count);
+bool Telemetry_Unsubscribe(uint8_t id);
+void Telemetry_UnsubscribeAll(void);
+void Telemetry_Process(void);
+
+// 发送队列空间不足而跳过的输出帧数
+extern uint32_t telemetry_skipped;
+
+#endif /* __TELEMETRY_H__ */
@@ -0,0 +1,276 @@
+#include "bench.h"
+#include "command_parser.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "telemetry.h"
+#include "ina236.h"
+#include "eeprom_emulation.h"
+#include "json_writer.h"
+#include "param_registry.h"
+#include <string.h>
+
+typedef struct {
+    const char *group;
+    const char *name;
+    void (*run)(const char *arg);
+    const char *arg;
+    void (*setup)(void);     // 每次采样前调用，不计时（BENCH_FLAG_PER_CALL 时每次调用前）
+    void (*teardown)(void);  // 每次采样后调用，不计时（BENCH_FLAG_PER_CALL 时每次调用后）
+    uint8_t flags;
+} Bench_t;
+
+static BenchClock_t bench_clock;
+static uint16_t bench_batch;
+static bool bench_side_effects;
+static uint8_t bench_next;
+static uint32_t bench_overhead;
+static uint32_t bench_overhead_per_call;
+static int16_t saved_threshold;
+static uint8_t saved_debug_level;
+static char bench_unsubscribe[16];
+
+static void Bench_Nop(const char *arg) {
+    (void)arg;
+}
+
+// 修改设置的命令测量前后恢复原值
+static void Bench_SaveSettings(void) {
+    saved_threshold = g_system_state.threshold;
+    saved_debug_level = g_system_state.debug_level;
+}
+
+static void Bench_RestoreSettings(void) {
+    g_system_state.threshold = saved_threshold;
+    g_system_state.debug_level = saved_debug_level;
+}
+
+// STATUS 在 LEVEL 3 时输出全部参数
+static void Bench_StatusSetup(void) {
+    Bench_SaveSettings();
+    g_system_state.debug_level = 3;
+}
+
+// SPEED 只在运动中生效
+static void Bench_StartMotion(void) {
+    StepperMotor_Move(MOTOR_DIR_CW, 60000);
+}
+
+static void Bench_StopMotion(void) {
+    Homing_Abort();
+    SequenceController_Abort();
+    StepperMotor_Stop();
+}
+
+// 建立一个真实的订阅，UNSUBSCRIBE 使用返回的编号
+static void Bench_SubscribeSetup(void) {
+    const Param_t *fields[] = { ParamRegistry_Find("FREQ"), ParamRegistry_Find("THRES") };
+    int8_t id = Telemetry_Subscribe(100, fields, 2);
+    uint8_t value = id >= 0 ? (uint8_t)id : 255;   // 订阅已满时测到的是出错路径
+    char *p = bench_unsubscribe + sizeof("UNSUBSCRIBE ") - 1;
+
+    memcpy(bench_unsubscribe, "UNSUBSCRIBE ", sizeof("UNSUBSCRIBE ") - 1);
+    if (value >= 100) *p++ = (char)('0' + value / 100);
+    if (value >= 10) *p++ = (char)('0' + value / 10 % 10);
+    *p++ = (char)('0' + value % 10);
+    *p = '\0';
+}
+
+static void Bench_Unsubscribe(const char *arg) {
+    (void)arg;
+    CommandParser_Process(bench_unsubscribe);
+}
+
+static void Bench_UpdateCurrent(const char *arg) {
+    (void)arg;
+    SystemState_UpdateCurrent(123);
+}
+
+static volatile bool bench_sink;
+
+static void Bench_Detect(const char *arg) {
+    (void)arg;
+    bench_sink = SystemState_CurrentBelowThreshold();
+}
+
+static void Bench_Ina236Convert(const char *arg) {
+    static const uint8_t data[2] = { 0x01, 0x90 };
+    (void)arg;
+    bench_sink = INA236_ConvertCurrent(data) != 0;
+}
+
+static void Bench_Ina236Read(const char *arg) {
+    uint16_t current;
+    (void)arg;
+    bench_sink = INA236_ReadCurrent(&current);
+}
+
+static void Bench_EepromRead(const char *arg) {
+    uint32_t data;
+    (void)arg;
+    bench_sink = EE_ReadVariable(EE_ADDR_FREQ_MHZ, &data) == 0;
+}
+
+// 写入与当前值相同的数据：只比较，不擦写Flash
+static void Bench_EepromWriteSame(const char *arg) {
+    uint32_t data = 0xFFFFFFFFUL;
+    (void)arg;
+    EE_ReadVariable(EE_ADDR_THRES, &data);
+    EE_WriteVariable(EE_ADDR_THRES, data);
+}
+
+// 写入不同的数据：擦除页并编程
+static void Bench_EepromWriteChanged(const char *arg) {
+    static uint32_t value;
+    (void)arg;
+    EE_WriteVariable(EE_ADDR_THRES, ++value);
+}
+
+static void Bench_EepromRestore(void) {
+    EE_WriteVariable(EE_ADDR_THRES, (uint32_t)g_system_state.threshold);
+}
+
+// 命令项直接调用 CommandParser_Process，应答在测量期间静默
+static const Bench_t benches[] = {
+    { "command", "GET FREQ", CommandParser_Process, "GET FREQ", NULL, NULL, 0 },
+    { "command", "HOME", CommandParser_Process, "HOME", NULL, Bench_StopMotion,
+      BENCH_FLAG_SIDE_EFFECTS | BENCH_FLAG_PER_CALL },
+    { "command", "MOVE CW 200", CommandParser_Process, "MOVE CW 200", NULL, Bench_StopMotion,
+      BENCH_FLAG_SIDE_EFFECTS | BENCH_FLAG_PER_CALL },
+    { "command", "PING 1", CommandParser_Process, "PING 1", NULL, NULL, 0 },
+    { "command", "SAVE", CommandParser_Process, "SAVE", NULL, NULL, BENCH_FLAG_SIDE_EFFECTS },
+    { "command", "SET THRES 40", CommandParser_Process, "SET THRES 40", Bench_SaveSettings, Bench_RestoreSettings, 0 },
+    { "command", "SET batch", CommandParser_Process, "SET THRES 40;SET THRES 41", Bench_SaveSettings, Bench_RestoreSettings, 0 },
+    { "command", "SPEED 10", CommandParser_Process, "SPEED 10", Bench_StartMotion, Bench_StopMotion,
+      BENCH_FLAG_SIDE_EFFECTS },
+    { "command", "START", CommandParser_Process, "START", NULL, Bench_StopMotion,
+      BENCH_FLAG_SIDE_EFFECTS | BENCH_FLAG_PER_CALL },
+    { "command", "STATUS", CommandParser_Process, "STATUS", Bench_StatusSetup, Bench_RestoreSettings, 0 },
+    { "command", "SUBSCRIBE 100 FREQ,THRES", CommandParser_Process, "SUBSCRIBE 100 FREQ,THRES", NULL, Telemetry_UnsubscribeAll,
+      BENCH_FLAG_SIDE_EFFECTS | BENCH_FLAG_PER_CALL },
+    { "command", "UNSUBSCRIBE", Bench_Unsubscribe, NULL, Bench_SubscribeSetup, NULL, BENCH_FLAG_PER_CALL },
+    { "command", "unknown", CommandParser_Process, "FOO", NULL, NULL, 0 },
+    { "state", "UpdateCurrent", Bench_UpdateCurrent, NULL, NULL, NULL, 0 },
+    { "state", "CurrentBelowThreshold", Bench_Detect, NULL, NULL, NULL, 0 },
+    { "ina236", "ConvertCurrent", Bench_Ina236Convert, NULL, NULL, NULL, 0 },
+    { "ina236", "ReadCurrent", Bench_Ina236Read, NULL, NULL, NULL, 0 },
+    { "eeprom", "ReadVariable", Bench_EepromRead, NULL, NULL, NULL, 0 },
+    { "eeprom", "WriteVariable same", Bench_EepromWriteSame, NULL, NULL, NULL, 0 },
+    { "eeprom", "WriteVariable changed", Bench_EepromWriteChanged, NULL, NULL, Bench_EepromRestore, BENCH_FLAG_SIDE_EFFECTS },
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+// 插入排序，样本数很少
+static void Bench_Sort(uint32_t *samples, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        uint32_t v = samples[i];
+        uint8_t j = i;
+        while (j > 0 && samples[j - 1] > v) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = v;
+    }
+}
+
+// 测量一项：返回排序后的每批耗时（未扣除开销）
+static void Bench_Measure(const Bench_t *bench, BenchClock_t clock, uint16_t batch,
+                          uint32_t samples[BENCH_SAMPLES]) {
+    Json_SetMuted(true);
+    for (uint8_t s = 0; s < BENCH_SAMPLES; s++) {
+        if (bench->flags & BENCH_FLAG_PER_CALL) {
+            uint32_t total = 0;
+            for (uint16_t i = 0; i < batch; i++) {
+                if (bench->setup != NULL) bench->setup();
+                uint32_t start = clock();
+                bench->run(bench->arg);
+                total += clock() - start;
+                if (bench->teardown != NULL) bench->teardown();
+            }
+            samples[s] = total;
+            continue;
+        }
+        if (bench->setup != NULL) bench->setup();
+        uint32_t start = clock();
+        for (uint16_t i = 0; i < batch; i++) {
+            bench->run(bench->arg);
+        }
+        samples[s] = clock() - start;
+        if (bench->teardown != NULL) bench->teardown();
+    }
+    Json_SetMuted(false);
+    Bench_Sort(samples, BENCH_SAMPLES);
+}
+
+static uint32_t Bench_PerCall(uint32_t total, uint32_t overhead, uint16_t batch) {
+    return (total > overhead ? total - overhead : 0) / batch;
+}
+
+// 开始一轮测量：记录计时方式并测出计时开销（空函数按相同方式调用的最小耗时）
+void Bench_Begin(BenchClock_t clock, uint16_t batch, bool side_effects) {
+    static const Bench_t nop = { "", "", Bench_Nop, NULL, NULL, NULL, 0 };
+    static const Bench_t nop_per_call = { "", "", Bench_Nop, NULL, NULL, NULL, BENCH_FLAG_PER_CALL };
+    uint32_t samples[BENCH_SAMPLES];
+
+    bench_clock = clock;
+    bench_batch = batch > 0 ? batch : 1;
+    bench_side_effects = side_effects;
+    bench_next = 0;
+
+    Bench_Measure(&nop, bench_clock, bench_batch, samples);
+    bench_overhead = samples[0];
+    // 逐次计时时每次调用都有一次计时开销
+    Bench_Measure(&nop_per_call, bench_clock, bench_batch, samples);
+    bench_overhead_per_call = samples[0];
+}
+
+// 测量下一项，全部完成后返回false
+bool Bench_Next(BenchResult_t *result) {
+    const Bench_t *bench;
+    uint32_t samples[BENCH_SAMPLES];
+
+    if (bench_next >= BENCH_COUNT) {
+        return false;
+    }
+    bench = &benches[bench_next++];
+
+    result->group = bench->group;
+    result->name = bench->name;
+    result->skipped = (bench->flags & BENCH_FLAG_SIDE_EFFECTS) && !bench_side_effects;
+    result->min = 0;
+    result->median = 0;
+    result->max = 0;
+    if (!result->skipped) {
+        uint32_t overhead = (bench->flags & BENCH_FLAG_PER_CALL) ? bench_overhead_per_call : bench_overhead;
+        Bench_Measure(bench, bench_clock, bench_batch, samples);
+        result->min = Bench_PerCall(samples[0], overhead, bench_batch);
+        result->median = Bench_PerCall(samples[BENCH_SAMPLES / 2], overhead, bench_batch);
+        result->max = Bench_PerCall(samples[BENCH_SAMPLES - 1], overhead, bench_batch);
+    }
+    return true;
+}
+
+// {"Bench": "<group>", "Name": "<name>", "Unit": "<unit>", "Min": .., "Median": .., "Max": ..}
+void Bench_WriteResult(const BenchResult_t *result, const char *unit) {
+    Json_BeginObject();
+    Json_Key("Bench");
+    Json_String(result->group);
+    Json_Key("Name");
+    Json_String(result->name);
+    if (result->skipped) {
+        Json_Key("Skipped");
+        Json_Bool(true);
+    } else {
+        Json_Key("Unit");
+        Json_String(unit);
+        Json_Key("Min");
+        Json_Uint(result->min);
+        Json_Key("Median");
+        Json_Uint(result->median);
+        Json_Key("Max");
+        Json_Uint(result->max);
+    }
+    Json_End();
+}
@@ -0,0 +1,208 @@
+#include "binary_protocol.h"
+#include "cobs.h"
+#include "crc16.h"
+#include "param_registry.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "usbd_cdc_if.h"
+#include <string.h>
+
+_Static_assert(sizeof(((BinDataResponse_t *)0)->current) == sizeof(g_system_state.current_buffer),
+               "BinDataResponse_t must match the current buffer");
+
+// 编码并发送应答：0x00 | COBS(头 | 负载 | CRC16) | 0x00
+static void BinaryProtocol_Reply(const BinHeader_t *request, uint8_t status,
+                                 const void *payload, uint16_t payload_len) {
+    uint8_t message[BIN_MAX_MESSAGE];
+    uint8_t frame[COBS_MAX_ENCODED_SIZE(BIN_MAX_MESSAGE) + 2];
+    BinResponseHeader_t header;
+    uint16_t len;
+    uint16_t crc;
+    size_t frame_len;
+
+    header.opcode = request->opcode | BIN_RESPONSE_FLAG;
+    header.seq = request->seq;
+    header.status = status;
+    memcpy(message, &header, sizeof(header));
+    len = sizeof(header);
+    if (status == BIN_OK && payload_len > 0) {
+        memcpy(message + len, payload, payload_len);
+        len += payload_len;
+    }
+    crc = Crc16_Update(CRC16_INIT, message, len);
+    message[len++] = (uint8_t)crc;
+    message[len++] = (uint8_t)(crc >> 8);
+
+    frame[0] = 0x00;
+    frame_len = 1 + Cobs_Encode(message, len, frame + 1);
+    frame[frame_len++] = 0x00;
+    CDC_Write_FS(frame, (uint16_t)frame_len);
+}
+
+static uint8_t Bin_GetSet(const BinHeader_t *header, const uint8_t *body, uint16_t len,
+                          BinValueResponse_t *response) {
+    const Param_t *param;
+
+    if (header->opcode == BIN_OP_GET) {
+        BinGetRequest_t request;
+        if (len != sizeof(request)) return BIN_ERR_LENGTH;
+        memcpy(&request, body, sizeof(request));
+        param = ParamRegistry_FindById(request.param_id);
+        if (param == NULL || param->type == PARAM_I16_ARRAY) return BIN_ERR_PARAM;
+    } else {
+        BinSetRequest_t request;
+        if (len != sizeof(request)) return BIN_ERR_LENGTH;
+        memcpy(&request, body, sizeof(request));
+        param = ParamRegistry_FindById(request.param_id);
+        if (param == NULL || param->flags & PARAM_FLAG_READONLY) return BIN_ERR_PARAM;
+        if (!ParamRegistry_SetValue(param, request.value)) return BIN_ERR_REJECTED;
+    }
+
+    response->value = ParamRegistry_GetValue(param);
+    return BIN_OK;
+}
+
+static uint8_t Bin_Move(const uint8_t *body, uint16_t len) {
+    BinMoveRequest_t request;
+
+    if (len != sizeof(request)) return BIN_ERR_LENGTH;
+    memcpy(&request, body, sizeof(request));
+    if (request.dir != BIN_DIR_CW && request.dir != BIN_DIR_CCW) return BIN_ERR_REJECTED;
+    if (Homing_IsRunning() || SequenceController_IsRunning()) return BIN_ERR_REJECTED;
+    StepperMotor_Move(request.dir == BIN_DIR_CW ? MOTOR_DIR_CW : MOTOR_DIR_CCW, request.steps);
+    return BIN_OK;
+}
+
+static uint8_t Bin_Speed(const uint8_t *body, uint16_t len, BinSpeedRequest_t *response) {
+    BinSpeedRequest_t request;
+
+    if (len != sizeof(request)) return BIN_ERR_LENGTH;
+    memcpy(&request, body, sizeof(request));
+    if (request.ramp_mhz_per_s == BIN_RAMP_DEFAULT) {
+        request.ramp_mhz_per_s = g_system_state.ramp_mhz_per_s;
+    }
+    if (request.rate_mhz < STEPPER_RATE_MIN_MHZ || request.rate_mhz > STEPPER_RATE_MAX_MHZ ||
+        !StepperMotor_IsMoving() || Homing_IsRunning() || SequenceController_IsRunning()) {
+        return BIN_ERR_REJECTED;
+    }
+    StepperMotor_SetTargetRate(request.rate_mhz, request.ramp_mhz_per_s);
+    *response = request;
+    return BIN_OK;
+}
+
+static uint8_t Bin_Home(const uint8_t *body, uint16_t len) {
+    BinHomeRequest_t request;
+    MotorDirection_t dir = HOME_DEFAULT_DIR;
+
+    if (len != sizeof(request)) return BIN_ERR_LENGTH;
+    memcpy(&request, body, sizeof(request));
+    if (request.dir == BIN_DIR_CW) {
+        dir = MOTOR_DIR_CW;
+    } else if (request.dir == BIN_DIR_CCW) {
+        dir = MOTOR_DIR_CCW;
+    } else if (request.dir != BIN_DIR_DEFAULT) {
+        return BIN_ERR_REJECTED;
+    }
+    return Homing_Start(dir) ? BIN_OK : BIN_ERR_REJECTED;
+}
+
+static void Bin_Status(BinStatusResponse_t *response) {
+    uint16_t flags = 0;
+
+    if (g_system_state.switch_current)   flags |= BIN_STATUS_CURRENT;
+    if (g_system_state.switch_holdoff)   flags |= BIN_STATUS_HOLDOFF;
+    if (g_system_state.switch_division)  flags |= BIN_STATUS_DIVISION;
+    if (g_system_state.motor_moving)     flags |= BIN_STATUS_MOVING;
+    if (g_system_state.direction)        flags |= BIN_STATUS_DIRECTION;
+    if (g_system_state.zero_point)       flags |= BIN_STATUS_ZERO_POINT;
+    if (g_system_state.ina236_init_stat) flags |= BIN_STATUS_INA236_INIT;
+    if (g_system_state.ina236_read_stat) flags |= BIN_STATUS_INA236_READ;
+    if (g_system_state.stall_detected)   flags |= BIN_STATUS_STALLED;
+    if (g_system_state.pid_enabled)      flags |= BIN_STATUS_PID;
+
+    response->freq_mhz = g_system_state.freq_mhz;
+    response->rate_mhz = StepperMotor_GetRate();
+    response->position = StepperMotor_GetPosition();
+    response->threshold = g_system_state.threshold;
+    response->last_current =
+        g_system_state.current_buffer[(g_system_state.buffer_index + BUFFER_SIZE - 1) % BUFFER_SIZE];
+    response->flags = flags;
+    response->target_steps = g_system_state.target_steps;
+    response->current_steps = g_system_state.current_steps;
+    response->round_count = g_system_state.round_count;
+    response->seq_state = (uint8_t)SequenceController_GetState();
+    response->home_state = (uint8_t)Homing_GetState();
+}
+
+// 处理一个完整帧（已去除两端的0x00分隔符）
+void BinaryProtocol_ProcessFrame(const uint8_t *frame, uint16_t len) {
+    uint8_t message[BIN_MAX_FRAME];
+    BinHeader_t header = { 0, 0 };
+    size_t message_len;
+    union {
+        BinValueResponse_t value;
+        BinSpeedRequest_t speed;
+        BinStatusResponse_t status;
+        BinDataResponse_t data;
+    } response;
+    uint16_t response_len = 0;
+    uint8_t status;
+
+    message_len = Cobs_Decode(frame, len, message);
+    if (message_len >= sizeof(header)) {
+        memcpy(&header, message, sizeof(header));
+    }
+    if (message_len < sizeof(header) + 2 ||
+        Crc16_Update(CRC16_INIT, message, message_len - 2) !=
+            (uint16_t)(message[message_len - 2] | (message[message_len - 1] << 8))) {
+        BinaryProtocol_Reply(&header, BIN_ERR_CRC, NULL, 0);
+        return;
+    }
+
+    const uint8_t *body = message + sizeof(header);
+    uint16_t body_len = (uint16_t)(message_len - sizeof(header) - 2);
+
+    switch (header.opcode) {
+        case BIN_OP_GET:
+        case BIN_OP_SET:
+            status = Bin_GetSet(&header, body, body_len, &response.value);
+            response_len = sizeof(response.value);
+            break;
+        case BIN_OP_MOVE:
+            status = Bin_Move(body, body_len);
+            break;
+        case BIN_OP_SPEED:
+            status = Bin_Speed(body, body_len, &response.speed);
+            response_len = sizeof(response.speed);
+            break;
+        case BIN_OP_HOME:
+            status = Bin_Home(body, body_len);
+            break;
+        case BIN_OP_START:
+            status = body_len != 0 ? BIN_ERR_LENGTH :
+                     Homing_IsRunning() ? BIN_ERR_REJECTED : BIN_OK;
+            if (status == BIN_OK) SequenceController_Start();
+            break;
+        case BIN_OP_STATUS:
+            status = body_len != 0 ? BIN_ERR_LENGTH : BIN_OK;
+            Bin_Status(&response.status);
+            response_len = sizeof(response.status);
+            break;
+        case BIN_OP_SAVE:
+            status = body_len != 0 ? BIN_ERR_LENGTH : BIN_OK;
+            if (status == BIN_OK) SystemState_SaveToEEPROM();
+            break;
+        case BIN_OP_DATA:
+            status = body_len != 0 ? BIN_ERR_LENGTH : BIN_OK;
+            memcpy(response.data.current, g_system_state.current_buffer, sizeof(response.data.current));
+            response_len = sizeof(response.data);
+            break;
+        default:
+            status = BIN_ERR_OPCODE;
+            break;
+    }
+
+    BinaryProtocol_Reply(&header, status, &response, response_len);
+}
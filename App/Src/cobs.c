@@ -0,0 +1,47 @@
+#include "cobs.h"
+
+size_t Cobs_Encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t code_index = 0;   // 当前组长度码的位置
+    size_t out = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[code_index] = code;
+            code_index = out++;
+            code = 1;
+        } else {
+            dst[out++] = src[i];
+            code++;
+            if (code == 0xFF) {
+                // 满254个非零字节，开始新组
+                dst[code_index] = code;
+                code_index = out++;
+                code = 1;
+            }
+        }
+    }
+    dst[code_index] = code;
+    return out;
+}
+
+size_t Cobs_Decode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = src[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (src[in] == 0) return 0;
+            dst[out++] = src[in++];
+        }
+        // 长度码小于0xFF且不是最后一组时，代表一个0x00
+        if (code < 0xFF && in < len) {
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
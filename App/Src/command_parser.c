@@ -2,325 +2,566 @@
 #include "system_state.h"
 #include "stepper_motor.h"
 #include "sequence_controller.h"
+#include "homing.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "param_registry.h"
+#include "binary_protocol.h"
+#include "json_writer.h"
+#include "perf_monitor.h"
+#include "telemetry.h"
+#include "bench.h"
+#include "ring_buffer.h"
 #include "usbd_cdc_if.h"
 #include <string.h>
-#include <stdio.h>
 #include <stdlib.h>
 
 // 命令缓冲区
 static char cmd_buffer[MAX_CMD_LENGTH];
 static uint8_t cmd_index = 0;
+static bool cmd_overlong = false;
+static bool cmd_binary = false;   // 正在接收二进制帧
+static uint8_t frame_len = 0;
+
+// USB接收环形缓冲区：中断写入，主循环读取
+static uint8_t rx_storage[CMD_RX_BUFFER_SIZE];
+static RingBuffer_t rx_ring;
+static volatile bool rx_paused = false;
+
+// 每个USB包的到达时间（DWT周期数）和包末尾在接收缓冲区中的位置（不含）
+typedef struct {
+    uint16_t end;
+    uint32_t cycles;
+} RxStamp_t;
+
+static RxStamp_t rx_stamps[CMD_RX_STAMPS];
+static volatile uint16_t stamp_head = 0;
+static volatile uint16_t stamp_tail = 0;
+static uint32_t cmd_rx_cycles;    // 当前命令最后一个字节的到达时间
+
+// BENCH 进行中：每次 Poll 测量一项
+static bool bench_active = false;
+static bool bench_has_id;
+static uint32_t bench_id;
+static uint8_t bench_skipped;
+
+static void Command_BenchStep(void);
+
+// 命令最多参数个数（含命令名）
+#define MAX_CMD_ARGS 4
+
+// 命令处理函数：argv[0]为命令名，应答直接写入发送队列
+typedef void (*CommandHandler_t)(uint8_t argc, char *argv[]);
+
+typedef struct {
+    const char *name;
+    CommandHandler_t handler;
+} Command_t;
 
 void CommandParser_Init(void) {
     cmd_index = 0;
+    cmd_overlong = false;
+    cmd_binary = false;
     memset(cmd_buffer, 0, sizeof(cmd_buffer));
+    RingBuffer_Init(&rx_ring, rx_storage, sizeof(rx_storage));
+    rx_paused = false;
+    stamp_head = 0;
+    stamp_tail = 0;
+    ParamRegistry_Init();
 }
 
-void CommandParser_USBReceiveCallback(uint8_t *buf, uint32_t len) {
-    for (uint32_t i = 0; i < len; i++) {
-        if (buf[i] == '\n' || buf[i] == '\r') {
-            if (cmd_index > 0) {
-                cmd_buffer[cmd_index] = '\0';
-                CommandParser_Process(cmd_buffer);
-                cmd_index = 0;
-            }
-        } else if (cmd_index < MAX_CMD_LENGTH - 1) {
-            cmd_buffer[cmd_index++] = buf[i];
+bool CommandParser_USBReceiveCallback(uint8_t *buf, uint32_t len) {
+    // 中断中只做拷贝，解析和执行在主循环中完成
+    uint32_t now = PerfMonitor_CycleStart();
+    RingBuffer_Write(&rx_ring, buf, (uint16_t)len);
+
+    // 时间戳队列满时不记录，该包中的命令取下一个包的时间
+    if ((uint16_t)(stamp_head - stamp_tail) < CMD_RX_STAMPS) {
+        RxStamp_t *stamp = &rx_stamps[stamp_head & (CMD_RX_STAMPS - 1)];
+        stamp->end = rx_ring.head;
+        stamp->cycles = now;
+        __asm volatile("" ::: "memory");
+        stamp_head++;
+    }
+
+    if (RingBuffer_Free(&rx_ring) < CMD_RX_PACKET_SIZE) {
+        rx_paused = true;
+        return false;
+    }
+    return true;
+}
+
+// 查找接收缓冲区中 pos 处字节所在USB包的到达时间
+static uint32_t CommandParser_RxCycles(uint16_t pos) {
+    while (stamp_tail != stamp_head) {
+        __asm volatile("" ::: "memory");
+        const RxStamp_t *stamp = &rx_stamps[stamp_tail & (CMD_RX_STAMPS - 1)];
+        if ((int16_t)(stamp->end - pos) > 0) {
+            return stamp->cycles;
         }
+        stamp_tail++;
     }
+    return PerfMonitor_CycleStart();
 }
 
-void CommandParser_Process(const char *cmd) {
-    char response[256] = {0};
-    
-    // 解析命令类型
-    if (strncmp(cmd, "SET ", 4) == 0) {
-        // SET命令处理
-        char key[16] = {0};
-        char value[32] = {0};
-        
-        if (sscanf(cmd + 4, "%s %s", key, value) == 2) {
-            bool success = true;
-            char value_str[32] = {0};
-            snprintf(value_str, sizeof(value_str), "%s", value);
-            if (strcmp(key, "FREQ") == 0) {
-                uint16_t freq = atoi(value);
-                if (freq >= 0 && freq <= 1000) {
-                    g_system_state.freq = freq;
-                } else {
-                    success = false;
-                }
-            } 
-            else if (strcmp(key, "THRES") == 0) {
-                int16_t thres = atoi(value);
-                g_system_state.threshold = thres;
-            }
-            else if (strcmp(key, "CURRENT") == 0) {
-                if (strcmp(value, "ON") == 0) {
-                    g_system_state.switch_current = true;
-                    snprintf(value_str, sizeof(value_str), "true");
-                    HAL_GPIO_WritePin(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin, GPIO_PIN_SET);
-                } else if (strcmp(value, "OFF") == 0) {
-                    g_system_state.switch_current = false;
-                    snprintf(value_str, sizeof(value_str), "false");
-                    HAL_GPIO_WritePin(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin, GPIO_PIN_RESET);
-                } else {
-                    success = false;
-                }
-            }
-            else if (strcmp(key, "HOLDOFF") == 0) {
-                if (strcmp(value, "ON") == 0) {
-                    g_system_state.switch_holdoff = true;
-                    snprintf(value_str, sizeof(value_str), "true");
-                    StepperMotor_UpdateSwitches(g_system_state.switch_holdoff, g_system_state.switch_division);
-                } else if (strcmp(value, "OFF") == 0) {
-                    g_system_state.switch_holdoff = false;
-                    snprintf(value_str, sizeof(value_str), "false");
-                    StepperMotor_UpdateSwitches(g_system_state.switch_holdoff, g_system_state.switch_division);
-                } else {
-                    success = false;
-                }
-            }
-            else if (strcmp(key, "DIVISION") == 0) {
-                if (strcmp(value, "ON") == 0) {
-                    g_system_state.switch_division = true;
-                    snprintf(value_str, sizeof(value_str), "true");
-                    StepperMotor_UpdateSwitches(g_system_state.switch_holdoff, true);
-                } else if (strcmp(value, "OFF") == 0) {
-                    g_system_state.switch_division = false;
-                    snprintf(value_str, sizeof(value_str), "false");
-                    StepperMotor_UpdateSwitches(g_system_state.switch_holdoff, false);
-                } else {
-                    success = false;
-                }
-            }
-            else if (strcmp(key, "ROUND") == 0)
-            {
-                SystemState_ResetRoundCount();
-                snprintf(value_str, sizeof(value_str), "0");
-            }
-            else if (strcmp(key, "LEVEL") == 0)
-            {
-                uint8_t level = atoi(value);
-                if (level <= 3) {
-                    g_system_state.debug_level = level;
-                } else {
-                    success = false;
-                }
-            }
-            else if (strcmp(key, "DEBUG") == 0)
-            {
-                if (strcmp(value, "ON") == 0) {
-                    g_system_state.debug_enabled = true;
-                    snprintf(value_str, sizeof(value_str), "true");
-                } else if (strcmp(value, "OFF") == 0) {
-                    g_system_state.debug_enabled = false;
-                    snprintf(value_str, sizeof(value_str), "false");
-                } else {
-                    success = false;
-                }
-            }
-            else {
-                success = false;
-            }
-            
-            // 发送响应
-            if (success) {
-                snprintf(response, sizeof(response), 
-                        "{\"Cmd\": \"SET\", \"Status\": \"Success\", \"Parameter\": \"%s\", \"Value\": %s}\r\n",
-                        key, value_str);
+// 主循环中调用：组装命令行或二进制帧，每次最多执行一条命令，
+// 使电流采样和截止判断不会被连续的命令阻塞
+void CommandParser_Poll(void) {
+    uint8_t byte;
+    bool line_ready = false;
+    bool frame_ready = false;
+
+    // 发送队列放不下应答时，命令留在接收缓冲区中排队，缓冲区满后由端点NAK限制主机
+    if (!CDC_TxReady_FS(CMD_TX_RESERVE)) {
+        return;
+    }
+
+    if (bench_active) {
+        Command_BenchStep();
+        return;
+    }
+
+    while (!line_ready && !frame_ready && RingBuffer_Get(&rx_ring, &byte)) {
+        if (byte == 0x00) {
+            // 二进制帧分隔符：结束当前帧，或丢弃未完成的ASCII行并开始接收帧
+            if (cmd_binary && cmd_index > 0) {
+                frame_ready = !cmd_overlong;
+                cmd_binary = false;
             } else {
-                snprintf(response, sizeof(response), 
-                        "{\"Cmd\": \"SET\", \"Status\": \"Error\", \"Parameter\": \"%s\", \"Value\": %s}\r\n",
-                        key, value_str);
+                cmd_binary = true;
             }
-        }
-    }
-    else if (strncmp(cmd, "GET ", 4) == 0) {
-        // GET命令处理
-        char key[16] = {0};
-        sscanf(cmd + 4, "%s", key);
-        
-        char value_str[64] = {0};
-        bool success = true;
-        
-        if (strcmp(key, "FREQ") == 0) {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.freq);
-        }
-        else if (strcmp(key, "THRES") == 0) {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.threshold);
-        }
-        else if (strcmp(key, "CURRENT") == 0) {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.switch_current ? "true" : "false");
-        }
-        else if (strcmp(key, "HOLDOFF") == 0) {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.switch_holdoff ? "true" : "false");
-        }
-        else if (strcmp(key, "DIVISION") == 0) {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.switch_division ? "true" : "false");
-        }
-        else if (strcmp(key, "ZEROPOINT") == 0) {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.zero_point ? "true" : "false");
-        }
-        else if (strcmp(key, "ROUND") == 0) {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.round_count);
-        }
-        else if (strcmp(key, "MOVING") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.motor_moving ? "true" : "false");
-        }
-        else if (strcmp(key, "DIRECTION") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.direction ? "true" : "false");
-        }
-        else if (strcmp(key, "TARGETSTEP") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.target_steps);
-        }
-        else if (strcmp(key, "CURRENTSTEP") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.current_steps);
-        }
-        else if (strcmp(key, "INA236INIT") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.ina236_init_stat ? "true" : "false");
-        }
-        else if (strcmp(key, "INA236READ") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%s", 
-                    g_system_state.ina236_read_stat ? "true" : "false");
-        }
-        else if (strcmp(key, "DATA") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "[");
-            for (int i = 0; i < BUFFER_SIZE; i++) {
-                char temp[8];
-                snprintf(temp, sizeof(temp), "%d", g_system_state.current_buffer[i]);
-                strcat(value_str, temp);
-                
-                if (i < BUFFER_SIZE - 1) {
-                    strcat(value_str, ", ");
-                }
+            frame_len = cmd_index;
+            cmd_index = 0;
+            cmd_overlong = false;
+        } else if (!cmd_binary && (byte == '\n' || byte == '\r')) {
+            if (cmd_index > 0 && !cmd_overlong) {
+                cmd_buffer[cmd_index] = '\0';
+                line_ready = true;
             }
-            strcat(value_str, "]");
-        }
-        else if (strcmp(key, "LEVEL") == 0)
-        {
-            snprintf(value_str, sizeof(value_str), "%d", g_system_state.debug_level);
-        }
-        else {
-            success = false;
-        }
-        
-        if (success) {
-            snprintf(response, sizeof(response), 
-                    "{\"Cmd\": \"GET\", \"Status\": \"Success\", \"Parameter\": \"%s\", \"Value\": %s}\r\n",
-                    key, value_str);
+            cmd_index = 0;
+            cmd_overlong = false;
+        } else if (cmd_index < (cmd_binary ? BIN_MAX_FRAME : MAX_CMD_LENGTH - 1)) {
+            cmd_buffer[cmd_index++] = byte;
         } else {
-            snprintf(response, sizeof(response), 
-                    "{\"Cmd\": \"GET\", \"Status\": \"Error\", \"Parameter\": \"%s\"}\r\n",
-                    key);
+            // 超长命令整行丢弃，避免截断后被误执行；
+            // 超长帧视为误入二进制模式，回到ASCII并丢弃到行尾
+            cmd_overlong = true;
+            cmd_binary = false;
         }
     }
-    else if (strncmp(cmd, "MOVE ", 5) == 0) {
-        // MOVE命令处理
-        char dir[8] = {0};
-        int steps = 0;
-        
-        if (sscanf(cmd + 5, "%s %d", dir, &steps) == 2) {
-            if (strcmp(dir, "CW") == 0) {
-                StepperMotor_Move(MOTOR_DIR_CW, steps);
-                snprintf(response, sizeof(response), 
-                        "{\"Cmd\": \"MOVE\", \"Status\": \"Success\", \"Direction\": \"CW\", \"Step\": %d}\r\n",
-                        steps);
-            }
-            else if (strcmp(dir, "CCW") == 0) {
-                StepperMotor_Move(MOTOR_DIR_CCW, steps);
-                snprintf(response, sizeof(response), 
-                        "{\"Cmd\": \"MOVE\", \"Status\": \"Success\", \"Direction\": \"CCW\", \"Step\": %d}\r\n",
-                        steps);
-            }
-            else {
-                snprintf(response, sizeof(response), 
-                        "{\"Cmd\": \"MOVE\", \"Status\": \"Error\", \"Direction\": \"%s\", \"Step\": %d}\r\n",
-                        dir, steps);
-            }
+
+    // 缓冲区腾出空间后恢复接收（暂停期间端点回NAK，不会再进入接收中断）
+    if (rx_paused && RingBuffer_Free(&rx_ring) >= CMD_RX_PACKET_SIZE) {
+        rx_paused = false;
+        CDC_ResumeReceive_FS();
+    }
+
+    if (line_ready || frame_ready) {
+        uint32_t start = PerfMonitor_CycleStart();
+        cmd_rx_cycles = CommandParser_RxCycles((uint16_t)(rx_ring.tail - 1));
+        if (line_ready) {
+            CommandParser_Process(cmd_buffer);
         } else {
-            snprintf(response, sizeof(response), 
-                    "{\"Cmd\": \"MOVE\", \"Status\": \"Error\"}\r\n");
+            BinaryProtocol_ProcessFrame((const uint8_t *)cmd_buffer, frame_len);
         }
+        PerfMonitor_CommandDone(start);
+    }
+}
+
+static void Command_Set(uint8_t argc, char *argv[]) {
+    if (argc < 3) {
+        Json_Begin("SET", false);
+        Json_End();
+        return;
+    }
+
+    const Param_t *param = ParamRegistry_Find(argv[1]);
+    bool success = param != NULL && ParamRegistry_Set(param, argv[2]);
+
+    Json_Begin("SET", success);
+    Json_Key("Parameter");
+    Json_String(argv[1]);
+    Json_Key("Value");
+    if (success) {
+        // 返回实际生效的值
+        ParamRegistry_WriteValue(param);
+    } else {
+        Json_Raw(argv[2]);
+    }
+    Json_End();
+}
+
+static void Command_Get(uint8_t argc, char *argv[]) {
+    const char *key = argc >= 2 ? argv[1] : "";
+    const Param_t *param = ParamRegistry_Find(key);
+
+    Json_Begin("GET", param != NULL);
+    Json_Key("Parameter");
+    Json_String(key);
+    if (param != NULL) {
+        Json_Key("Value");
+        ParamRegistry_WriteValue(param);
+    }
+    Json_End();
+}
+
+static void Command_Move(uint8_t argc, char *argv[]) {
+    int32_t steps;
+
+    if (argc < 3 || !ParamRegistry_ParseInt(argv[2], &steps)) {
+        Json_Begin("MOVE", false);
+        Json_End();
+        return;
+    }
+
+    // 步数为 uint16_t，超出范围时拒绝，不截断；回零或序列运行中不允许手动运动
+    bool cw = strcmp(argv[1], "CW") == 0;
+    bool success = (cw || strcmp(argv[1], "CCW") == 0) && steps >= 0 && steps <= UINT16_MAX &&
+                   !Homing_IsRunning() && !SequenceController_IsRunning();
+    if (success) {
+        StepperMotor_Move(cw ? MOTOR_DIR_CW : MOTOR_DIR_CCW, (uint16_t)steps);
+    }
+
+    Json_Begin("MOVE", success);
+    Json_Key("Direction");
+    Json_String(argv[1]);
+    Json_Key("Step");
+    Json_Int(steps);
+    Json_End();
+}
+
+// 运动中实时调速，可选指定斜率；回零和序列的速率由其自身控制，不允许修改
+static void Command_Speed(uint8_t argc, char *argv[]) {
+    uint32_t rate_mhz;
+    uint32_t ramp_mhz_per_s = g_system_state.ramp_mhz_per_s;
+
+    if (argc >= 2 && ParamRegistry_ParseMilli(argv[1], &rate_mhz) &&
+        rate_mhz >= STEPPER_RATE_MIN_MHZ && rate_mhz <= STEPPER_RATE_MAX_MHZ &&
+        (argc < 3 || ParamRegistry_ParseMilli(argv[2], &ramp_mhz_per_s)) &&
+        StepperMotor_IsMoving() && !Homing_IsRunning() && !SequenceController_IsRunning()) {
+        StepperMotor_SetTargetRate(rate_mhz, ramp_mhz_per_s);
+        Json_Begin("SPEED", true);
+        Json_Key("Value");
+        Json_Milli(rate_mhz);
+        Json_Key("Ramp");
+        Json_Milli(ramp_mhz_per_s);
+    } else {
+        Json_Begin("SPEED", false);
+        Json_Key("Moving");
+        Json_Bool(StepperMotor_IsMoving());
     }
-    else if (strcmp(cmd, "START") == 0) {
-        // START命令处理
+    Json_End();
+}
+
+// 快速接近、回退、慢速接近原点
+static void Command_Home(uint8_t argc, char *argv[]) {
+    MotorDirection_t dir = HOME_DEFAULT_DIR;
+    bool valid = true;
+
+    if (argc == 2 && strcmp(argv[1], "CW") == 0) {
+        dir = MOTOR_DIR_CW;
+    } else if (argc == 2 && strcmp(argv[1], "CCW") == 0) {
+        dir = MOTOR_DIR_CCW;
+    } else if (argc != 1) {
+        valid = false;
+    }
+
+    if (valid && Homing_Start(dir)) {
+        Json_Begin("HOME", true);
+        Json_Key("Direction");
+        Json_String(dir == MOTOR_DIR_CW ? "CW" : "CCW");
+    } else {
+        Json_Begin("HOME", false);
+    }
+    Json_End();
+}
+
+// 回零过程中不允许启动序列
+static void Command_Start(uint8_t argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    if (Homing_IsRunning()) {
+        Json_Begin("START", false);
+    } else {
         SequenceController_Start();
-        snprintf(response, sizeof(response), 
-                "{\"Cmd\": \"START\", \"Status\": \"Success\"}\r\n");
+        Json_Begin("START", true);
     }
-    else if (strcmp(cmd, "STATUS") == 0) {
-        // STATUS命令处理
-        if (g_system_state.debug_level >= 0 && g_system_state.debug_level <= 3) {
-            // Level 0: 基本输出
-            snprintf(response, sizeof(response), 
-                    "{\"Cmd\": \"STATUS\", \"Status\": \"Success\", \"LEVEL\": %d", g_system_state.debug_level);
-            
-            char temp[256];
-
-            if (g_system_state.debug_level == 1){ // Level 1: 用户可设置的5个参数
-                snprintf(temp, sizeof(temp), 
-                        ", \"FREQ\": %d, \"THRES\": %d, \"CURRENT\": %s, "
-                        "\"HOLDOFF\": %s, \"DIVISION\": %s",
-                        g_system_state.freq, g_system_state.threshold,
-                        g_system_state.switch_current ? "true" : "false",
-                        g_system_state.switch_holdoff ? "true" : "false",
-                        g_system_state.switch_division ? "true" : "false");
-                strcat(response, temp);
-            }            
-            else if (g_system_state.debug_level == 2) { // Level 2: 添加电流数据和INA236状态
-                snprintf(temp, sizeof(temp), 
-                        ", \"LASTDATA\": %d, \"INA236INIT\": %s, \"INA236READ\": %s",
-                        g_system_state.current_buffer[(g_system_state.buffer_index + BUFFER_SIZE - 1) % BUFFER_SIZE],
-                        g_system_state.ina236_init_stat ? "true" : "false",
-                        g_system_state.ina236_read_stat ? "true" : "false");
-                strcat(response, temp);
-            }
-            else if (g_system_state.debug_level == 3) { // Level 3: 添加运动状态信息
-                snprintf(temp, sizeof(temp), 
-                        ", \"MOVING\": %s, \"DIRECTION\": %s, \"TARGET\": %d, \"CURRENTSTEP\": %d, "
-                        "\"ROUND\": %d, \"ZeroPoint\": %s, \"SQSTATE\": %d",
-                        g_system_state.motor_moving ? "true" : "false",
-                        g_system_state.direction ? "true" : "false",
-                        g_system_state.target_steps, g_system_state.current_steps,
-                        g_system_state.round_count,
-                        g_system_state.zero_point ? "true" : "false",
-                        SequenceController_GetState());
-                strcat(response, temp);
-            }
-            
-            strcat(response, "}\r\n");
+    Json_End();
+}
+
+// 输出当前LEVEL对应的参数组（见参数表中的status_level）
+static void Command_Status(uint8_t argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    if (g_system_state.debug_level <= 3) {
+        Json_Begin("STATUS", true);
+        Json_Key("LEVEL");
+        Json_Uint(g_system_state.debug_level);
+        ParamRegistry_WriteStatus(g_system_state.debug_level);
+    } else {
+        Json_Begin("STATUS", false);
+        Json_Key("Level");
+        Json_Uint(g_system_state.debug_level);
+    }
+    Json_End();
+}
+
+static void Command_Save(uint8_t argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    SystemState_SaveToEEPROM();
+    Json_Begin("SAVE", true);
+    Json_End();
+}
+
+// PING <nonce>：返回命令最后一个字节到达和应答写入发送队列时的DWT周期数
+static void Command_Ping(uint8_t argc, char *argv[]) {
+    int32_t nonce;
+
+    if (argc < 2 || !ParamRegistry_ParseInt(argv[1], &nonce) || nonce < 0) {
+        Json_Begin("PING", false);
+        Json_End();
+        return;
+    }
+
+    Json_Begin("PING", true);
+    Json_Key("Nonce");
+    Json_Uint((uint32_t)nonce);
+    Json_Key("Mhz");
+    Json_Uint(SystemCoreClock / 1000000);
+    Json_Key("Rx");
+    Json_Uint(cmd_rx_cycles);
+    Json_Key("Tx");
+    Json_Uint(PerfMonitor_CycleStart());
+    Json_End();
+}
+
+// SUBSCRIBE <周期ms> <字段1,字段2,...>：按周期推送参数
+static void Command_Subscribe(uint8_t argc, char *argv[]) {
+    const Param_t *fields[TELEMETRY_MAX_FIELDS];
+    uint8_t count = 0;
+    int32_t period_ms;
+    int8_t id = -1;
+    char *field = argc >= 3 ? argv[2] : NULL;
+    const char *bad_field = NULL;
+
+    // 按逗号原地切分字段列表
+    while (field != NULL && bad_field == NULL) {
+        char *next = strchr(field, ',');
+        if (next != NULL) *next++ = '\0';
+
+        const Param_t *param = ParamRegistry_Find(field);
+        if (param == NULL || count >= TELEMETRY_MAX_FIELDS) {
+            bad_field = field;
         } else {
-            snprintf(response, sizeof(response), 
-                    "{\"Cmd\": \"STATUS\", \"Status\": \"Error\", \"Level\": %d}\r\n", g_system_state.debug_level);
+            fields[count++] = param;
+        }
+        field = next;
+    }
+
+    if (count > 0 && bad_field == NULL &&
+        ParamRegistry_ParseInt(argv[1], &period_ms) &&
+        period_ms >= TELEMETRY_MIN_PERIOD_MS && period_ms <= TELEMETRY_MAX_PERIOD_MS) {
+        id = Telemetry_Subscribe((uint32_t)period_ms, fields, count);
+    }
+
+    Json_Begin("SUBSCRIBE", id >= 0);
+    if (id >= 0) {
+        Json_Key("Telemetry");
+        Json_Uint((uint32_t)id);
+    } else if (bad_field != NULL) {
+        Json_Key("Field");
+        Json_String(bad_field);
+    }
+    Json_End();
+}
+
+// UNSUBSCRIBE <编号|ALL>
+static void Command_Unsubscribe(uint8_t argc, char *argv[]) {
+    int32_t id;
+    bool success = false;
+
+    if (argc >= 2 && strcmp(argv[1], "ALL") == 0) {
+        Telemetry_UnsubscribeAll();
+        success = true;
+    } else if (argc >= 2 && ParamRegistry_ParseInt(argv[1], &id) && id >= 0 && id <= 255) {
+        success = Telemetry_Unsubscribe((uint8_t)id);
+    }
+
+    Json_Begin("UNSUBSCRIBE", success);
+    Json_End();
+}
+
+// BENCH：运行热点路径微基准（DWT周期数），有副作用的项跳过；运动中不允许。
+// 测量在之后的 CommandParser_Poll 中逐项进行，每项输出一行，期间不处理新命令。
+static void Command_Bench(uint8_t argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    if (StepperMotor_IsMoving() || Homing_IsRunning() ||
+        SequenceController_GetState() != SEQ_IDLE) {
+        Json_Begin("BENCH", false);
+        Json_Key("Moving");
+        Json_Bool(true);
+        Json_End();
+        return;
+    }
+
+    // 请求编号留给最终应答
+    bench_has_id = Json_GetRequestId(&bench_id);
+    bench_skipped = 0;
+    bench_active = true;
+    Bench_Begin(PerfMonitor_CycleStart, 1, false);
+}
+
+static void Command_BenchStep(void) {
+    BenchResult_t result;
+
+    if (Bench_Next(&result)) {
+        if (result.skipped) bench_skipped++;
+        Bench_WriteResult(&result, "cycles");
+        return;
+    }
+
+    bench_active = false;
+    Json_SetRequestId(bench_has_id, bench_id);
+    Json_Begin("BENCH", true);
+    Json_Key("Skipped");
+    Json_Uint(bench_skipped);
+    Json_End();
+    Json_SetRequestId(false, 0);
+}
+
+// 命令表：必须按名称字母顺序（strcmp）排列，查找使用二分法
+static const Command_t commands[] = {
+    { "BENCH",  Command_Bench },
+    { "GET",    Command_Get },
+    { "HOME",   Command_Home },
+    { "MOVE",   Command_Move },
+    { "PING",   Command_Ping },
+    { "SAVE",   Command_Save },
+    { "SET",    Command_Set },
+    { "SPEED",  Command_Speed },
+    { "START",  Command_Start },
+    { "STATUS", Command_Status },
+    { "SUBSCRIBE", Command_Subscribe },
+    { "UNSUBSCRIBE", Command_Unsubscribe },
+};
+
+static int Command_Compare(const void *key, const void *elem) {
+    return strcmp((const char *)key, ((const Command_t *)elem)->name);
+}
+
+// 按空格原地切分命令行，返回参数个数（多余的参数被忽略）
+static uint8_t Command_Tokenize(char *line, char *argv[], uint8_t max_args) {
+    uint8_t argc = 0;
+
+    while (*line != '\0' && argc < max_args) {
+        while (*line == ' ') line++;
+        if (*line == '\0') break;
+        argv[argc++] = line;
+        while (*line != ' ' && *line != '\0') line++;
+        if (*line == ' ') *line++ = '\0';
+    }
+    return argc;
+}
+
+// SET A 1;SET B 2;...：全部解析和校验通过后一次性写入，任一条无效则都不写入
+static void Command_Batch(char *body) {
+    const Param_t *params[PARAM_BATCH_MAX];
+    int32_t values[PARAM_BATCH_MAX];
+    char *argv[MAX_CMD_ARGS];
+    uint8_t argc = 0;
+    uint8_t count = 0;
+    char *segment = body;
+    bool valid = true;
+
+    while (segment != NULL && valid) {
+        char *next = strchr(segment, ';');
+        if (next != NULL) *next++ = '\0';
+
+        argc = Command_Tokenize(segment, argv, MAX_CMD_ARGS);
+        segment = next;
+        if (argc == 0) continue;  // 忽略空段，如末尾的分号
+
+        valid = count < PARAM_BATCH_MAX && argc == 3 && strcmp(argv[0], "SET") == 0 &&
+                (params[count] = ParamRegistry_Find(argv[1])) != NULL &&
+                ParamRegistry_Parse(params[count], argv[2], &values[count]);
+        if (valid) count++;
+    }
+
+    if (!valid || count == 0) {
+        Json_Begin("BATCH", false);
+        Json_Key("Index");
+        Json_Uint(count);
+        if (!valid && argc >= 2) {
+            Json_Key("Parameter");
+            Json_String(argv[1]);
+        }
+        if (!valid && argc >= 3) {
+            Json_Key("Value");
+            Json_String(argv[2]);
         }
+        Json_End();
+        return;
     }
-    else if (strcmp(cmd, "SAVE") == 0)
-    {
-        SystemState_SaveToEEPROM();
-        snprintf(response, sizeof(response), 
-                "{\"Cmd\": \"SAVE\", \"Status\": \"Success\"}\r\n");
+
+    ParamRegistry_SetBatch(params, values, count);
+
+    Json_Begin("BATCH", true);
+    Json_Key("Count");
+    Json_Uint(count);
+    for (uint8_t i = 0; i < count; i++) {
+        Json_Key(params[i]->name);
+        ParamRegistry_WriteValue(params[i]);
     }
-    else {
-        // 未知命令
-        snprintf(response, sizeof(response), 
-                "{\"Cmd\": \"UNKNOWN\", \"Status\": \"Error\", \"Message\": \"Unknown command\"}\r\n");
+    Json_End();
+}
+
+void CommandParser_Process(const char *cmd) {
+    char line[MAX_CMD_LENGTH];
+    char *argv[MAX_CMD_ARGS];
+    char *body = line;
+    uint8_t argc;
+    const Command_t *command = NULL;
+    bool id_valid = true;
+
+    strncpy(line, cmd, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+
+    // 可选的请求编号前缀 #<id>，在应答中以 "Id" 原样返回
+    while (*body == ' ') body++;
+    if (*body == '#') {
+        char *id_str = body + 1;
+        int32_t id = 0;
+
+        body = strchr(id_str, ' ');
+        if (body != NULL) {
+            *body++ = '\0';
+        } else {
+            body = id_str + strlen(id_str);
+        }
+        id_valid = ParamRegistry_ParseInt(id_str, &id) && id >= 0;
+        Json_SetRequestId(id_valid, (uint32_t)id);
     }
-    
-    // 发送响应
-    CDC_Transmit_FS((uint8_t*)response, strlen(response));
-}
\ No newline at end of file
+
+    if (id_valid && strchr(body, ';') != NULL) {
+        Command_Batch(body);
+    } else {
+        argc = Command_Tokenize(body, argv, MAX_CMD_ARGS);
+        if (argc > 0 && id_valid) {
+            command = bsearch(argv[0], commands, sizeof(commands) / sizeof(commands[0]),
+                              sizeof(Command_t), Command_Compare);
+        }
+
+        if (command != NULL) {
+            command->handler(argc, argv);
+        } else {
+            // 未知命令或无效的请求编号
+            Json_Begin("UNKNOWN", false);
+            Json_Key("Message");
+            Json_String(id_valid ? "Unknown command" : "Invalid request id");
+            Json_End();
+        }
+    }
+    Json_SetRequestId(false, 0);
+}
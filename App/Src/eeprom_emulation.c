@@ -1,5 +1,6 @@
 #include "eeprom_emulation.h"
 #include "stm32f1xx_hal.h"
+#include <stdbool.h>
 
 // Flash配置
 #define FLASH_PAGE_SIZE    1024
@@ -34,6 +35,7 @@ uint16_t EE_ReadVariable(uint16_t virt_address, uint32_t* data) {
     return 0; // 成功
 }
 
+// 写入单个变量；需要改写已编程的字时擦除整页，页内其他变量随之丢失
 uint16_t EE_WriteVariable(uint16_t virt_address, uint32_t data) {
     FLASH_EraseInitTypeDef erase_init;
     uint32_t page_error;
@@ -67,4 +69,48 @@ uint16_t EE_WriteVariable(uint16_t virt_address, uint32_t data) {
     }
     
     return 0; // 成功
-}
\ No newline at end of file
+}
+
+// 一次写入一组变量，整页最多擦除一次：任一变量需要改写已编程的字时先擦除，
+// 再写入全部变量；否则只写入仍为空的变量。擦除后不在本组中的变量丢失。
+uint16_t EE_WriteVariables(const uint16_t virt_address[], const uint32_t data[], uint8_t count) {
+    FLASH_EraseInitTypeDef erase_init;
+    uint32_t page_error;
+    bool erase = false;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t address = VIRTUAL_ADDR_TO_PHYSICAL(virt_address[i]);
+        uint32_t current;
+
+        if (address >= EEPROM_START_ADDRESS + EEPROM_SIZE) {
+            return 1; // 错误：地址超出范围
+        }
+        current = *(__IO uint32_t*)address;
+        if (current != data[i] && current != 0xFFFFFFFF) {
+            erase = true;
+        }
+    }
+
+    if (erase) {
+        erase_init.TypeErase = FLASH_TYPEERASE_PAGES;
+        erase_init.PageAddress = EEPROM_START_ADDRESS;
+        erase_init.NbPages = 1;
+
+        if (HAL_FLASHEx_Erase(&erase_init, &page_error) != HAL_OK) {
+            return 3; // 错误：擦除失败
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t address = VIRTUAL_ADDR_TO_PHYSICAL(virt_address[i]);
+
+        if (*(__IO uint32_t*)address == data[i]) {
+            continue;
+        }
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, data[i]) != HAL_OK) {
+            return 4; // 错误：写入失败
+        }
+    }
+
+    return 0; // 成功
+}
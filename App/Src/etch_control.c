@@ -0,0 +1,72 @@
+#include "etch_control.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+#include "hal_instances.h"
+#include "arm_math.h"
+
+// 闭环恒电流提拉：按采样率以定点PID调节步进速率
+static arm_pid_instance_q15 pid;
+static bool pid_running = false;
+
+void EtchControl_Init(void) {
+    pid_running = false;
+}
+
+// 重新开始闭环（参数修改后或序列重新进入提拉阶段）
+void EtchControl_Reset(void) {
+    pid_running = false;
+}
+
+// 将Q15输出映射到 [pid_min_mhz, pid_max_mhz]
+static uint32_t EtchControl_OutputToRate(q15_t out) {
+    uint32_t span = g_system_state.pid_max_mhz - g_system_state.pid_min_mhz;
+    return g_system_state.pid_min_mhz +
+           (uint32_t)(((uint64_t)((int32_t)out + 32768) * span) >> 16);
+}
+
+// 启动PID：以当前提拉速率初始化输出，实现无扰切换
+static void EtchControl_Start(void) {
+    uint32_t span = g_system_state.pid_max_mhz - g_system_state.pid_min_mhz;
+    uint32_t rate = StepperMotor_IsMoving() ? StepperMotor_GetRate() : g_system_state.freq_mhz;
+    int32_t out;
+
+    pid.Kp = g_system_state.pid_kp;
+    pid.Ki = g_system_state.pid_ki;
+    pid.Kd = g_system_state.pid_kd;
+    arm_pid_init_q15(&pid, 1);
+
+    if (rate < g_system_state.pid_min_mhz) rate = g_system_state.pid_min_mhz;
+    if (rate > g_system_state.pid_max_mhz) rate = g_system_state.pid_max_mhz;
+    out = (span == 0) ? 0 :
+          (int32_t)(((uint64_t)(rate - g_system_state.pid_min_mhz) << 16) / span) - 32768;
+    if (out > 32767) out = 32767;
+    pid.state[2] = (q15_t)out;
+
+    pid_running = true;
+}
+
+// 每个电流采样调用一次
+void EtchControl_Sample(int16_t current) {
+    if (!g_system_state.pid_enabled ||
+        SequenceController_GetState() != SEQ_MONITOR_CURRENT ||
+        g_system_state.pid_max_mhz <= g_system_state.pid_min_mhz) {
+        pid_running = false;
+        return;
+    }
+
+    if (!pid_running) {
+        EtchControl_Start();
+    }
+
+    // 误差：电流高于目标时加快提拉，减少浸入长度
+    int32_t error = ((int32_t)current - g_system_state.pid_target) *
+                    (32768 / PID_CURRENT_FULL_SCALE_UA);
+    if (error > 32767) error = 32767;
+    if (error < -32768) error = -32768;
+
+    q15_t out = arm_pid_q15(&pid, (q15_t)error);
+
+    // 直接在下一个脉冲周期生效
+    StepperMotor_SetTargetRate(EtchControl_OutputToRate(out), 0);
+}
@@ -0,0 +1,77 @@
+#include "event_queue.h"
+#include "json_writer.h"
+#include "usbd_cdc_if.h"
+#include "main.h"
+
+// 事件记录
+typedef struct {
+    uint32_t tick;
+    int32_t value;
+    EventType_t type;
+} Event_t;
+
+static const char *const event_names[EVENT_TYPE_COUNT] = {
+    "CUTOFF",
+    "MOVE_DONE",
+    "SEQ_STATE",
+    "ZERO_EDGE",
+    "I2C_FAULT",
+    "STALL",
+    "HOMED",
+};
+
+uint8_t event_enable_mask = 0;
+uint32_t event_dropped = 0;
+
+// 多个中断和主循环都会写入，入队时短暂关中断；只有主循环读取
+static Event_t events[EVENT_QUEUE_SIZE];
+static volatile uint16_t event_head;
+static volatile uint16_t event_tail;
+
+void EventQueue_Init(void) {
+    event_head = 0;
+    event_tail = 0;
+    event_dropped = 0;
+}
+
+// 可在中断中调用，未使能的事件直接忽略；队列满时丢弃新事件
+void EventQueue_Post(EventType_t type, int32_t value) {
+    if (!(event_enable_mask & (1U << type))) return;
+
+    uint32_t tick = HAL_GetTick();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((uint16_t)(event_head - event_tail) < EVENT_QUEUE_SIZE) {
+        Event_t *event = &events[event_head & (EVENT_QUEUE_SIZE - 1)];
+        event->tick = tick;
+        event->value = value;
+        event->type = type;
+        event_head++;
+    } else {
+        event_dropped++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void EventQueue_Process(void) {
+    for (uint8_t n = 0; n < EVENT_MAX_PER_POLL && event_tail != event_head; n++) {
+        if (!CDC_TxReady_FS(EVENT_TX_RESERVE)) {
+            break;
+        }
+        __asm volatile("" ::: "memory");
+        Event_t event = events[event_tail & (EVENT_QUEUE_SIZE - 1)];
+        __asm volatile("" ::: "memory");
+        event_tail++;
+
+        Json_BeginObject();
+        Json_Key("Event");
+        Json_String(event_names[event.type]);
+        Json_Key("Tick");
+        Json_Uint(event.tick);
+        Json_Key("Value");
+        Json_Int(event.value);
+        Json_End();
+    }
+}
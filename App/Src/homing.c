@@ -0,0 +1,149 @@
+#include "homing.h"
+#include "system_state.h"
+#include "sequence_controller.h"
+#include "hal_instances.h"
+#include "event_queue.h"
+
+// 内部状态
+static struct {
+    HomingState_t state;
+    MotorDirection_t dir;
+    int32_t start_position;
+    volatile bool armed;         // 等待原点上升沿
+    volatile bool edge_latched;  // 中断中已锁存原点位置
+    volatile int32_t latched_position;
+} homing;
+
+void Homing_Init(void) {
+    homing.state = HOME_IDLE;
+    homing.dir = HOME_DEFAULT_DIR;
+    homing.start_position = 0;
+    homing.armed = false;
+    homing.edge_latched = false;
+    homing.latched_position = 0;
+}
+
+// 以指定速率朝原点方向连续运动，并在原点上升沿时由中断停止
+static void Homing_Approach(uint32_t rate_mhz) {
+    homing.edge_latched = false;
+    homing.start_position = StepperMotor_GetPosition();
+    StepperMotor_SetRate(rate_mhz);
+    homing.armed = true;
+    StepperMotor_CountinueMove(homing.dir);
+}
+
+// 回零结束（成功或失败）
+static void Homing_Finish(HomingState_t result) {
+    homing.state = result;
+    EventQueue_Post(EVENT_HOMED, result);
+}
+
+static void Homing_Backoff(void) {
+    StepperMotor_Move(homing.dir == MOTOR_DIR_CW ? MOTOR_DIR_CCW : MOTOR_DIR_CW,
+                      HOME_BACKOFF_STEPS);
+    homing.state = HOME_BACKOFF;
+}
+
+bool Homing_Start(MotorDirection_t dir) {
+    if (Homing_IsRunning() || SequenceController_IsRunning() || StepperMotor_IsMoving()) {
+        return false;
+    }
+
+    homing.dir = dir;
+
+    if (HAL_GPIO_ReadPin(INPUT_ZERO_GPIO_Port, INPUT_ZERO_Pin) == GPIO_PIN_SET) {
+        // 已处于原点，直接回退后慢速接近
+        Homing_Backoff();
+    } else {
+        Homing_Approach(HOME_FAST_RATE_MHZ);
+        homing.state = HOME_FAST_APPROACH;
+    }
+    return true;
+}
+
+void Homing_Abort(void) {
+    if (!Homing_IsRunning()) return;
+
+    homing.armed = false;
+    StepperMotor_Stop();
+    Homing_Finish(HOME_FAILED);
+}
+
+bool Homing_IsRunning(void) {
+    return homing.state == HOME_FAST_APPROACH ||
+           homing.state == HOME_BACKOFF ||
+           homing.state == HOME_SLOW_APPROACH;
+}
+
+HomingState_t Homing_GetState(void) {
+    return homing.state;
+}
+
+void Homing_Process(void) {
+    int32_t travel;
+
+    switch (homing.state) {
+        case HOME_FAST_APPROACH:
+        case HOME_SLOW_APPROACH:
+            if (homing.edge_latched) {
+                // 中断已冻结输出，这里完成停止
+                StepperMotor_Stop();
+
+                if (homing.state == HOME_FAST_APPROACH) {
+                    Homing_Backoff();
+                } else {
+                    // 以锁存的原点位置为零点
+                    StepperMotor_SetPosition(StepperMotor_GetPosition() - homing.latched_position);
+                    Homing_Finish(HOME_DONE);
+                }
+                break;
+            }
+
+            // 行程保护
+            travel = StepperMotor_GetPosition() - homing.start_position;
+            if (travel < 0) travel = -travel;
+            if (travel > HOME_MAX_STEPS || !StepperMotor_IsMoving()) {
+                Homing_Abort();
+            }
+            break;
+
+        case HOME_BACKOFF:
+            if (StepperMotor_IsMoving()) break;
+
+            if (HAL_GPIO_ReadPin(INPUT_ZERO_GPIO_Port, INPUT_ZERO_Pin) == GPIO_PIN_SET) {
+                // 回退后仍在原点，判定失败
+                Homing_Finish(HOME_FAILED);
+            } else {
+                Homing_Approach(HOME_SLOW_RATE_MHZ);
+                homing.state = HOME_SLOW_APPROACH;
+            }
+            break;
+
+        case HOME_IDLE:
+        case HOME_DONE:
+        case HOME_FAILED:
+        default:
+            break;
+    }
+}
+
+// 外部中断处理函数（原点信号边沿）
+void Homing_EXTI4_IRQHandler(void) {
+    // 检查是否是PA4触发的中断
+    if (__HAL_GPIO_EXTI_GET_IT(INPUT_ZERO_Pin) != RESET) {
+        // 清除中断标志
+        __HAL_GPIO_EXTI_CLEAR_IT(INPUT_ZERO_Pin);
+
+        bool level = (HAL_GPIO_ReadPin(INPUT_ZERO_GPIO_Port, INPUT_ZERO_Pin) == GPIO_PIN_SET);
+        g_system_state.zero_point = level;
+        EventQueue_Post(EVENT_ZERO_EDGE, level);
+
+        // 接近过程中遇到上升沿：立即停止脉冲并锁存位置
+        if (level && homing.armed) {
+            StepperMotor_HaltFromISR();
+            homing.latched_position = StepperMotor_GetPosition();
+            homing.armed = false;
+            homing.edge_latched = true;
+        }
+    }
+}
@@ -1,12 +1,23 @@
 #include "ina236.h"
 #include "hal_instances.h"
 #include "system_state.h"
+#include "event_queue.h"
 #include <string.h>
 
 // INA236电流校准参数
 #define CURRENT_LSB_NANO 250 //最大电流为8192uA
 #define SHUNT_CAL 621 //测试电阻为33Ω 
 
+// 通讯失败只在状态变化时上报一次，避免主循环中持续失败时刷屏
+static bool i2c_faulted = false;
+
+static void INA236_Fault(uint8_t stage) {
+    if (!i2c_faulted) {
+        i2c_faulted = true;
+        EventQueue_Post(EVENT_I2C_FAULT, stage);
+    }
+}
+
 bool INA236_Init(void) {
     g_system_state.ina236_init_stat = false;
 
@@ -20,6 +31,7 @@ bool INA236_Init(void) {
     
     if (HAL_I2C_Master_Transmit(&hi2c1, INA236_ADDRESS, 
                                config_data, 3, 100) != HAL_OK) {
+        INA236_Fault(EVENT_I2C_INIT);
         return false;
     }
     
@@ -33,6 +45,7 @@ bool INA236_Init(void) {
     
     if (HAL_I2C_Master_Transmit(&hi2c1, INA236_ADDRESS, 
                             cal_data, 3, 100) != HAL_OK) {
+        INA236_Fault(EVENT_I2C_INIT);
         return false;
     }
     
@@ -50,8 +63,9 @@ bool INA236_ReadCurrent(uint16_t *current) {
     
     // 写入要读取的寄存器地址
     if (HAL_I2C_Master_Transmit(&hi2c1, INA236_ADDRESS, 
-                               &reg_addr, 1, 100) != HAL_OK) {
+                               reg_addr, 1, 100) != HAL_OK) {
         g_system_state.ina236_read_stat = true;
+        INA236_Fault(EVENT_I2C_READ_TX);
         return false;
     }
     
@@ -59,14 +73,21 @@ bool INA236_ReadCurrent(uint16_t *current) {
     if (HAL_I2C_Master_Receive(&hi2c1, INA236_ADDRESS, 
                               read_data, 2, 10) != HAL_OK) {
         g_system_state.ina236_read_stat = false;
+        INA236_Fault(EVENT_I2C_READ_RX);
         return false;
     }
+    i2c_faulted = false;
+    
+    *current = INA236_ConvertCurrent(read_data);
     
+    return true;
+}
+
+// 分流电压寄存器（高字节在前）换算为电流
+uint16_t INA236_ConvertCurrent(const uint8_t data[2]) {
     // 转换为有符号16位整数
-    int16_t raw_current = (read_data[0] << 8) | read_data[1];
+    int16_t raw_current = (data[0] << 8) | data[1];
     
     // 转换为实际电流值（安培）
-    *current = raw_current * CURRENT_LSB_NANO / 1000; // 转换为微安培单位
-    
-    return true;
+    return raw_current * CURRENT_LSB_NANO / 1000; // 转换为微安培单位
 }
\ No newline at end of file
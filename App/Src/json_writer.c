@@ -0,0 +1,138 @@
+#include "json_writer.h"
+#include "usbd_cdc_if.h"
+#include <string.h>
+
+static bool json_first_key;
+static bool json_has_id;
+static uint32_t json_request_id;
+static bool json_muted;
+
+static void Json_Put(const char *str, uint16_t len) {
+    if (!json_muted) {
+        CDC_Append_FS((const uint8_t *)str, len);
+    }
+}
+
+static void Json_PutStr(const char *str) {
+    Json_Put(str, (uint16_t)strlen(str));
+}
+
+void Json_Begin(const char *cmd, bool success) {
+    if (!json_muted) CDC_BeginMessage_FS();
+    Json_PutStr("{\"Cmd\": \"");
+    Json_PutStr(cmd);
+    Json_PutStr(success ? "\", \"Status\": \"Success\"" : "\", \"Status\": \"Error\"");
+    json_first_key = false;
+    if (json_has_id) {
+        Json_Key("Id");
+        Json_Uint(json_request_id);
+    }
+}
+
+// 请求编号由命令解析器在处理带 #<id> 前缀的命令期间设置
+void Json_SetRequestId(bool present, uint32_t id) {
+    json_has_id = present;
+    json_request_id = id;
+}
+
+bool Json_GetRequestId(uint32_t *id) {
+    *id = json_request_id;
+    return json_has_id;
+}
+
+void Json_SetMuted(bool muted) {
+    json_muted = muted;
+}
+
+void Json_BeginObject(void) {
+    if (!json_muted) CDC_BeginMessage_FS();
+    Json_Put("{", 1);
+    json_first_key = true;
+}
+
+void Json_Key(const char *key) {
+    if (json_first_key) {
+        Json_Put("\"", 1);
+        json_first_key = false;
+    } else {
+        Json_Put(", \"", 3);
+    }
+    Json_PutStr(key);
+    Json_Put("\": ", 3);
+}
+
+void Json_Uint(uint32_t value) {
+    char digits[10];
+    uint8_t n = sizeof(digits);
+
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    Json_Put(&digits[n], (uint16_t)(sizeof(digits) - n));
+}
+
+void Json_Int(int32_t value) {
+    if (value < 0) {
+        Json_Put("-", 1);
+        Json_Uint(0u - (uint32_t)value);
+    } else {
+        Json_Uint((uint32_t)value);
+    }
+}
+
+void Json_Milli(uint32_t value) {
+    uint32_t frac = value % 1000;
+    char digits[4];
+    uint8_t n = 0;
+
+    Json_Uint(value / 1000);
+    if (frac == 0) {
+        return;
+    }
+    // 小数部分去掉末尾的0
+    digits[n++] = '.';
+    digits[n++] = (char)('0' + frac / 100);
+    if (frac % 100 != 0) {
+        digits[n++] = (char)('0' + frac / 10 % 10);
+        if (frac % 10 != 0) {
+            digits[n++] = (char)('0' + frac % 10);
+        }
+    }
+    Json_Put(digits, n);
+}
+
+void Json_Bool(bool value) {
+    if (value) {
+        Json_Put("true", 4);
+    } else {
+        Json_Put("false", 5);
+    }
+}
+
+void Json_String(const char *str) {
+    Json_Put("\"", 1);
+    Json_PutStr(str);
+    Json_Put("\"", 1);
+}
+
+void Json_Raw(const char *str) {
+    Json_PutStr(str);
+}
+
+void Json_Int16Array(const int16_t *values, uint8_t count) {
+    Json_Put("[", 1);
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0) {
+            Json_Put(", ", 2);
+        }
+        Json_Int(values[i]);
+    }
+    Json_Put("]", 1);
+}
+
+bool Json_End(void) {
+    Json_Put("}\r\n", 3);
+    if (json_muted) return true;
+    return CDC_EndMessage_FS() == USBD_OK;
+}
@@ -0,0 +1,466 @@
+#include "param_registry.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "eeprom_emulation.h"
+#include "perf_monitor.h"
+#include "event_queue.h"
+#include "telemetry.h"
+#include "json_writer.h"
+#include "usbd_cdc_if.h"
+#include "main.h"
+#include <string.h>
+#include <stdlib.h>
+
+// 写入后的同步操作
+static void Param_ApplyFreq(void) {
+    // 提拉过程中实时生效（按斜坡过渡）
+    if (SequenceController_GetState() == SEQ_MONITOR_CURRENT) {
+        StepperMotor_SetTargetRate(g_system_state.freq_mhz, g_system_state.ramp_mhz_per_s);
+    }
+}
+
+// 三个开关位于同一端口（GPIOA），一次写BSRR同时切换，不会出现中间状态
+static void Param_ApplySwitches(void) {
+    uint32_t all = SWITCH_CURRENT_Pin | SWITCH_HOLDOFF_Pin | SWITCH_DIVISION_Pin;
+    uint32_t set = (g_system_state.switch_current ? SWITCH_CURRENT_Pin : 0) |
+                   (g_system_state.switch_holdoff ? SWITCH_HOLDOFF_Pin : 0) |
+                   (g_system_state.switch_division ? SWITCH_DIVISION_Pin : 0);
+
+    // 低16位置位，高16位复位
+    SWITCH_CURRENT_GPIO_Port->BSRR = set | ((all & ~set) << 16);
+}
+
+static void Param_ApplyStall(void) {
+    if (g_system_state.stall_detect) {
+        RoundMonitor_ResetReference();
+    }
+}
+
+static void Param_ApplyPid(void) {
+    EtchControl_Reset();
+}
+
+// 计算型只读参数
+static int32_t Param_GetRate(void) {
+    return (int32_t)StepperMotor_GetRate();
+}
+
+static int32_t Param_GetPosition(void) {
+    return StepperMotor_GetPosition();
+}
+
+static int32_t Param_GetHome(void) {
+    return Homing_GetState();
+}
+
+static int32_t Param_GetSeqState(void) {
+    return SequenceController_GetState();
+}
+
+static int32_t Param_GetLastData(void) {
+    return g_system_state.current_buffer[(g_system_state.buffer_index + BUFFER_SIZE - 1) % BUFFER_SIZE];
+}
+
+static int32_t Param_GetStackPeak(void) {
+    return (int32_t)PerfMonitor_GetStackPeak();
+}
+
+static int32_t Param_GetTxHigh(void) {
+    uint16_t high_water;
+    uint32_t overflow;
+    CDC_GetTxStats_FS(&high_water, &overflow);
+    return high_water;
+}
+
+static int32_t Param_GetTxOverflow(void) {
+    uint16_t high_water;
+    uint32_t overflow;
+    CDC_GetTxStats_FS(&high_water, &overflow);
+    return (int32_t)overflow;
+}
+
+// 参数表：必须按名称字母顺序（strcmp）排列，查找使用二分法
+static const Param_t params[] = {
+    { .name = "CMDCYCLES", .id = PARAM_ID_CMDCYCLES,  // 上一条命令的CPU周期数
+      .type = PARAM_U32, .flags = PARAM_FLAG_READONLY, .ptr = &perf_command_cycles },
+    { .name = "CMDCYCLESMAX", .id = PARAM_ID_CMDCYCLESMAX,  // 写入0清零
+      .type = PARAM_U32, .ptr = &perf_command_cycles_max, .min = 0, .max = 0 },
+    { .name = "CURRENT", .id = PARAM_ID_CURRENT, .type = PARAM_BOOL, .status_level = 1,
+      .ptr = &g_system_state.switch_current, .apply = Param_ApplySwitches },
+    { .name = "CURRENTSTEP", .id = PARAM_ID_CURRENTSTEP,
+      .type = PARAM_U16, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .ptr = &g_system_state.current_steps },
+    { .name = "DATA", .id = PARAM_ID_DATA, .type = PARAM_I16_ARRAY, .flags = PARAM_FLAG_READONLY,
+      .ptr = g_system_state.current_buffer, .max = BUFFER_SIZE },
+    { .name = "DEBUG", .id = PARAM_ID_DEBUG, .type = PARAM_BOOL,
+      .ptr = &g_system_state.debug_enabled },
+    { .name = "DIRECTION", .id = PARAM_ID_DIRECTION,
+      .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .ptr = &g_system_state.direction },
+    { .name = "DIVISION", .id = PARAM_ID_DIVISION, .type = PARAM_BOOL, .status_level = 1,
+      .ptr = &g_system_state.switch_division, .apply = Param_ApplySwitches },
+    { .name = "EVENTDROP", .id = PARAM_ID_EVENTDROP,  // 事件队列满时丢弃的事件数
+      .type = PARAM_U32, .flags = PARAM_FLAG_READONLY, .ptr = &event_dropped },
+    { .name = "EVENTS", .id = PARAM_ID_EVENTS,  // 事件使能掩码，位号见 EventType_t
+      .type = PARAM_U8, .ptr = &event_enable_mask, .min = 0, .max = EVENT_MASK_ALL },
+    { .name = "FREQ", .id = PARAM_ID_FREQ,
+      .type = PARAM_MILLI, .status_level = 1, .ee_addr = EE_ADDR_FREQ_MHZ,
+      .ee_legacy_addr = EE_ADDR_FREQ_HZ,
+      .ptr = &g_system_state.freq_mhz, .min = STEPPER_RATE_MIN_MHZ, .max = STEPPER_RATE_MAX_MHZ,
+      .apply = Param_ApplyFreq },
+    { .name = "HOLDOFF", .id = PARAM_ID_HOLDOFF, .type = PARAM_BOOL, .status_level = 1,
+      .ptr = &g_system_state.switch_holdoff, .apply = Param_ApplySwitches },
+    { .name = "HOME", .id = PARAM_ID_HOME, .type = PARAM_I32, .flags = PARAM_FLAG_READONLY,
+      .get = Param_GetHome },
+    { .name = "INA236INIT", .id = PARAM_ID_INA236INIT,
+      .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY, .status_level = 2,
+      .ptr = &g_system_state.ina236_init_stat },
+    { .name = "INA236READ", .id = PARAM_ID_INA236READ,
+      .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY, .status_level = 2,
+      .ptr = &g_system_state.ina236_read_stat },
+    { .name = "KD", .id = PARAM_ID_KD, .type = PARAM_I16,  // Q15增益：32767对应1.0
+      .ptr = &g_system_state.pid_kd, .min = -32768, .max = 32767, .apply = Param_ApplyPid },
+    { .name = "KI", .id = PARAM_ID_KI, .type = PARAM_I16,
+      .ptr = &g_system_state.pid_ki, .min = -32768, .max = 32767, .apply = Param_ApplyPid },
+    { .name = "KP", .id = PARAM_ID_KP, .type = PARAM_I16,
+      .ptr = &g_system_state.pid_kp, .min = -32768, .max = 32767, .apply = Param_ApplyPid },
+    { .name = "LASTDATA", .id = PARAM_ID_LASTDATA,
+      .type = PARAM_I32, .flags = PARAM_FLAG_READONLY, .status_level = 2,
+      .get = Param_GetLastData },
+    { .name = "LEVEL", .id = PARAM_ID_LEVEL, .type = PARAM_U8, .ee_addr = EE_ADDR_DEBUG_LEVEL,
+      .ptr = &g_system_state.debug_level, .min = 0, .max = 3 },
+    { .name = "MOVING", .id = PARAM_ID_MOVING,
+      .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .ptr = &g_system_state.motor_moving },
+    { .name = "PHASE", .id = PARAM_ID_PHASE, .type = PARAM_U16, .flags = PARAM_FLAG_READONLY,
+      .ptr = &g_system_state.round_phase },
+    { .name = "PID", .id = PARAM_ID_PID, .type = PARAM_BOOL,
+      .ptr = &g_system_state.pid_enabled, .apply = Param_ApplyPid },
+    { .name = "PIDMAX", .id = PARAM_ID_PIDMAX, .type = PARAM_MILLI,
+      .ptr = &g_system_state.pid_max_mhz, .min = STEPPER_RATE_MIN_MHZ, .max = STEPPER_RATE_MAX_MHZ,
+      .apply = Param_ApplyPid },
+    { .name = "PIDMIN", .id = PARAM_ID_PIDMIN, .type = PARAM_MILLI,
+      .ptr = &g_system_state.pid_min_mhz, .min = STEPPER_RATE_MIN_MHZ, .max = STEPPER_RATE_MAX_MHZ,
+      .apply = Param_ApplyPid },
+    { .name = "PIDTARGET", .id = PARAM_ID_PIDTARGET, .type = PARAM_I16,
+      .ptr = &g_system_state.pid_target, .min = -32768, .max = 32767 },
+    { .name = "POSITION", .id = PARAM_ID_POSITION, .type = PARAM_I32, .flags = PARAM_FLAG_READONLY,
+      .get = Param_GetPosition },
+    { .name = "PPR", .id = PARAM_ID_PPR, .type = PARAM_U16,
+      .ptr = &g_system_state.pulses_per_rev, .min = 1, .max = 65535,
+      .apply = RoundMonitor_ResetReference },
+    { .name = "RAMP", .id = PARAM_ID_RAMP, .type = PARAM_MILLI,  // 0表示在下一个脉冲周期直接切换
+      .ptr = &g_system_state.ramp_mhz_per_s, .min = 0, .max = INT32_MAX },
+    { .name = "RATE", .id = PARAM_ID_RATE, .type = PARAM_MILLI, .flags = PARAM_FLAG_READONLY,
+      .get = Param_GetRate },
+    { .name = "ROUND", .id = PARAM_ID_ROUND, .type = PARAM_U16, .status_level = 3,  // 写入任意值清零
+      .ptr = &g_system_state.round_count, .min = 0, .max = 65535,
+      .apply = SystemState_ResetRoundCount },
+    { .name = "RPM", .id = PARAM_ID_RPM, .type = PARAM_MILLI, .flags = PARAM_FLAG_READONLY,
+      .ptr = &g_system_state.rpm_milli },
+    { .name = "SLIPTOL", .id = PARAM_ID_SLIPTOL, .type = PARAM_U16,
+      .ptr = &g_system_state.slip_tolerance, .min = 0, .max = 65535 },
+    { .name = "SQSTATE", .id = PARAM_ID_SQSTATE,
+      .type = PARAM_I32, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .get = Param_GetSeqState },
+    { .name = "STACKPEAK", .id = PARAM_ID_STACKPEAK,  // 栈使用峰值（字节）
+      .type = PARAM_U32, .flags = PARAM_FLAG_READONLY, .get = Param_GetStackPeak },
+    { .name = "STALL", .id = PARAM_ID_STALL, .type = PARAM_BOOL,
+      .ptr = &g_system_state.stall_detect, .apply = Param_ApplyStall },
+    { .name = "STALLED", .id = PARAM_ID_STALLED, .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY,
+      .ptr = &g_system_state.stall_detected },
+    { .name = "TARGETSTEP", .id = PARAM_ID_TARGETSTEP,
+      .type = PARAM_U16, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .status_key = "TARGET", .ptr = &g_system_state.target_steps },
+    { .name = "TELSKIP", .id = PARAM_ID_TELSKIP,  // 发送队列空间不足时跳过的遥测帧数
+      .type = PARAM_U32, .flags = PARAM_FLAG_READONLY, .ptr = &telemetry_skipped },
+    { .name = "THRES", .id = PARAM_ID_THRES,
+      .type = PARAM_I16, .status_level = 1, .ee_addr = EE_ADDR_THRES,
+      .ptr = &g_system_state.threshold, .min = -32768, .max = 32767 },
+    { .name = "TXHIGH", .id = PARAM_ID_TXHIGH, .type = PARAM_I32, .flags = PARAM_FLAG_READONLY,
+      .get = Param_GetTxHigh },
+    { .name = "TXOVF", .id = PARAM_ID_TXOVF, .type = PARAM_I32, .flags = PARAM_FLAG_READONLY,
+      .get = Param_GetTxOverflow },
+    { .name = "WINDOW", .id = PARAM_ID_WINDOW, .type = PARAM_U8,
+      .ptr = &g_system_state.window, .min = 1, .max = BUFFER_SIZE },
+    { .name = "ZEROPOINT", .id = PARAM_ID_ZEROPOINT,
+      .type = PARAM_BOOL, .flags = PARAM_FLAG_READONLY, .status_level = 3,
+      .status_key = "ZeroPoint", .ptr = &g_system_state.zero_point },
+};
+
+#define PARAM_COUNT (sizeof(params) / sizeof(params[0]))
+
+// 按编号索引的查找表，在初始化时建立
+static const Param_t *params_by_id[PARAM_ID_COUNT];
+
+void ParamRegistry_Init(void) {
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        params_by_id[params[i].id] = &params[i];
+    }
+}
+
+static int Param_Compare(const void *key, const void *elem) {
+    return strcmp((const char *)key, ((const Param_t *)elem)->name);
+}
+
+const Param_t *ParamRegistry_Find(const char *name) {
+    return bsearch(name, params, PARAM_COUNT, sizeof(Param_t), Param_Compare);
+}
+
+const Param_t *ParamRegistry_FindById(uint8_t id) {
+    return id < PARAM_ID_COUNT ? params_by_id[id] : NULL;
+}
+
+static int32_t Param_Read(const Param_t *param) {
+    if (param->ptr == NULL) {
+        return param->get != NULL ? param->get() : 0;
+    }
+    switch (param->type) {
+        case PARAM_BOOL:  return *(bool *)param->ptr;
+        case PARAM_U8:    return *(uint8_t *)param->ptr;
+        case PARAM_I16:   return *(int16_t *)param->ptr;
+        case PARAM_U16:   return *(uint16_t *)param->ptr;
+        case PARAM_I32:   return *(int32_t *)param->ptr;
+        case PARAM_U32:
+        case PARAM_MILLI: return (int32_t)*(uint32_t *)param->ptr;
+        default:          return 0;
+    }
+}
+
+static void Param_Write(const Param_t *param, int32_t value) {
+    switch (param->type) {
+        case PARAM_BOOL:  *(bool *)param->ptr = (value != 0); break;
+        case PARAM_U8:    *(uint8_t *)param->ptr = (uint8_t)value; break;
+        case PARAM_I16:   *(int16_t *)param->ptr = (int16_t)value; break;
+        case PARAM_U16:   *(uint16_t *)param->ptr = (uint16_t)value; break;
+        case PARAM_I32:   *(int32_t *)param->ptr = value; break;
+        case PARAM_U32:
+        case PARAM_MILLI: *(uint32_t *)param->ptr = (uint32_t)value; break;
+        default: break;
+    }
+}
+
+int32_t ParamRegistry_GetValue(const Param_t *param) {
+    return Param_Read(param);
+}
+
+// 检查参数是否可写、数值是否在范围内（BOOL规整为0/1）
+static bool Param_Validate(const Param_t *param, int32_t *value) {
+    if (param->flags & PARAM_FLAG_READONLY || param->ptr == NULL) {
+        return false;
+    }
+
+    if (param->type == PARAM_BOOL) {
+        *value = (*value != 0);
+    } else if (param->type == PARAM_MILLI || param->type == PARAM_U32) {
+        if ((uint32_t)*value < (uint32_t)param->min || (uint32_t)*value > (uint32_t)param->max) {
+            return false;
+        }
+    } else if (*value < param->min || *value > param->max) {
+        return false;
+    }
+    return true;
+}
+
+// 写入原始数值（MILLI类型为放大1000倍的值，BOOL为0/1），检查范围后调用同步操作
+bool ParamRegistry_SetValue(const Param_t *param, int32_t value) {
+    if (!Param_Validate(param, &value)) {
+        return false;
+    }
+
+    Param_Write(param, value);
+    if (param->apply != NULL) {
+        param->apply();
+    }
+    return true;
+}
+
+// 解析SET的字符串值并校验，不写入
+bool ParamRegistry_Parse(const Param_t *param, const char *str, int32_t *value) {
+    if (param->type == PARAM_BOOL) {
+        if (strcmp(str, "ON") == 0) {
+            *value = 1;
+        } else if (strcmp(str, "OFF") == 0) {
+            *value = 0;
+        } else {
+            return false;
+        }
+    } else if (param->type == PARAM_MILLI) {
+        uint32_t milli;
+        if (!ParamRegistry_ParseMilli(str, &milli)) {
+            return false;
+        }
+        *value = (int32_t)milli;
+    } else if (!ParamRegistry_ParseInt(str, value)) {
+        return false;
+    }
+
+    return Param_Validate(param, value);
+}
+
+bool ParamRegistry_Set(const Param_t *param, const char *value) {
+    int32_t parsed;
+
+    return ParamRegistry_Parse(param, value, &parsed) && ParamRegistry_SetValue(param, parsed);
+}
+
+// 批量写入已由 ParamRegistry_Parse 校验的数值：在临界区内先写入全部参数，
+// 再执行各自的同步操作（相同的操作只执行一次），硬件和控制器只看到最终状态
+void ParamRegistry_SetBatch(const Param_t *const params[], const int32_t values[], uint8_t count) {
+    void (*applied[PARAM_BATCH_MAX])(void);
+    uint8_t applied_count = 0;
+
+    if (count > PARAM_BATCH_MAX) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint8_t i = 0; i < count; i++) {
+        Param_Write(params[i], values[i]);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        void (*apply)(void) = params[i]->apply;
+        uint8_t j = 0;
+
+        if (apply == NULL) continue;
+        while (j < applied_count && applied[j] != apply) j++;
+        if (j < applied_count) continue;
+
+        applied[applied_count++] = apply;
+        apply();
+    }
+
+    __set_PRIMASK(primask);
+}
+
+// 以JSON值的形式输出参数当前值
+void ParamRegistry_WriteValue(const Param_t *param) {
+    if (param->type == PARAM_I16_ARRAY) {
+        Json_Int16Array((const int16_t *)param->ptr, (uint8_t)param->max);
+        return;
+    }
+
+    ParamRegistry_WriteRaw(param, Param_Read(param));
+}
+
+// 按参数类型输出事先读取的数值（用于快照）
+void ParamRegistry_WriteRaw(const Param_t *param, int32_t value) {
+    if (param->type == PARAM_BOOL) {
+        Json_Bool(value != 0);
+    } else if (param->type == PARAM_MILLI) {
+        Json_Milli((uint32_t)value);
+    } else if (param->type == PARAM_U32) {
+        Json_Uint((uint32_t)value);
+    } else {
+        Json_Int(value);
+    }
+}
+
+// 输出指定STATUS等级的所有参数：, "KEY": value
+void ParamRegistry_WriteStatus(uint8_t level) {
+    if (level == 0) return;  // 等级0只输出LEVEL，status_level为0的参数不属于任何等级
+
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        const Param_t *param = &params[i];
+
+        if (param->status_level != level) continue;
+        Json_Key(param->status_key != NULL ? param->status_key : param->name);
+        ParamRegistry_WriteValue(param);
+    }
+}
+
+// 所有保存的参数一次写入：页需要擦除时只擦一次，擦除后全部重新写入，互不覆盖
+void ParamRegistry_Save(void) {
+    uint16_t addresses[EE_MAX_VARIABLES];
+    uint32_t values[EE_MAX_VARIABLES];
+    uint8_t count = 0;
+
+    for (size_t i = 0; i < PARAM_COUNT && count < EE_MAX_VARIABLES; i++) {
+        if (params[i].ee_addr != 0) {
+            addresses[count] = params[i].ee_addr;
+            values[count] = (uint32_t)Param_Read(&params[i]);
+            count++;
+        }
+    }
+    EE_WriteVariables(addresses, values, count);
+}
+
+// 读取失败或超出范围时保留默认值
+void ParamRegistry_Load(void) {
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        const Param_t *param = &params[i];
+        uint32_t data;
+
+        if (param->ee_addr == 0) continue;
+        if (EE_ReadVariable(param->ee_addr, &data) != 0) {
+            // 旧版固件保存的整数单位值换算为千分之一单位
+            if (param->ee_legacy_addr == 0 || EE_ReadVariable(param->ee_legacy_addr, &data) != 0 ||
+                data > UINT32_MAX / 1000) {
+                continue;
+            }
+            data *= 1000;
+        }
+        if (param->type == PARAM_MILLI || param->type == PARAM_U32) {
+            if (data < (uint32_t)param->min || data > (uint32_t)param->max) continue;
+        } else if ((int32_t)data < param->min || (int32_t)data > param->max) {
+            continue;
+        }
+        Param_Write(param, (int32_t)data);
+    }
+}
+
+// 解析带最多3位小数的非负数，结果放大1000倍（如 "12.5" -> 12500）
+bool ParamRegistry_ParseMilli(const char *str, uint32_t *out) {
+    uint32_t int_part = 0;
+    uint32_t frac_part = 0;
+    uint32_t frac_digits = 0;
+
+    if (*str < '0' || *str > '9') return false;
+    while (*str >= '0' && *str <= '9') {
+        int_part = int_part * 10 + (*str++ - '0');
+        if (int_part > 4000000) return false; // 防止溢出
+    }
+    if (*str == '.') {
+        str++;
+        while (*str >= '0' && *str <= '9') {
+            if (frac_digits < 3) {
+                frac_part = frac_part * 10 + (*str - '0');
+                frac_digits++;
+            }
+            str++;
+        }
+    }
+    if (*str != '\0') return false;
+
+    while (frac_digits < 3) {
+        frac_part *= 10;
+        frac_digits++;
+    }
+    *out = int_part * 1000 + frac_part;
+    return true;
+}
+
+// 解析带可选负号的十进制整数，要求整个字符串均为数字
+bool ParamRegistry_ParseInt(const char *str, int32_t *out) {
+    bool negative = false;
+    uint32_t value = 0;
+
+    if (*str == '-') {
+        negative = true;
+        str++;
+    }
+    if (*str < '0' || *str > '9') return false;
+    while (*str >= '0' && *str <= '9') {
+        if (value > 214748364) return false; // 防止溢出
+        value = value * 10 + (*str++ - '0');
+    }
+    if (*str != '\0' || value > (negative ? 2147483648UL : 2147483647UL)) return false;
+
+    *out = negative ? (int32_t)(0u - value) : (int32_t)value;
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "perf_monitor.h"
+#include "main.h"
+
+// 链接脚本定义的符号
+extern uint32_t _estack;
+extern uint32_t _Min_Stack_Size;
+
+uint32_t perf_command_cycles = 0;
+uint32_t perf_command_cycles_max = 0;
+
+static uint32_t *stack_bottom;
+
+void PerfMonitor_Init(void) {
+    // 使能DWT周期计数器
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // 从栈底到当前SP（保留余量）填充图案，期间关中断以免覆盖中断栈帧
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stack_bottom = (uint32_t *)((uint32_t)&_estack - (uint32_t)&_Min_Stack_Size);
+    uint32_t *limit = (uint32_t *)(__get_MSP() - PERF_STACK_MARGIN);
+    for (uint32_t *p = stack_bottom; p < limit; p++) {
+        *p = PERF_STACK_PAINT;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint32_t PerfMonitor_CycleStart(void) {
+    return DWT->CYCCNT;
+}
+
+void PerfMonitor_CommandDone(uint32_t start) {
+    perf_command_cycles = DWT->CYCCNT - start;
+    if (perf_command_cycles > perf_command_cycles_max) {
+        perf_command_cycles_max = perf_command_cycles;
+    }
+}
+
+// 返回栈使用峰值（字节）：从栈底向上找到第一个被改写的字
+// 若等于 _Min_Stack_Size，说明栈已用到或超出预留区域
+uint32_t PerfMonitor_GetStackPeak(void) {
+    uint32_t *p = stack_bottom;
+    while (p < &_estack && *p == PERF_STACK_PAINT) {
+        p++;
+    }
+    return (uint32_t)&_estack - (uint32_t)p;
+}
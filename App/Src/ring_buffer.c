@@ -0,0 +1,103 @@
+#include "ring_buffer.h"
+#include <string.h>
+
+// 编译器屏障：保证数据拷贝在索引发布之前完成（单核Cortex-M3无需DMB）
+#define RING_BUFFER_BARRIER() __asm volatile ("" ::: "memory")
+
+void RingBuffer_Init(RingBuffer_t *rb, uint8_t *buffer, uint16_t size) {
+    rb->buffer = buffer;
+    rb->mask = size - 1;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+uint16_t RingBuffer_Count(const RingBuffer_t *rb) {
+    return (uint16_t)(rb->head - rb->tail);
+}
+
+uint16_t RingBuffer_Free(const RingBuffer_t *rb) {
+    return (uint16_t)(rb->mask + 1 - RingBuffer_Count(rb));
+}
+
+// 从写入计数 head 处拷贝数据，最多分两段（回绕处）
+static void RingBuffer_CopyIn(RingBuffer_t *rb, uint16_t head, const uint8_t *data, uint16_t len) {
+    uint16_t offset = head & rb->mask;
+    uint16_t first = (uint16_t)(rb->mask + 1 - offset);
+    if (first > len) first = len;
+    memcpy(&rb->buffer[offset], data, first);
+    memcpy(&rb->buffer[0], data + first, len - first);
+}
+
+// 写入数据，空间不足时只写入能容纳的部分，返回实际写入字节数（生产者调用）
+uint16_t RingBuffer_Write(RingBuffer_t *rb, const uint8_t *data, uint16_t len) {
+    uint16_t head = rb->head;
+    uint16_t free = (uint16_t)(rb->mask + 1 - (uint16_t)(head - rb->tail));
+    if (len > free) len = free;
+
+    RingBuffer_CopyIn(rb, head, data, len);
+
+    RING_BUFFER_BARRIER();
+    rb->head = (uint16_t)(head + len);
+    return len;
+}
+
+// 暂存写入：数据写在已暂存的 staged 字节之后，但不更新 head，消费者不可见。
+// 空间不足时不写入并返回false。（生产者调用）
+bool RingBuffer_Stage(RingBuffer_t *rb, uint16_t staged, const uint8_t *data, uint16_t len) {
+    uint16_t head = (uint16_t)(rb->head + staged);
+    uint16_t free = (uint16_t)(rb->mask + 1 - (uint16_t)(head - rb->tail));
+    if (len > free) return false;
+
+    RingBuffer_CopyIn(rb, head, data, len);
+    return true;
+}
+
+// 一次性发布全部暂存数据
+void RingBuffer_Commit(RingBuffer_t *rb, uint16_t staged) {
+    RING_BUFFER_BARRIER();
+    rb->head = (uint16_t)(rb->head + staged);
+}
+
+// 读取数据，返回实际读取字节数（消费者调用）
+uint16_t RingBuffer_Read(RingBuffer_t *rb, uint8_t *data, uint16_t len) {
+    uint16_t tail = rb->tail;
+    uint16_t count = (uint16_t)(rb->head - tail);
+    if (len > count) len = count;
+    RING_BUFFER_BARRIER();
+
+    uint16_t offset = tail & rb->mask;
+    uint16_t first = (uint16_t)(rb->mask + 1 - offset);
+    if (first > len) first = len;
+    memcpy(data, &rb->buffer[offset], first);
+    memcpy(data + first, &rb->buffer[0], len - first);
+
+    RING_BUFFER_BARRIER();
+    rb->tail = (uint16_t)(tail + len);
+    return len;
+}
+
+bool RingBuffer_Get(RingBuffer_t *rb, uint8_t *byte) {
+    uint16_t tail = rb->tail;
+    if (rb->head == tail) return false;
+    RING_BUFFER_BARRIER();
+    *byte = rb->buffer[tail & rb->mask];
+    RING_BUFFER_BARRIER();
+    rb->tail = (uint16_t)(tail + 1);
+    return true;
+}
+
+uint16_t RingBuffer_Peek(const RingBuffer_t *rb, uint8_t **data) {
+    uint16_t tail = rb->tail;
+    uint16_t count = (uint16_t)(rb->head - tail);
+    uint16_t offset = tail & rb->mask;
+    uint16_t contiguous = (uint16_t)(rb->mask + 1 - offset);
+    RING_BUFFER_BARRIER();
+
+    *data = &rb->buffer[offset];
+    return count < contiguous ? count : contiguous;
+}
+
+void RingBuffer_Skip(RingBuffer_t *rb, uint16_t len) {
+    RING_BUFFER_BARRIER();
+    rb->tail = (uint16_t)(rb->tail + len);
+}
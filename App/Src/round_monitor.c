@@ -0,0 +1,161 @@
+#include "round_monitor.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "hal_instances.h"
+#include "event_queue.h"
+
+// 内部状态
+static struct {
+    volatile uint16_t overflow;      // TIM2溢出次数，与CNT组成32位时间戳
+    volatile uint32_t last_capture;  // 上一次圈信号边沿的时间戳
+    volatile uint32_t period;        // 最近一圈的周期（计数），0表示无效
+    volatile int32_t last_position;  // 上一次边沿时的步数位置
+    volatile bool last_dir;          // 上一次边沿时的运动方向
+    volatile bool reference_valid;   // 已有参考边沿
+    volatile bool timing_valid;      // 自上一次边沿起电机持续运动
+    volatile bool fault;             // 中断中检测到失步
+} monitor;
+
+void RoundMonitor_Init(void) {
+    monitor.overflow = 0;
+    monitor.last_capture = 0;
+    monitor.period = 0;
+    monitor.last_position = 0;
+    monitor.last_dir = MOTOR_DIR_CW;
+    monitor.reference_valid = false;
+    monitor.timing_valid = false;
+    monitor.fault = false;
+
+    // 启动溢出中断和CH4输入捕获
+    __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_UPDATE);
+    HAL_TIM_IC_Start_IT(&htim2, TIM_CHANNEL_4);
+}
+
+// 清除参考边沿（如重新回零或修改每圈脉冲数后）
+void RoundMonitor_ResetReference(void) {
+    monitor.reference_valid = false;
+    monitor.timing_valid = false;
+    monitor.period = 0;
+    g_system_state.stall_detected = false;
+}
+
+// 读取32位时间戳
+static uint32_t RoundMonitor_Now(void) {
+    uint16_t high;
+    uint16_t low;
+    do {
+        high = monitor.overflow;
+        low = (uint16_t)htim2.Instance->CNT;
+    } while (high != monitor.overflow);
+    return ((uint32_t)high << 16) | low;
+}
+
+// 失步处理：中止运动和序列
+static void RoundMonitor_Fault(void) {
+    g_system_state.stall_detected = true;
+    StepperMotor_Stop();
+    EventQueue_Post(EVENT_STALL, StepperMotor_GetPosition());
+    Homing_Abort();
+    SequenceController_Abort();
+}
+
+void RoundMonitor_Process(void) {
+    if (monitor.fault) {
+        monitor.fault = false;
+        RoundMonitor_Fault();
+    }
+
+    if (!StepperMotor_IsMoving()) {
+        monitor.timing_valid = false;
+        g_system_state.rpm_milli = 0;
+        return;
+    }
+
+    // 堵转检测：发出的脉冲已超过一圈但未收到圈信号
+    if (g_system_state.stall_detect && monitor.reference_valid &&
+        monitor.last_dir == StepperMotor_GetDirection()) {
+        int32_t pulses = StepperMotor_GetPosition() - monitor.last_position;
+        if (pulses < 0) pulses = -pulses;
+        if (pulses > (int32_t)g_system_state.pulses_per_rev + g_system_state.slip_tolerance) {
+            RoundMonitor_Fault();
+            return;
+        }
+    }
+
+    // 实时转速：圈信号停止时按已经过的时间衰减
+    if (monitor.timing_valid && monitor.period != 0) {
+        uint32_t elapsed = RoundMonitor_Now() - monitor.last_capture;
+        uint32_t period = (elapsed > monitor.period) ? elapsed : monitor.period;
+        g_system_state.rpm_milli = (60UL * 1000 * ROUND_TICK_HZ) / period;
+    } else {
+        g_system_state.rpm_milli = 0;
+    }
+}
+
+// 处理一次圈信号边沿
+static void RoundMonitor_Edge(uint32_t timestamp) {
+    int32_t position = StepperMotor_GetPosition();
+    bool dir = StepperMotor_GetDirection();
+    uint16_t ppr = g_system_state.pulses_per_rev;
+
+    // 根据电机方向更新圈数
+    SystemState_UpdateRoundCount(dir == MOTOR_DIR_CW);
+
+    if (monitor.reference_valid && monitor.last_dir == dir) {
+        // 比较相邻两次边沿之间发出的脉冲数与每圈脉冲数
+        int32_t error = position - monitor.last_position;
+        if (error < 0) error = -error;
+        error -= ppr;
+        if (error < 0) error = -error;
+
+        if (g_system_state.stall_detect && StepperMotor_IsMoving() &&
+            error > g_system_state.slip_tolerance) {
+            StepperMotor_HaltFromISR();
+            monitor.fault = true;
+        }
+
+        monitor.period = monitor.timing_valid ? (timestamp - monitor.last_capture) : 0;
+    } else {
+        monitor.period = 0;
+    }
+
+    // 圈信号处的步数相位
+    if (ppr != 0) {
+        int32_t phase = position % ppr;
+        if (phase < 0) phase += ppr;
+        g_system_state.round_phase = (uint16_t)phase;
+    }
+
+    monitor.last_capture = timestamp;
+    monitor.last_position = position;
+    monitor.last_dir = dir;
+    monitor.reference_valid = true;
+    monitor.timing_valid = StepperMotor_IsMoving();
+}
+
+// TIM2中断处理函数（溢出计数与圈信号输入捕获）
+void RoundMonitor_TIM2_IRQHandler(void) {
+    uint32_t sr = htim2.Instance->SR;
+
+    if ((sr & TIM_FLAG_CC4) != RESET &&
+        __HAL_TIM_GET_IT_SOURCE(&htim2, TIM_IT_CC4) != RESET) {
+        // 读取CCR4同时清除捕获标志
+        uint16_t capture = (uint16_t)htim2.Instance->CCR4;
+        uint16_t overflow = monitor.overflow;
+        __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC4OF);
+
+        // 捕获与溢出同时挂起：捕获值较小说明边沿发生在溢出之后
+        if ((sr & TIM_FLAG_UPDATE) != RESET && capture < 0x8000) {
+            overflow++;
+        }
+        RoundMonitor_Edge(((uint32_t)overflow << 16) | capture);
+    }
+
+    if ((sr & TIM_FLAG_UPDATE) != RESET) {
+        __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE);
+        monitor.overflow++;
+    }
+}
@@ -2,12 +2,21 @@
 #include "system_state.h"
 #include "hal_instances.h"
 #include "stepper_motor.h"
+#include "event_queue.h"
 #include <stdbool.h>
 
 static SequenceState_t seq_state = SEQ_IDLE;
 // static uint32_t seq_timer = 0;
 static bool seq_running = false;
 
+// 切换序列状态并发出状态变化事件
+static void SequenceController_SetState(SequenceState_t state) {
+    if (state != seq_state) {
+        seq_state = state;
+        EventQueue_Post(EVENT_SEQ_STATE, state);
+    }
+}
+
 void SequenceController_Init(void) {
     seq_state = SEQ_IDLE;
     seq_running = false;
@@ -15,12 +24,24 @@ void SequenceController_Init(void) {
 
 void SequenceController_Start(void) {
     if (!seq_running) {
-        seq_state = SEQ_SETUP_SWITCHES;
+        SequenceController_SetState(SEQ_SETUP_SWITCHES);
         seq_running = true;
         // seq_timer = HAL_GetTick();
     }
 }
 
+// 中止序列（如检测到失步），停止电机并关闭电流开关
+void SequenceController_Abort(void) {
+    if (!seq_running) return;
+
+    StepperMotor_Stop();
+    g_system_state.switch_current = false;
+    HAL_GPIO_WritePin(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin, GPIO_PIN_RESET);
+
+    seq_running = false;
+    SequenceController_SetState(SEQ_IDLE);
+}
+
 bool SequenceController_IsRunning(void) {
     return seq_running;
 }
@@ -41,31 +62,24 @@ void SequenceController_Process(void) {
             HAL_GPIO_WritePin(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin, GPIO_PIN_SET);
             StepperMotor_UpdateSwitches(false, true);
             
-            seq_state = SEQ_START_MOVING;
+            SequenceController_SetState(SEQ_START_MOVING);
             // seq_timer = current_time;
             break;
             
         case SEQ_START_MOVING:
             // 以可调频率启动CW方向连续运动
-            StepperMotor_SetFrequency(g_system_state.freq);
+            StepperMotor_SetRate(g_system_state.freq_mhz);
 
             // 启动连续运动
             StepperMotor_CountinueMove(MOTOR_DIR_CW);
-            seq_state = SEQ_MONITOR_CURRENT;
+            SequenceController_SetState(SEQ_MONITOR_CURRENT);
             break;
             
         case SEQ_MONITOR_CURRENT:
             // 检查所有电流值是否低于阈值
-            bool all_below = true;
-            for (int i = 0; i < 8; i++) {
-                if (g_system_state.current_buffer[i] >= g_system_state.threshold) {
-                    all_below = false;
-                    break;
-                }
-            }
-            
-            if (all_below) {
-                seq_state = SEQ_ADJUST_SWITCHES;
+            if (SystemState_CurrentBelowThreshold()) {
+                EventQueue_Post(EVENT_CUTOFF, StepperMotor_GetPosition());
+                SequenceController_SetState(SEQ_ADJUST_SWITCHES);
                 // seq_timer = current_time;
             }
             break;
@@ -79,7 +93,7 @@ void SequenceController_Process(void) {
             HAL_GPIO_WritePin(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin, GPIO_PIN_RESET);
             StepperMotor_UpdateSwitches(g_system_state.switch_holdoff, false);
             
-            seq_state = SEQ_FINAL_MOVE;
+            SequenceController_SetState(SEQ_FINAL_MOVE);
             // seq_timer = current_time;
             break;
             
@@ -92,7 +106,7 @@ void SequenceController_Process(void) {
                 StepperMotor_SetFrequency(ORIGIN_FREQ);
                 StepperMotor_Move(MOTOR_DIR_CW, 2000);
                 
-                seq_state = SEQ_COMPLETE;
+                SequenceController_SetState(SEQ_COMPLETE);
             }
             break;
             
@@ -100,7 +114,7 @@ void SequenceController_Process(void) {
             // 检查电机是否停止
             if (!StepperMotor_IsMoving()) {
                 seq_running = false;
-                seq_state = SEQ_IDLE;
+                SequenceController_SetState(SEQ_IDLE);
             }
             break;
             
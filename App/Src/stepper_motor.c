@@ -13,9 +13,66 @@ static struct {
     PulseCompleteCallback_t pulse_complete_callback;
 } motor_state;
 
-// 用于存储TIM1的ARR和PSC值
-static uint16_t tim1_arr_value = 999; // 默认1000Hz: (1MHz/1000) - 1
-static uint16_t tim1_psc_value = 71;  // 72MHz/72 = 1MHz
+// 步进周期参数：周期 = (arr + 1) + frac_num / frac_den 个计数，计数时钟 = TIM1时钟 / (psc + 1)
+typedef struct {
+    uint16_t psc;
+    uint16_t arr;
+    uint32_t frac_num;
+    uint32_t frac_den;
+    uint32_t rate_mhz;
+} StepTiming_t;
+
+static uint32_t tim1_clk_hz = 72000000;  // TIM1计数时钟（APB2）
+static StepTiming_t step_timing;         // 当前生效的周期参数
+static volatile StepTiming_t pending_timing; // 运动中修改速率时，等待更新中断装载
+static volatile bool timing_pending = false;
+static uint32_t frac_acc = 0;            // 小数周期累加器
+static volatile int32_t step_position = 0; // 已发出的步数位置（CW为正）
+
+// 运动中调速的斜坡状态
+static struct {
+    bool active;
+    uint32_t target_mhz;
+    uint32_t current_mhz;
+    uint32_t ramp_mhz_per_s;
+    uint32_t last_tick;
+} ramp_state;
+
+// 根据目标速率计算PSC/ARR及小数部分
+static void StepperMotor_CalcTiming(uint32_t rate_mhz, StepTiming_t *timing) {
+    // 周期总计数 = TIM1时钟 * 1000 / rate_mhz
+    uint64_t num = (uint64_t)tim1_clk_hz * 1000;
+    uint64_t ticks = num / rate_mhz;
+
+    // 选择最小的预分频，使基础周期不超过65535（保留一个计数给小数抖动）
+    uint32_t div = (uint32_t)(ticks / 65535) + 1;
+    if (div > 65536) div = 65536;
+
+    uint32_t den = rate_mhz * div;
+    uint32_t period = (uint32_t)(num / den);
+    if (period > 65535) period = 65535;
+    if (period < 2) period = 2;
+
+    timing->psc = (uint16_t)(div - 1);
+    timing->arr = (uint16_t)(period - 1);
+    timing->frac_num = (uint32_t)(num - (uint64_t)period * den);
+    timing->frac_den = den;
+    timing->rate_mhz = rate_mhz;
+}
+
+// 电机停止时直接写入寄存器，并产生更新事件装载影子寄存器
+static void StepperMotor_ApplyTiming(const StepTiming_t *timing) {
+    step_timing = *timing;
+    frac_acc = 0;
+
+    __HAL_TIM_SET_PRESCALER(&htim1, timing->psc);
+    __HAL_TIM_SET_AUTORELOAD(&htim1, timing->arr);
+    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, (timing->arr + 1) / 2);  // 50%占空比
+    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, (timing->arr + 1) / 2);
+
+    htim1.Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+}
 
 void StepperMotor_Init(void) {
     motor_state.direction = true;
@@ -23,11 +80,13 @@ void StepperMotor_Init(void) {
     motor_state.current_pulses = 0;
     motor_state.is_moving = false;
     motor_state.counting_enabled = false;
-    motor_state.pulse_complete_callback = NULL;
+    // 完成回调由 SystemState_Init 在此之前设置，这里不清除
 
-    // 获取TIM1的配置值
-    tim1_arr_value = htim1.Instance->ARR;
-    tim1_psc_value = htim1.Instance->PSC;
+    // 获取TIM1的计数时钟（APB2分频不为1时定时器时钟加倍）
+    tim1_clk_hz = HAL_RCC_GetPCLK2Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) {
+        tim1_clk_hz *= 2;
+    }
     
     // 停止PWM输出
     HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_1);
@@ -38,6 +97,12 @@ void StepperMotor_Init(void) {
     HAL_GPIO_WritePin(PWM_CW_GPIO_Port, PWM_CW_Pin, GPIO_PIN_RESET);
     HAL_GPIO_WritePin(PWM_CCW_GPIO_Port, PWM_CCW_Pin, GPIO_PIN_RESET);
 
+    // 默认以固有频率初始化周期参数
+    StepTiming_t timing;
+    StepperMotor_CalcTiming((uint32_t)ORIGIN_FREQ * 1000, &timing);
+    StepperMotor_ApplyTiming(&timing);
+    timing_pending = false;
+
     // 清除更新中断标志
     __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
 }
@@ -48,17 +113,75 @@ void StepperMotor_SetFrequency(uint16_t freq) {
         StepperMotor_Stop();
         return;
     }
-    
-    if (freq > 1000) freq = 1000;
-    
-    // 计算ARR值：ARR = (时钟频率 / 预分频) / 目标频率 - 1
-    // 假设TIM1时钟为72MHz，预分频为72，得到1MHz计数器时钟
-    uint32_t arr = 1000000 / freq - 1;
-    tim1_arr_value = arr;
 
-    __HAL_TIM_SET_AUTORELOAD(&htim1, arr);
-    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, arr / 2);  // 50%占空比
-    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, arr / 2);
+    StepperMotor_SetRate((uint32_t)freq * 1000);
+}
+
+// 设置步进速率（mHz），返回实际生效的速率
+uint32_t StepperMotor_SetRate(uint32_t rate_mhz) {
+    if (rate_mhz < STEPPER_RATE_MIN_MHZ) rate_mhz = STEPPER_RATE_MIN_MHZ;
+    if (rate_mhz > STEPPER_RATE_MAX_MHZ) rate_mhz = STEPPER_RATE_MAX_MHZ;
+
+    StepTiming_t timing;
+    StepperMotor_CalcTiming(rate_mhz, &timing);
+
+    if (motor_state.is_moving) {
+        // 运动中：交给更新中断在周期边界装载，避免产生残缺脉冲
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        pending_timing = timing;
+        timing_pending = true;
+        __set_PRIMASK(primask);
+    } else {
+        timing_pending = false;
+        StepperMotor_ApplyTiming(&timing);
+    }
+
+    // 小数周期抖动使平均速率与目标一致
+    return timing.rate_mhz;
+}
+
+// 运动中平滑调速：以 ramp_mhz_per_s 的斜率过渡到新速率，ramp为0时在下一周期直接切换
+void StepperMotor_SetTargetRate(uint32_t rate_mhz, uint32_t ramp_mhz_per_s) {
+    if (rate_mhz < STEPPER_RATE_MIN_MHZ) rate_mhz = STEPPER_RATE_MIN_MHZ;
+    if (rate_mhz > STEPPER_RATE_MAX_MHZ) rate_mhz = STEPPER_RATE_MAX_MHZ;
+
+    if (!motor_state.is_moving || ramp_mhz_per_s == 0) {
+        ramp_state.active = false;
+        StepperMotor_SetRate(rate_mhz);
+        return;
+    }
+
+    ramp_state.current_mhz = StepperMotor_GetRate();
+    ramp_state.target_mhz = rate_mhz;
+    ramp_state.ramp_mhz_per_s = ramp_mhz_per_s;
+    ramp_state.last_tick = HAL_GetTick();
+    ramp_state.active = true;
+}
+
+// 推进斜坡：按经过的时间计算速率增量，新速率在更新事件时装载
+static void StepperMotor_RampProcess(void) {
+    uint32_t now = HAL_GetTick();
+    uint32_t step = (uint32_t)(((uint64_t)ramp_state.ramp_mhz_per_s * (now - ramp_state.last_tick)) / 1000);
+    if (step == 0) return;
+    ramp_state.last_tick = now;
+
+    if (ramp_state.current_mhz < ramp_state.target_mhz) {
+        uint32_t diff = ramp_state.target_mhz - ramp_state.current_mhz;
+        ramp_state.current_mhz += (step < diff) ? step : diff;
+    } else {
+        uint32_t diff = ramp_state.current_mhz - ramp_state.target_mhz;
+        ramp_state.current_mhz -= (step < diff) ? step : diff;
+    }
+
+    StepperMotor_SetRate(ramp_state.current_mhz);
+    if (ramp_state.current_mhz == ramp_state.target_mhz) {
+        ramp_state.active = false;
+    }
+}
+
+uint32_t StepperMotor_GetRate(void) {
+    return timing_pending ? pending_timing.rate_mhz : step_timing.rate_mhz;
 }
 
 void StepperMotor_Move(MotorDirection_t dir, uint16_t steps) {
@@ -67,15 +190,16 @@ void StepperMotor_Move(MotorDirection_t dir, uint16_t steps) {
         return;
     }
     
+    // 设置频率为固有频率（未运动时立即生效）
+    ramp_state.active = false;
+    StepperMotor_SetFrequency(ORIGIN_FREQ);
+
     // 设置目标步数
     motor_state.target_pulses = steps;
     motor_state.current_pulses = 0;
     motor_state.direction = dir;
     motor_state.is_moving = true;
     motor_state.counting_enabled = true;
-    
-    // 设置频率为固有频率
-    StepperMotor_SetFrequency(ORIGIN_FREQ);
 
     // 重置计数器
     __HAL_TIM_SET_COUNTER(&htim1, 0);
@@ -108,6 +232,9 @@ void StepperMotor_Move(MotorDirection_t dir, uint16_t steps) {
         return;
     }
     
+    // PWM启动时立即输出第一个脉冲
+    step_position += (dir == MOTOR_DIR_CW) ? 1 : -1;
+
     // 更新系统状态
     g_system_state.motor_moving = true;
     g_system_state.target_steps = steps;
@@ -119,35 +246,43 @@ void StepperMotor_CountinueMove(MotorDirection_t dir){
     // 使用最大步数表示连续运动，禁用脉冲计数
     motor_state.counting_enabled = false;
     motor_state.target_pulses = 0xFFFF; // 最大值表示连续运动
+    ramp_state.active = false;
     motor_state.current_pulses = 0;
     motor_state.direction = dir;
     motor_state.is_moving = true;
 
+    // 清除更新中断标志
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+
     if (motor_state.direction == MOTOR_DIR_CW) {
         // 停止另一个方向
         HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_2);
         HAL_GPIO_WritePin(PWM_CCW_GPIO_Port, PWM_CCW_Pin, GPIO_PIN_RESET);
         
-        // 启动CW方向PWM并关闭定时器中断
+        // 启动CW方向PWM和定时器中断（不计数，仅用于小数周期抖动）
         HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
-        HAL_TIM_Base_Stop_IT(&htim1);
+        HAL_TIM_Base_Start_IT(&htim1);
     } else if (motor_state.direction == MOTOR_DIR_CCW) {
         // 停止另一个方向
         HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_1);
         HAL_GPIO_WritePin(PWM_CW_GPIO_Port, PWM_CW_Pin, GPIO_PIN_RESET);
         
-        // 启动CCW方向PWM并关闭定时器中断
+        // 启动CCW方向PWM和定时器中断（不计数，仅用于小数周期抖动）
         HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2);
-        HAL_TIM_Base_Stop_IT(&htim1);
+        HAL_TIM_Base_Start_IT(&htim1);
     } else {
         // 无效方向，停止电机
         StepperMotor_Stop();
         return;
     }
+
+    // PWM启动时立即输出第一个脉冲
+    step_position += (dir == MOTOR_DIR_CW) ? 1 : -1;
 }
 
 void StepperMotor_Stop(void) {
     motor_state.is_moving = false;
+    ramp_state.active = false;
     // motor_state.direction = MOTOR_DIR_STOP;
     motor_state.counting_enabled = false;
 
@@ -168,17 +303,16 @@ void StepperMotor_Stop(void) {
     // g_system_state.direction = true;
     g_system_state.current_steps = 0;
     g_system_state.target_steps = 0;
-
-     // 如果有回调函数，调用它
-    if (motor_state.pulse_complete_callback != NULL) {
-        motor_state.pulse_complete_callback();
-    }
 }
 
 bool StepperMotor_IsMoving(void) {
     return motor_state.is_moving;
 }
 
+MotorDirection_t StepperMotor_GetDirection(void) {
+    return motor_state.direction ? MOTOR_DIR_CW : MOTOR_DIR_CCW;
+}
+
 void StepperMotor_UpdateSwitches(bool holdoff, bool division) {
     // 更新HOLDOFF开关
     HAL_GPIO_WritePin(SWITCH_HOLDOFF_GPIO_Port, SWITCH_HOLDOFF_Pin, 
@@ -194,11 +328,20 @@ void StepperMotor_Process(void) {
     
     // 更新系统状态中的当前步数
     g_system_state.current_steps = motor_state.current_pulses;
+
+    // 推进调速斜坡
+    if (ramp_state.active) {
+        StepperMotor_RampProcess();
+    }
     
     // 检查是否到达目标步数
+    // 只有定步运动走完才调用完成回调；中止、回零停止、新MOVE前的停止都不算完成
     if (motor_state.counting_enabled && 
         motor_state.current_pulses >= motor_state.target_pulses) {
         StepperMotor_Stop();
+        if (motor_state.pulse_complete_callback != NULL) {
+            motor_state.pulse_complete_callback();
+        }
     }
 }
 
@@ -206,6 +349,23 @@ void StepperMotor_SetPulseCompleteCallback(PulseCompleteCallback_t callback) {
     motor_state.pulse_complete_callback = callback;
 }
 
+int32_t StepperMotor_GetPosition(void) {
+    return step_position;
+}
+
+void StepperMotor_SetPosition(int32_t position) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    step_position = position;
+    __set_PRIMASK(primask);
+}
+
+// 中断中立即冻结脉冲输出（停止计数器），由线程中的StepperMotor_Stop完成收尾
+void StepperMotor_HaltFromISR(void) {
+    htim1.Instance->CR1 &= ~TIM_CR1_CEN;
+    motor_state.counting_enabled = false;
+}
+
 uint16_t StepperMotor_GetCurrentPulses(void) {
     return motor_state.current_pulses;
 }
@@ -222,6 +382,33 @@ void StepperMotor_TIM1_Update_IRQHandler(void) {
             // 清除更新中断标志
             __HAL_TIM_CLEAR_IT(&htim1, TIM_IT_UPDATE);
             
+            // 装载运动中修改的周期参数（PSC/ARR/CCR均带预装载，下一周期生效）
+            if (timing_pending) {
+                step_timing = *(const StepTiming_t *)&pending_timing;
+                timing_pending = false;
+                frac_acc = 0;
+                htim1.Instance->PSC = step_timing.psc;
+                htim1.Instance->ARR = step_timing.arr;
+                htim1.Instance->CCR1 = (step_timing.arr + 1) / 2;
+                htim1.Instance->CCR2 = (step_timing.arr + 1) / 2;
+            }
+
+            // 小数周期抖动：累加器溢出时本周期多计一个数
+            if (step_timing.frac_num != 0) {
+                uint32_t arr = step_timing.arr;
+                frac_acc += step_timing.frac_num;
+                if (frac_acc >= step_timing.frac_den) {
+                    frac_acc -= step_timing.frac_den;
+                    arr++;
+                }
+                htim1.Instance->ARR = arr;
+                htim1.Instance->CCR1 = (arr + 1) / 2;
+                htim1.Instance->CCR2 = (arr + 1) / 2;
+            }
+
+            // 更新事件即新脉冲的上升沿
+            step_position += (motor_state.direction == MOTOR_DIR_CW) ? 1 : -1;
+
             // 如果计数使能，增加脉冲计数
             if (motor_state.counting_enabled) {
                 motor_state.current_pulses++;
@@ -231,20 +418,4 @@ void StepperMotor_TIM1_Update_IRQHandler(void) {
             }
         }
     }
-}
-
-// 外部中断处理函数（用于原点励磁计数）
-void StepperMotor_EXTI3_Update_IRQHandler(void) {
-     // 检查是否是PA3触发的中断
-    if (__HAL_GPIO_EXTI_GET_IT(INPUT_ROUNDOUT_Pin) != RESET) {
-        // 清除中断标志
-        __HAL_GPIO_EXTI_CLEAR_IT(INPUT_ROUNDOUT_Pin);
-        
-       // 检查电机方向
-       if (motor_state.direction == MOTOR_DIR_CW) {
-           SystemState_UpdateRoundCount(true); // 正转增加
-       } else if (motor_state.direction == MOTOR_DIR_CCW) {
-           SystemState_UpdateRoundCount(false); // 反转减少
-       }
-    }
 }
\ No newline at end of file
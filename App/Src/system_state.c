@@ -1,34 +1,33 @@
 #include "system_state.h"
-#include "eeprom_emulation.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "param_registry.h"
 #include "usb_device.h"
-#include "usbd_cdc_if.h"
+#include "stepper_motor.h"
+#include "event_queue.h"
 #include <string.h>
-#include <stdio.h>
 
 SystemState_t g_system_state;
 
-// 脉冲计数完成回调函数
+// 定步运动走完目标脉冲数时的回调，由主循环中的 StepperMotor_Process 调用（电机已停止）
 static void MotorPulseCompleteCallback(void) {
-    // 当脉冲计数完成时更新系统状态
-    g_system_state.current_steps = g_system_state.target_steps;
-    g_system_state.motor_moving = false;
-    
-    // 如果启用了调试输出，可以在这里添加
-    if (g_system_state.debug_enabled) {
-        char msg[64];
-        snprintf(msg, sizeof(msg), "Motor move completed: %d steps\r\n", 
-                g_system_state.current_steps);
-        CDC_Transmit_FS((uint8_t*)msg, strlen(msg));
-    }
+    EventQueue_Post(EVENT_MOVE_DONE, StepperMotor_GetPosition());
 }
 
 void SystemState_Init(void) {
     // 初始化参数
-    g_system_state.freq = 25;
+    g_system_state.freq_mhz = DEFAULT_FREQ_MHZ;
+    g_system_state.ramp_mhz_per_s = DEFAULT_RAMP_MHZ_PER_S;
     g_system_state.threshold = 50;
 
-    // 从EEPROM加载用户设置
-    // SystemState_LoadFromEEPROM();
+    // 初始化闭环提拉参数
+    g_system_state.pid_enabled = false;
+    g_system_state.pid_target = 50;
+    g_system_state.pid_kp = DEFAULT_PID_KP;
+    g_system_state.pid_ki = DEFAULT_PID_KI;
+    g_system_state.pid_kd = DEFAULT_PID_KD;
+    g_system_state.pid_min_mhz = DEFAULT_PID_MIN_MHZ;
+    g_system_state.pid_max_mhz = DEFAULT_PID_MAX_MHZ;
     
     // 初始化开关状态
     g_system_state.switch_current = false;
@@ -38,10 +37,19 @@ void SystemState_Init(void) {
     // 初始化输入状态
     g_system_state.zero_point = false;
     g_system_state.round_count = 0;
+
+    // 初始化转动监测参数
+    g_system_state.pulses_per_rev = DEFAULT_PULSES_PER_REV;
+    g_system_state.slip_tolerance = DEFAULT_SLIP_TOLERANCE;
+    g_system_state.stall_detect = false;
+    g_system_state.stall_detected = false;
+    g_system_state.rpm_milli = 0;
+    g_system_state.round_phase = 0;
     
     // 初始化电流缓冲区
     memset(g_system_state.current_buffer, 0, sizeof(g_system_state.current_buffer));
     g_system_state.buffer_index = 0;
+    g_system_state.window = BUFFER_SIZE;
     
     // 初始化调试模式
     g_system_state.debug_level = 0;
@@ -59,6 +67,9 @@ void SystemState_Init(void) {
     // 初始化INA236通讯状态
     g_system_state.ina236_init_stat = false;
     g_system_state.ina236_read_stat = false;
+
+    // 默认值设置完后从EEPROM加载用户设置（EE_Init 已在此之前调用）
+    SystemState_LoadFromEEPROM();
 }
 
 void SystemState_UpdateCurrent(uint16_t current) {
@@ -67,6 +78,20 @@ void SystemState_UpdateCurrent(uint16_t current) {
     g_system_state.buffer_index = (g_system_state.buffer_index + 1) % BUFFER_SIZE;
 }
 
+// 断线判断：最近 window 个采样都低于阈值
+bool SystemState_CurrentBelowThreshold(void) {
+    uint8_t window = g_system_state.window;
+
+    if (window == 0 || window > BUFFER_SIZE) window = BUFFER_SIZE;
+    for (uint8_t k = 1; k <= window; k++) {
+        uint8_t i = (g_system_state.buffer_index + BUFFER_SIZE - k) % BUFFER_SIZE;
+        if (g_system_state.current_buffer[i] >= g_system_state.threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void SystemState_ResetRoundCount(void) {
     // 临界区保护
     // uint32_t primask = __get_PRIMASK();
@@ -125,34 +150,11 @@ void SystemState_ZeroPoint(void) {
 }
 
 void SystemState_SaveToEEPROM(void) {
-    EE_WriteVariable(0x0001, g_system_state.freq);
-    EE_WriteVariable(0x0002, g_system_state.threshold);
-    EE_WriteVariable(0x0003, g_system_state.debug_level);
+    // 保存参数表中指定了EEPROM地址的参数
+    ParamRegistry_Save();
 }
 
 void SystemState_LoadFromEEPROM(void) {
-    uint32_t freq_value;
-    uint32_t threshold_value;
-    uint32_t debug_level_value;
-    
-    if (EE_ReadVariable(0x0001, &freq_value) == 0) {
-        g_system_state.freq = (uint16_t)freq_value;
-    }
-    else {
-        g_system_state.freq = 25; // 默认值
-    }
-    
-    if (EE_ReadVariable(0x0002, &threshold_value) == 0) {
-        g_system_state.threshold = (uint16_t)&threshold_value;
-    }
-    else {
-        g_system_state.threshold = 50; // 默认值
-    }
-
-    if (EE_ReadVariable(0x0003, &debug_level_value) == 0) {
-        g_system_state.debug_level = (uint8_t)debug_level_value;
-    }
-    else {
-        g_system_state.debug_level = 0; // 默认值
-    }
-}
\ No newline at end of file
+    // 未保存或超出范围的参数保持默认值
+    ParamRegistry_Load();
+}
@@ -0,0 +1,131 @@
+#include "telemetry.h"
+#include "system_state.h"
+#include "json_writer.h"
+#include "usbd_cdc_if.h"
+#include "main.h"
+#include <string.h>
+
+// 订阅：按各自周期输出一组参数
+typedef struct {
+    bool active;
+    uint32_t period_ms;
+    uint32_t last_tick;
+    uint8_t field_count;
+    const Param_t *fields[TELEMETRY_MAX_FIELDS];
+} Subscription_t;
+
+static Subscription_t subscriptions[TELEMETRY_MAX_SUBSCRIPTIONS];
+static uint32_t debug_last_tick;
+uint32_t telemetry_skipped = 0;
+
+void Telemetry_Init(void) {
+    memset(subscriptions, 0, sizeof(subscriptions));
+    debug_last_tick = HAL_GetTick();
+}
+
+// 返回订阅编号，无空位时返回-1
+int8_t Telemetry_Subscribe(uint32_t period_ms, const Param_t *const fields[], uint8_t count) {
+    for (uint8_t id = 0; id < TELEMETRY_MAX_SUBSCRIPTIONS; id++) {
+        Subscription_t *sub = &subscriptions[id];
+        if (sub->active) continue;
+
+        sub->period_ms = period_ms;
+        sub->field_count = count;
+        memcpy(sub->fields, fields, count * sizeof(fields[0]));
+        sub->last_tick = HAL_GetTick() - period_ms;  // 立即输出第一帧
+        sub->active = true;
+        return (int8_t)id;
+    }
+    return -1;
+}
+
+bool Telemetry_Unsubscribe(uint8_t id) {
+    if (id >= TELEMETRY_MAX_SUBSCRIPTIONS || !subscriptions[id].active) {
+        return false;
+    }
+    subscriptions[id].active = false;
+    return true;
+}
+
+void Telemetry_UnsubscribeAll(void) {
+    for (uint8_t id = 0; id < TELEMETRY_MAX_SUBSCRIPTIONS; id++) {
+        subscriptions[id].active = false;
+    }
+}
+
+// 一帧的最大长度：帧头加每个字段的键名与最长数值
+static uint16_t Telemetry_MaxLength(const Subscription_t *sub) {
+    uint16_t len = 40;
+
+    for (uint8_t i = 0; i < sub->field_count; i++) {
+        len += strlen(sub->fields[i]->name) + 6;
+        len += sub->fields[i]->type == PARAM_I16_ARRAY ? sub->fields[i]->max * 8 + 2 : 12;
+    }
+    return len;
+}
+
+// 先读取全部字段形成快照，再格式化输出，使同一帧内的数值属于同一时刻
+static void Telemetry_Emit(uint8_t id, const Subscription_t *sub, uint32_t tick) {
+    int32_t snapshot[TELEMETRY_MAX_FIELDS];
+
+    for (uint8_t i = 0; i < sub->field_count; i++) {
+        snapshot[i] = ParamRegistry_GetValue(sub->fields[i]);
+    }
+
+    Json_BeginObject();
+    Json_Key("Telemetry");
+    Json_Uint(id);
+    Json_Key("Tick");
+    Json_Uint(tick);
+    for (uint8_t i = 0; i < sub->field_count; i++) {
+        Json_Key(sub->fields[i]->name);
+        if (sub->fields[i]->type == PARAM_I16_ARRAY) {
+            ParamRegistry_WriteValue(sub->fields[i]);
+        } else {
+            ParamRegistry_WriteRaw(sub->fields[i], snapshot[i]);
+        }
+    }
+    Json_End();
+}
+
+// DEBUG ON：按 LEVEL 周期输出与 STATUS 命令相同格式的状态
+static void Telemetry_EmitDebug(void) {
+    if (g_system_state.debug_level > 3) {
+        return;
+    }
+    Json_Begin("STATUS", true);
+    Json_Key("LEVEL");
+    Json_Uint(g_system_state.debug_level);
+    ParamRegistry_WriteStatus(g_system_state.debug_level);
+    Json_End();
+}
+
+void Telemetry_Process(void) {
+    uint32_t now = HAL_GetTick();
+
+    for (uint8_t id = 0; id < TELEMETRY_MAX_SUBSCRIPTIONS; id++) {
+        Subscription_t *sub = &subscriptions[id];
+        if (!sub->active || now - sub->last_tick < sub->period_ms) continue;
+
+        // 按固定节拍推进；落后超过一个周期时重新对齐，不补发
+        sub->last_tick += sub->period_ms;
+        if (now - sub->last_tick >= sub->period_ms) {
+            sub->last_tick = now;
+        }
+        // 发送队列空间不足时跳过本帧并计数，不等待主机读取
+        if (!CDC_TxReady_FS(Telemetry_MaxLength(sub))) {
+            telemetry_skipped++;
+            continue;
+        }
+        Telemetry_Emit(id, sub, now);
+    }
+
+    if (g_system_state.debug_enabled && now - debug_last_tick >= TELEMETRY_DEBUG_PERIOD_MS) {
+        debug_last_tick = now;
+        if (!CDC_TxReady_FS(TELEMETRY_DEBUG_RESERVE)) {
+            telemetry_skipped++;
+            return;
+        }
+        Telemetry_EmitDebug();
+    }
+}
@@ -67,9 +67,9 @@ void Error_Handler(void);
 #define SWITCH_DIVISION_GPIO_Port GPIOA
 #define INPUT_ROUNDOUT_Pin GPIO_PIN_3
 #define INPUT_ROUNDOUT_GPIO_Port GPIOA
-#define INPUT_ROUNDOUT_EXTI_IRQn EXTI3_IRQn
 #define INPUT_ZERO_Pin GPIO_PIN_4
 #define INPUT_ZERO_GPIO_Port GPIOA
+#define INPUT_ZERO_EXTI_IRQn EXTI4_IRQn
 #define PWM_CW_Pin GPIO_PIN_8
 #define PWM_CW_GPIO_Port GPIOA
 #define PWM_CCW_Pin GPIO_PIN_9
@@ -28,6 +28,12 @@
 #include "command_parser.h"
 #include "sequence_controller.h"
 #include "eeprom_emulation.h"
+#include "homing.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "perf_monitor.h"
+#include "telemetry.h"
+#include "event_queue.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -49,6 +55,7 @@
 I2C_HandleTypeDef hi2c1;
 
 TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim2;
 
 /* USER CODE BEGIN PV */
 
@@ -59,6 +66,7 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_I2C1_Init(void);
 static void MX_TIM1_Init(void);
+static void MX_TIM2_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -99,8 +107,13 @@ int main(void)
   MX_GPIO_Init();
   MX_I2C1_Init();
   MX_TIM1_Init();
+  MX_TIM2_Init();
   MX_USB_DEVICE_Init();
   /* USER CODE BEGIN 2 */
+  // 初始化性能统计（周期计数器、栈填充）
+  PerfMonitor_Init();
+  EventQueue_Init();
+
   // 初始化EEPROM模拟
   EE_Init();
     
@@ -112,6 +125,10 @@ int main(void)
   INA236_Init();
   CommandParser_Init();
   SequenceController_Init();
+  Homing_Init();
+  RoundMonitor_Init();
+  EtchControl_Init();
+  Telemetry_Init();
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -125,6 +142,9 @@ int main(void)
     int16_t current;
     if (INA236_ReadCurrent(&current)) {
         SystemState_UpdateCurrent(current);
+
+        // 闭环提拉：每个采样更新一次步进速率
+        EtchControl_Sample(current);
     }
     
     // 更新输入状态
@@ -135,19 +155,21 @@ int main(void)
     
     // 处理序列控制器
     SequenceController_Process();
+
+    // 处理回零
+    Homing_Process();
+
+    // 处理转动监测（失步/堵转、转速）
+    RoundMonitor_Process();
+
+    // 处理USB接收到的命令
+    CommandParser_Poll();
     
-    // 处理调试输出
-    static uint32_t last_debug_time = 0;
-    uint32_t current_time = HAL_GetTick();
-    
-    if (g_system_state.debug_enabled && 
-        (current_time - last_debug_time >= 1000)) {
-        last_debug_time = current_time;
-        
-        char debug_cmd[32];
-        snprintf(debug_cmd, sizeof(debug_cmd), "STATUS");
-        CommandParser_Process(debug_cmd);
-    }
+    // 输出中断和各模块产生的事件
+    EventQueue_Process();
+
+    // 处理遥测订阅和调试输出
+    Telemetry_Process();
   }
   /* USER CODE END 3 */
 }
@@ -311,6 +333,64 @@ static void MX_TIM1_Init(void)
 
 }
 
+/**
+  * @brief TIM2 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM2_Init(void)
+{
+
+  /* USER CODE BEGIN TIM2_Init 0 */
+
+  /* USER CODE END TIM2_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+  TIM_IC_InitTypeDef sConfigIC = {0};
+
+  /* USER CODE BEGIN TIM2_Init 1 */
+
+  /* USER CODE END TIM2_Init 1 */
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 7199;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 65535;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_TIM_IC_Init(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sConfigIC.ICPolarity = TIM_INPUTCHANNELPOLARITY_RISING;
+  sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+  sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+  sConfigIC.ICFilter = 8;
+  if (HAL_TIM_IC_ConfigChannel(&htim2, &sConfigIC, TIM_CHANNEL_4) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM2_Init 2 */
+
+  /* USER CODE END TIM2_Init 2 */
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -338,21 +418,15 @@ static void MX_GPIO_Init(void)
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
-  /*Configure GPIO pin : INPUT_ROUNDOUT_Pin */
-  GPIO_InitStruct.Pin = INPUT_ROUNDOUT_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
-  GPIO_InitStruct.Pull = GPIO_PULLDOWN;
-  HAL_GPIO_Init(INPUT_ROUNDOUT_GPIO_Port, &GPIO_InitStruct);
-
   /*Configure GPIO pin : INPUT_ZERO_Pin */
   GPIO_InitStruct.Pin = INPUT_ZERO_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_PULLDOWN;
   HAL_GPIO_Init(INPUT_ZERO_GPIO_Port, &GPIO_InitStruct);
 
   /* EXTI interrupt init*/
-  HAL_NVIC_SetPriority(EXTI3_IRQn, 2, 0);
-  HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+  HAL_NVIC_SetPriority(EXTI4_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(EXTI4_IRQn);
 
   /* USER CODE BEGIN MX_GPIO_Init_2 */
 
@@ -0,0 +1,542 @@
+#include "tip_client.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tip {
+
+namespace {
+
+constexpr size_t kRxChunk = 4096;
+constexpr uint32_t kMaxRequestId = 2147483647;  // 固件接受的 #id 上限
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// 去掉字符串值两端的引号
+std::string_view Unquote(std::string_view raw) {
+    if (raw.size() >= 2 && raw.front() == '"' && raw.back() == '"') {
+        return raw.substr(1, raw.size() - 2);
+    }
+    return raw;
+}
+
+}  // namespace
+
+double NowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+const char *OutcomeName(Outcome outcome) {
+    switch (outcome) {
+    case Outcome::kSuccess: return "Success";
+    case Outcome::kError:   return "Error";
+    case Outcome::kTimeout: return "Timeout";
+    case Outcome::kClosed:  return "Closed";
+    }
+    return "?";
+}
+
+// 固件输出的都是单行扁平对象，值为数字、true/false、不含转义的字符串或数组
+JsonView::JsonView(std::string_view line) {
+    size_t i = 0;
+    size_t n = line.size();
+
+    auto skip = [&]() { while (i < n && IsSpace(line[i])) i++; };
+
+    skip();
+    if (i >= n || line[i++] != '{') return;
+    for (;;) {
+        skip();
+        if (i < n && line[i] == '}') {
+            valid_ = true;
+            return;
+        }
+        if (i >= n || line[i] != '"' || count_ >= kMaxFields) return;
+        size_t key_start = ++i;
+        while (i < n && line[i] != '"') i++;
+        if (i >= n) return;
+        keys_[count_] = line.substr(key_start, i - key_start);
+        i++;
+        skip();
+        if (i >= n || line[i++] != ':') return;
+        skip();
+
+        size_t value_start = i;
+        if (i < n && line[i] == '"') {
+            i++;
+            while (i < n && line[i] != '"') i++;
+            if (i >= n) return;
+            i++;
+        } else if (i < n && (line[i] == '[' || line[i] == '{')) {
+            int depth = 0;
+            do {
+                if (line[i] == '[' || line[i] == '{') depth++;
+                if (line[i] == ']' || line[i] == '}') depth--;
+                i++;
+            } while (i < n && depth > 0);
+            if (depth != 0) return;
+        } else {
+            while (i < n && line[i] != ',' && line[i] != '}' && !IsSpace(line[i])) i++;
+        }
+        if (i == value_start) return;
+        values_[count_++] = line.substr(value_start, i - value_start);
+
+        skip();
+        if (i < n && line[i] == ',') {
+            i++;
+        } else if (i >= n || line[i] != '}') {
+            return;
+        }
+    }
+}
+
+std::string_view JsonView::Raw(std::string_view key) const {
+    for (size_t i = 0; i < count_; i++) {
+        if (keys_[i] == key) return values_[i];
+    }
+    return {};
+}
+
+bool JsonView::String(std::string_view key, std::string_view *value) const {
+    std::string_view raw = Raw(key);
+    if (raw.size() < 2 || raw.front() != '"') return false;
+    *value = Unquote(raw);
+    return true;
+}
+
+bool JsonView::Uint(std::string_view key, uint32_t *value) const {
+    std::string_view raw = Raw(key);
+    auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), *value);
+    return !raw.empty() && ec == std::errc() && end == raw.data() + raw.size();
+}
+
+bool JsonView::Int(std::string_view key, int32_t *value) const {
+    std::string_view raw = Raw(key);
+    auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), *value);
+    return !raw.empty() && ec == std::errc() && end == raw.data() + raw.size();
+}
+
+bool JsonView::Double(std::string_view key, double *value) const {
+    std::string_view raw = Raw(key);
+    auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), *value);
+    return !raw.empty() && ec == std::errc() && end == raw.data() + raw.size();
+}
+
+bool JsonView::Bool(std::string_view key, bool *value) const {
+    std::string_view raw = Raw(key);
+    if (raw == "true" || raw == "false") {
+        *value = raw == "true";
+        return true;
+    }
+    return false;
+}
+
+double ParamValue::AsDouble() const {
+    double value = 0;
+    std::string_view text = Unquote(raw);
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+Client::~Client() {
+    Close();
+}
+
+bool Client::Open(const std::string &path) {
+    struct termios tio;
+
+    Close();
+    fd_ = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        perror(path.c_str());
+        return false;
+    }
+    if (tcgetattr(fd_, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd_, TCSANOW, &tio);
+    }
+    tcflush(fd_, TCIOFLUSH);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd_;
+    if (epoll_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &ev) != 0) {
+        perror("epoll");
+        Close();
+        return false;
+    }
+    want_write_ = false;
+    rx_.assign(kRxChunk, 0);
+    rx_len_ = 0;
+    tx_.clear();
+    tx_off_ = 0;
+    return true;
+}
+
+void Client::Close() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    // 重新打开后不应再收到旧连接上命令的超时回调
+    in_flight_.clear();
+    queued_.clear();
+}
+
+// 连接出错：关闭并以 outcome 结束所有在途和排队的命令
+void Client::Fail(Outcome outcome) {
+    std::vector<Request> failed;
+
+    for (auto &entry : in_flight_) failed.push_back(std::move(entry.second));
+    for (auto &request : queued_) failed.push_back(std::move(request));
+    Close();
+
+    double now = NowUs();
+    for (auto &request : failed) {
+        if (request.handler) request.handler(Reply{ outcome, JsonView(), now - request.sent_us });
+    }
+}
+
+uint32_t Client::Send(std::string_view command, ReplyHandler handler) {
+    Request request;
+    char prefix[16];
+    int len;
+
+    request.id = next_id_;
+    next_id_ = next_id_ >= kMaxRequestId ? 1 : next_id_ + 1;
+    len = snprintf(prefix, sizeof(prefix), "#%u ", request.id);
+    request.line.reserve(static_cast<size_t>(len) + command.size() + 2);
+    request.line.append(prefix, static_cast<size_t>(len));
+    request.line.append(command);
+    request.line.append("\r\n");
+    request.handler = std::move(handler);
+    request.sent_us = NowUs();
+    request.deadline_us = 0;
+
+    uint32_t id = request.id;
+    if (fd_ < 0) {
+        if (request.handler) request.handler(Reply{ Outcome::kClosed, JsonView(), 0 });
+        return id;
+    }
+    queued_.push_back(std::move(request));
+    Launch();
+    return id;
+}
+
+// 窗口有空位时把排队的命令放入发送缓冲区
+void Client::Launch() {
+    bool added = false;
+
+    while (fd_ >= 0 && in_flight_.size() < window_ && !queued_.empty()) {
+        Request request = std::move(queued_.front());
+        queued_.pop_front();
+        request.sent_us = NowUs();
+        request.deadline_us = request.sent_us + timeout_ms_ * 1e3;
+        tx_.append(request.line);
+        stats_.sent++;
+        in_flight_.emplace(request.id, std::move(request));
+        added = true;
+    }
+    if (added) Flush();
+}
+
+// 尽量写出发送缓冲区，写不完时等待 EPOLLOUT（固件接收缓冲区满时USB端点NAK）
+void Client::Flush() {
+    while (fd_ >= 0 && tx_off_ < tx_.size()) {
+        ssize_t n = write(fd_, tx_.data() + tx_off_, tx_.size() - tx_off_);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            Fail(Outcome::kClosed);
+            return;
+        }
+        tx_off_ += static_cast<size_t>(n);
+        stats_.tx_bytes += static_cast<uint64_t>(n);
+    }
+    if (tx_off_ == tx_.size()) {
+        tx_.clear();
+        tx_off_ = 0;
+    }
+    UpdateEpoll();
+}
+
+void Client::UpdateEpoll() {
+    bool want_write = fd_ >= 0 && tx_off_ < tx_.size();
+
+    if (fd_ < 0 || want_write == want_write_) return;
+    struct epoll_event ev = {};
+    ev.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.fd = fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &ev);
+    want_write_ = want_write;
+}
+
+// 读到 EAGAIN 为止，接收缓冲区按需增长
+bool Client::ReadInput() {
+    for (;;) {
+        if (rx_.size() - rx_len_ < kRxChunk / 2) rx_.resize(rx_.size() * 2);
+        ssize_t n = read(fd_, rx_.data() + rx_len_, rx_.size() - rx_len_);
+        if (n > 0) {
+            rx_len_ += static_cast<size_t>(n);
+            stats_.rx_bytes += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;   // EOF 或读错误
+    }
+}
+
+// 分发接收缓冲区中所有完整的行，剩余的半行移到开头
+int Client::Dispatch() {
+    size_t start = 0;
+    int count = 0;
+
+    while (fd_ >= 0) {
+        const char *begin = rx_.data() + start;
+        const char *nl = static_cast<const char *>(memchr(begin, '\n', rx_len_ - start));
+        if (nl == nullptr) break;
+        size_t len = static_cast<size_t>(nl - begin);
+        if (len > 0 && begin[len - 1] == '\r') len--;
+        if (len > 0) {
+            HandleLine(std::string_view(begin, len));
+            count++;
+        }
+        start = static_cast<size_t>(nl - rx_.data()) + 1;
+    }
+    if (fd_ < 0) return count;
+    if (start > 0) {
+        memmove(rx_.data(), rx_.data() + start, rx_len_ - start);
+        rx_len_ -= start;
+    }
+    return count;
+}
+
+void Client::HandleLine(std::string_view line) {
+    JsonView json(line);
+    uint32_t id;
+
+    if (!json.Valid()) {
+        stats_.malformed++;
+        return;
+    }
+
+    if (json.Has("Cmd") && json.Uint("Id", &id)) {
+        auto it = in_flight_.find(id);
+        if (it == in_flight_.end()) {
+            stats_.unmatched++;
+            return;
+        }
+        Request request = std::move(it->second);
+        in_flight_.erase(it);
+        stats_.replies++;
+
+        std::string_view status;
+        Outcome outcome = json.String("Status", &status) && status == "Success" ? Outcome::kSuccess
+                                                                                 : Outcome::kError;
+        if (request.handler) request.handler(Reply{ outcome, json, NowUs() - request.sent_us });
+        return;
+    }
+
+    if (!json.Has("Cmd") && json.Has("Telemetry")) {
+        Telemetry telemetry = { 0, 0, json };
+        json.Uint("Telemetry", &telemetry.id);
+        json.Uint("Tick", &telemetry.tick);
+        stats_.telemetry++;
+        if (on_telemetry_) on_telemetry_(telemetry);
+        return;
+    }
+
+    if (json.Has("Event")) {
+        Event event = { {}, 0, 0, json };
+        json.String("Event", &event.name);
+        json.Uint("Tick", &event.tick);
+        json.Int("Value", &event.value);
+        stats_.events++;
+        if (on_event_) on_event_(event);
+        return;
+    }
+
+    stats_.unsolicited++;
+    if (on_unsolicited_) on_unsolicited_(json);
+}
+
+// 先取出所有超时的请求再调用回调，回调中可以继续发送命令
+void Client::ExpireTimeouts() {
+    std::vector<Request> expired;
+    double now = NowUs();
+
+    for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+        if (it->second.deadline_us <= now) {
+            expired.push_back(std::move(it->second));
+            it = in_flight_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &request : expired) {
+        stats_.timeouts++;
+        if (request.handler) request.handler(Reply{ Outcome::kTimeout, JsonView(), now - request.sent_us });
+    }
+}
+
+int Client::NextTimeoutMs(int limit_ms) const {
+    double now = NowUs();
+    int wait = limit_ms;
+
+    for (const auto &entry : in_flight_) {
+        double left_ms = (entry.second.deadline_us - now) / 1e3;
+        int ms = left_ms <= 0 ? 0 : static_cast<int>(left_ms) + 1;
+        if (wait < 0 || ms < wait) wait = ms;
+    }
+    return wait;
+}
+
+int Client::Poll(int timeout_ms) {
+    struct epoll_event ev;
+    int count = 0;
+
+    if (fd_ < 0) return -1;
+
+    int n = epoll_wait(epoll_fd_, &ev, 1, NextTimeoutMs(timeout_ms));
+    if (n < 0 && errno != EINTR) {
+        Fail(Outcome::kClosed);
+        return -1;
+    }
+    if (n > 0) {
+        if (ev.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            bool ok = ReadInput();
+            count = Dispatch();
+            if (!ok) {
+                Fail(Outcome::kClosed);
+                return -1;
+            }
+        }
+        if (ev.events & EPOLLOUT) Flush();
+    }
+    ExpireTimeouts();
+    Launch();
+    return fd_ >= 0 ? count : -1;
+}
+
+bool Client::RunUntilIdle() {
+    while (InFlight() > 0) {
+        if (Poll(-1) < 0) return false;
+    }
+    return fd_ >= 0;
+}
+
+uint32_t Client::Get(std::string_view param, ParamHandler handler) {
+    std::string command = "GET ";
+    command.append(param);
+    return Send(command, [handler = std::move(handler)](const Reply &reply) {
+        ParamValue value = { {}, {} };
+        reply.json.String("Parameter", &value.name);
+        value.raw = Unquote(reply.json.Raw("Value"));
+        if (handler) handler(reply.outcome, value);
+    });
+}
+
+// 成功时 Value 为实际生效的值（如 FREQ 按定时器分辨率取整后的值）
+uint32_t Client::Set(std::string_view param, std::string_view value, ParamHandler handler) {
+    std::string command = "SET ";
+    command.append(param).append(" ").append(value);
+    return Send(command, [handler = std::move(handler)](const Reply &reply) {
+        ParamValue result = { {}, {} };
+        reply.json.String("Parameter", &result.name);
+        result.raw = Unquote(reply.json.Raw("Value"));
+        if (handler) handler(reply.outcome, result);
+    });
+}
+
+static Client::ReplyHandler DoneAdapter(Client::DoneHandler handler) {
+    return [handler = std::move(handler)](const Reply &reply) {
+        if (handler) handler(reply.outcome);
+    };
+}
+
+uint32_t Client::Move(Direction dir, uint16_t steps, DoneHandler handler) {
+    std::string command = dir == Direction::kCw ? "MOVE CW " : "MOVE CCW ";
+    command.append(std::to_string(steps));
+    return Send(command, DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Speed(double rate_hz, DoneHandler handler) {
+    char command[32];
+    snprintf(command, sizeof(command), "SPEED %.3f", rate_hz);
+    return Send(command, DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Home(DoneHandler handler) {
+    return Send("HOME", DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Home(Direction dir, DoneHandler handler) {
+    return Send(dir == Direction::kCw ? "HOME CW" : "HOME CCW", DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Start(DoneHandler handler) {
+    return Send("START", DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Save(DoneHandler handler) {
+    return Send("SAVE", DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::Status(StatusHandler handler) {
+    return Send("STATUS", [handler = std::move(handler)](const Reply &reply) {
+        if (handler) handler(reply.outcome, reply.json);
+    });
+}
+
+uint32_t Client::Ping(uint32_t nonce, PingHandler handler) {
+    std::string command = "PING " + std::to_string(nonce & kMaxRequestId);
+    return Send(command, [handler = std::move(handler)](const Reply &reply) {
+        PingResult result = { 0, 0, 0, 0, reply.rtt_us };
+        Outcome outcome = reply.outcome;
+        if (outcome == Outcome::kSuccess &&
+            !(reply.json.Uint("Nonce", &result.nonce) && reply.json.Uint("Mhz", &result.mhz) &&
+              reply.json.Uint("Rx", &result.rx_cycles) && reply.json.Uint("Tx", &result.tx_cycles))) {
+            outcome = Outcome::kError;
+        }
+        if (handler) handler(outcome, result);
+    });
+}
+
+uint32_t Client::Subscribe(uint32_t period_ms, const std::vector<std::string> &params,
+                           SubscribeHandler handler) {
+    std::string command = "SUBSCRIBE " + std::to_string(period_ms) + " ";
+    for (size_t i = 0; i < params.size(); i++) {
+        if (i > 0) command += ',';
+        command += params[i];
+    }
+    return Send(command, [handler = std::move(handler)](const Reply &reply) {
+        uint32_t telemetry_id = 0;
+        reply.json.Uint("Telemetry", &telemetry_id);
+        if (handler) handler(reply.outcome, telemetry_id);
+    });
+}
+
+uint32_t Client::Unsubscribe(uint32_t telemetry_id, DoneHandler handler) {
+    return Send("UNSUBSCRIBE " + std::to_string(telemetry_id), DoneAdapter(std::move(handler)));
+}
+
+uint32_t Client::UnsubscribeAll(DoneHandler handler) {
+    return Send("UNSUBSCRIBE ALL", DoneAdapter(std::move(handler)));
+}
+
+}  // namespace tip
@@ -0,0 +1,221 @@
+// tip_client: tip_maker 串口协议的异步主机端客户端库（C++17，Linux）
+//
+// - 传输层基于 epoll，串口（或 tm_emu 的伪终端）以非阻塞方式读写
+// - 每条命令自动加 #<id> 前缀，应答按 "Id" 与请求匹配，可同时有多条命令在途（流水线）
+// - 应答、遥测帧和事件在接收缓冲区中原地解析，回调中的 string_view 只在回调期间有效
+// - 单线程使用：所有回调都在 Poll() 中调用
+//
+// 例:
+//   tip::Client client;
+//   client.Open("/dev/ttyACM0");
+//   client.Set("FREQ", "12.5", [](tip::Outcome o, const tip::ParamValue &v) { ... });
+//   client.Ping(1, [](tip::Outcome o, const tip::PingResult &r) { ... });
+//   client.RunUntilIdle();
+
+#ifndef __TIP_CLIENT_H__
+#define __TIP_CLIENT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tip {
+
+// 一行扁平JSON对象的只读视图，键和值都指向原始文本
+class JsonView {
+public:
+    static constexpr size_t kMaxFields = 48;
+
+    JsonView() = default;
+    explicit JsonView(std::string_view line);
+
+    bool Valid() const { return valid_; }
+    size_t Size() const { return count_; }
+    std::string_view Key(size_t i) const { return keys_[i]; }
+    std::string_view Raw(size_t i) const { return values_[i]; }
+
+    // 原始值文本（字符串带引号，数组带方括号），不存在时返回空
+    std::string_view Raw(std::string_view key) const;
+    bool Has(std::string_view key) const { return !Raw(key).empty(); }
+    bool String(std::string_view key, std::string_view *value) const;
+    bool Uint(std::string_view key, uint32_t *value) const;
+    bool Int(std::string_view key, int32_t *value) const;
+    bool Double(std::string_view key, double *value) const;
+    bool Bool(std::string_view key, bool *value) const;
+
+private:
+    std::string_view keys_[kMaxFields];
+    std::string_view values_[kMaxFields];
+    size_t count_ = 0;
+    bool valid_ = false;
+};
+
+enum class Outcome {
+    kSuccess,   // "Status": "Success"
+    kError,     // "Status": "Error"（命令被拒绝或参数无效）
+    kTimeout,   // 超时未收到应答
+    kClosed,    // 连接关闭或读写出错
+};
+
+const char *OutcomeName(Outcome outcome);
+
+struct Reply {
+    Outcome outcome;
+    JsonView json;      // kTimeout/kClosed 时无效
+    double rtt_us;      // 发出到收到应答
+};
+
+struct ParamValue {
+    std::string_view name;
+    std::string_view raw;   // 固件返回的值文本，如 12.5、true
+    double AsDouble() const;
+    bool AsBool() const { return raw == "true"; }
+};
+
+struct PingResult {
+    uint32_t nonce;
+    uint32_t mhz;
+    uint32_t rx_cycles;
+    uint32_t tx_cycles;
+    double rtt_us;
+    double device_us() const { return mhz ? static_cast<uint32_t>(tx_cycles - rx_cycles) / double(mhz) : 0; }
+};
+
+struct Telemetry {
+    uint32_t id;
+    uint32_t tick;
+    JsonView fields;    // 含 "Telemetry" 和 "Tick"
+};
+
+struct Event {
+    std::string_view name;
+    uint32_t tick;
+    int32_t value;
+    JsonView fields;    // 整行，含 "Event"、"Tick"、"Value"
+};
+
+enum class Direction { kCw, kCcw };
+
+class Client {
+public:
+    using ReplyHandler = std::function<void(const Reply &)>;
+    using DoneHandler = std::function<void(Outcome)>;
+    using ParamHandler = std::function<void(Outcome, const ParamValue &)>;
+    using PingHandler = std::function<void(Outcome, const PingResult &)>;
+    using StatusHandler = std::function<void(Outcome, const JsonView &)>;
+    using SubscribeHandler = std::function<void(Outcome, uint32_t telemetry_id)>;
+    using TelemetryHandler = std::function<void(const Telemetry &)>;
+    using EventHandler = std::function<void(const Event &)>;
+    using LineHandler = std::function<void(const JsonView &)>;
+
+    Client() = default;
+    ~Client();
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    bool Open(const std::string &path);
+    // 丢弃在途和排队的命令，不调用其回调（可在回调中调用）
+    void Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    // epoll 描述符，可加入调用方自己的事件循环，可读时调用 Poll(0)
+    int Fd() const { return epoll_fd_; }
+
+    // 同时在途的命令数上限，超出的命令在本地排队（固件接收缓冲区512字节）
+    void SetWindow(size_t window) { window_ = window > 0 ? window : 1; }
+    void SetTimeoutMs(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+
+    // 发送任意命令（不含 #id 和行尾），返回请求编号
+    uint32_t Send(std::string_view command, ReplyHandler handler);
+
+    // 各命令的类型化接口
+    uint32_t Get(std::string_view param, ParamHandler handler);
+    uint32_t Set(std::string_view param, std::string_view value, ParamHandler handler);
+    uint32_t Move(Direction dir, uint16_t steps, DoneHandler handler);
+    uint32_t Speed(double rate_hz, DoneHandler handler);
+    uint32_t Home(DoneHandler handler);
+    uint32_t Home(Direction dir, DoneHandler handler);
+    uint32_t Start(DoneHandler handler);
+    uint32_t Save(DoneHandler handler);
+    uint32_t Status(StatusHandler handler);
+    uint32_t Ping(uint32_t nonce, PingHandler handler);
+    uint32_t Subscribe(uint32_t period_ms, const std::vector<std::string> &params, SubscribeHandler handler);
+    uint32_t Unsubscribe(uint32_t telemetry_id, DoneHandler handler);
+    uint32_t UnsubscribeAll(DoneHandler handler);
+
+    // 无 Id 的消息
+    void OnTelemetry(TelemetryHandler handler) { on_telemetry_ = std::move(handler); }
+    void OnEvent(EventHandler handler) { on_event_ = std::move(handler); }
+    void OnUnsolicited(LineHandler handler) { on_unsolicited_ = std::move(handler); }
+
+    // 处理一次IO（最多等待 timeout_ms，-1 为一直等待），返回分发的消息数，出错返回-1
+    int Poll(int timeout_ms);
+    // 运行直到没有在途和排队的命令；连接关闭返回false
+    bool RunUntilIdle();
+
+    size_t InFlight() const { return in_flight_.size() + queued_.size(); }
+
+    struct Stats {
+        uint64_t sent = 0;
+        uint64_t replies = 0;
+        uint64_t timeouts = 0;
+        uint64_t telemetry = 0;
+        uint64_t events = 0;
+        uint64_t unsolicited = 0;
+        uint64_t unmatched = 0;     // 带 Id 但没有对应请求
+        uint64_t malformed = 0;
+        uint64_t rx_bytes = 0;
+        uint64_t tx_bytes = 0;
+    };
+    const Stats &GetStats() const { return stats_; }
+
+private:
+    struct Request {
+        uint32_t id;
+        std::string line;       // 含 #id 和 \r\n
+        ReplyHandler handler;
+        double sent_us;
+        double deadline_us;
+    };
+
+    void Fail(Outcome outcome);
+    void Flush();
+    void Launch();
+    void UpdateEpoll();
+    bool ReadInput();
+    int Dispatch();
+    void HandleLine(std::string_view line);
+    void ExpireTimeouts();
+    int NextTimeoutMs(int limit_ms) const;
+
+    int fd_ = -1;
+    int epoll_fd_ = -1;
+    bool want_write_ = false;
+    size_t window_ = 8;
+    uint32_t timeout_ms_ = 1000;
+    uint32_t next_id_ = 1;
+
+    std::deque<Request> queued_;                    // 等待窗口
+    std::unordered_map<uint32_t, Request> in_flight_;
+    std::string tx_;
+    size_t tx_off_ = 0;
+    std::vector<char> rx_;
+    size_t rx_len_ = 0;
+
+    TelemetryHandler on_telemetry_;
+    EventHandler on_event_;
+    LineHandler on_unsolicited_;
+    Stats stats_;
+};
+
+// CLOCK_MONOTONIC 微秒
+double NowUs();
+
+}  // namespace tip
+
+#endif  // __TIP_CLIENT_H__
@@ -0,0 +1,509 @@
+#include "tip_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tip {
+
+namespace {
+
+// 与固件 EventType_t（App/Inc/event_queue.h）的顺序一致
+const char *const kEventNames[] = {
+    "CUTOFF", "MOVE_DONE", "SEQ_STATE", "ZERO_EDGE", "I2C_FAULT", "STALL", "HOMED",
+};
+constexpr size_t kEventCount = sizeof(kEventNames) / sizeof(kEventNames[0]);
+
+constexpr size_t Align8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+size_t SamplesPayload(uint32_t rows, size_t fields) {
+    return sizeof(ChunkHeader) + 8 * rows + Align8(4 * rows) + 8 * rows * fields;
+}
+
+size_t EventsPayload(uint32_t rows) {
+    return sizeof(ChunkHeader) + 8 * rows + 2 * Align8(4 * rows) + Align8(rows);
+}
+
+// 追加 n 字节并补齐到8字节
+void Append(std::vector<uint8_t> &buf, const void *data, size_t n) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    buf.insert(buf.end(), p, p + n);
+    buf.resize(Align8(buf.size()), 0);
+}
+
+bool WriteAll(int fd, const void *data, size_t n) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (n > 0) {
+        ssize_t written = write(fd, p, n);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+}  // namespace
+
+uint8_t EventCode(std::string_view name) {
+    for (size_t i = 0; i < kEventCount; i++) {
+        if (name == kEventNames[i]) return static_cast<uint8_t>(i);
+    }
+    return kEventUnknown;
+}
+
+const char *EventName(uint8_t code) {
+    return code < kEventCount ? kEventNames[code] : "UNKNOWN";
+}
+
+int64_t RealtimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+TraceWriter::~TraceWriter() {
+    Close();
+}
+
+bool TraceWriter::Open(const std::string &path) {
+    FileHeader header = {};
+
+    Close();
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        perror(path.c_str());
+        return false;
+    }
+    memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+    header.version = kTraceVersion;
+    header.header_size = sizeof(header);
+    header.created_ns = RealtimeNs();
+    failed_ = !WriteAll(fd_, &header, sizeof(header));
+    offset_ = sizeof(header);
+    next_run_ = 1;
+    runs_.clear();
+    open_.clear();
+    return !failed_;
+}
+
+// 写入一个块，返回块偏移
+uint64_t TraceWriter::WriteBlock(BlockType type, const std::vector<uint8_t> &payload) {
+    BlockHeader header = { kBlockMagic, static_cast<uint32_t>(type), payload.size() };
+    uint64_t block = offset_;
+
+    if (!failed_ &&
+        (!WriteAll(fd_, &header, sizeof(header)) || !WriteAll(fd_, payload.data(), payload.size()))) {
+        perror("trace write");
+        failed_ = true;
+    }
+    offset_ += sizeof(header) + payload.size();
+    return block;
+}
+
+uint32_t TraceWriter::BeginRun(uint16_t device, const std::string &device_path,
+                               const std::vector<std::string> &fields, int64_t start_ns) {
+    RunBegin begin = {};
+    RunRecord record = {};
+    OpenRun run;
+    uint32_t run_id = next_run_++;
+
+    begin.run_id = run_id;
+    begin.device = device;
+    begin.field_count = static_cast<uint16_t>(fields.size());
+    begin.start_ns = start_ns;
+    snprintf(begin.device_path, sizeof(begin.device_path), "%s", device_path.c_str());
+
+    scratch_.clear();
+    scratch_.insert(scratch_.end(), reinterpret_cast<const uint8_t *>(&begin),
+                    reinterpret_cast<const uint8_t *>(&begin) + sizeof(begin));
+    for (const std::string &field : fields) {
+        char name[kTraceNameSize] = {};
+        snprintf(name, sizeof(name), "%s", field.c_str());
+        scratch_.insert(scratch_.end(), name, name + sizeof(name));
+    }
+    scratch_.resize(Align8(scratch_.size()), 0);
+
+    record.entry.run_id = run_id;
+    record.entry.device = device;
+    record.entry.start_ns = start_ns;
+    record.entry.end_ns = start_ns;
+    record.entry.begin_offset = WriteBlock(BlockType::kRunBegin, scratch_);
+    runs_.push_back(std::move(record));
+
+    run.record = runs_.size() - 1;
+    run.field_count = fields.size();
+    run.sample_ns.reserve(kChunkRows);
+    run.sample_tick.reserve(kChunkRows);
+    run.values.resize(fields.size() * kChunkRows);
+    open_.emplace(run_id, std::move(run));
+    return run_id;
+}
+
+void TraceWriter::AddSample(uint32_t run_id, int64_t t_ns, uint32_t tick, const double *values) {
+    auto it = open_.find(run_id);
+    if (it == open_.end()) return;
+    OpenRun &run = it->second;
+    size_t row = run.sample_ns.size();
+
+    run.sample_ns.push_back(t_ns);
+    run.sample_tick.push_back(tick);
+    for (size_t k = 0; k < run.field_count; k++) {
+        run.values[k * kChunkRows + row] = values[k];
+    }
+    IndexEntry &entry = runs_[run.record].entry;
+    entry.samples++;
+    entry.end_ns = std::max(entry.end_ns, t_ns);
+    if (run.sample_ns.size() >= kChunkRows) FlushSamples(run_id, run);
+}
+
+void TraceWriter::AddEvent(uint32_t run_id, int64_t t_ns, uint32_t tick, uint8_t type, int32_t value) {
+    auto it = open_.find(run_id);
+    if (it == open_.end()) return;
+    OpenRun &run = it->second;
+
+    run.event_ns.push_back(t_ns);
+    run.event_tick.push_back(tick);
+    run.event_value.push_back(value);
+    run.event_type.push_back(type);
+    IndexEntry &entry = runs_[run.record].entry;
+    entry.events++;
+    entry.end_ns = std::max(entry.end_ns, t_ns);
+    if (run.event_ns.size() >= kChunkRows) FlushEvents(run_id, run);
+}
+
+void TraceWriter::FlushSamples(uint32_t run_id, OpenRun &run) {
+    uint32_t rows = static_cast<uint32_t>(run.sample_ns.size());
+    ChunkHeader chunk = { run_id, rows, 0, 0 };
+
+    if (rows == 0) return;
+    chunk.first_ns = run.sample_ns.front();
+    chunk.last_ns = run.sample_ns.back();
+
+    scratch_.clear();
+    scratch_.reserve(SamplesPayload(rows, run.field_count));
+    Append(scratch_, &chunk, sizeof(chunk));
+    Append(scratch_, run.sample_ns.data(), 8 * rows);
+    Append(scratch_, run.sample_tick.data(), 4 * rows);
+    for (size_t k = 0; k < run.field_count; k++) {
+        Append(scratch_, &run.values[k * kChunkRows], 8 * rows);
+    }
+    runs_[run.record].chunks.push_back(WriteBlock(BlockType::kSamples, scratch_));
+    run.sample_ns.clear();
+    run.sample_tick.clear();
+}
+
+void TraceWriter::FlushEvents(uint32_t run_id, OpenRun &run) {
+    uint32_t rows = static_cast<uint32_t>(run.event_ns.size());
+    ChunkHeader chunk = { run_id, rows, 0, 0 };
+
+    if (rows == 0) return;
+    chunk.first_ns = run.event_ns.front();
+    chunk.last_ns = run.event_ns.back();
+
+    scratch_.clear();
+    Append(scratch_, &chunk, sizeof(chunk));
+    Append(scratch_, run.event_ns.data(), 8 * rows);
+    Append(scratch_, run.event_tick.data(), 4 * rows);
+    Append(scratch_, run.event_value.data(), 4 * rows);
+    Append(scratch_, run.event_type.data(), rows);
+    runs_[run.record].chunks.push_back(WriteBlock(BlockType::kEvents, scratch_));
+    run.event_ns.clear();
+    run.event_tick.clear();
+    run.event_value.clear();
+    run.event_type.clear();
+}
+
+void TraceWriter::EndRun(uint32_t run_id, int64_t end_ns) {
+    auto it = open_.find(run_id);
+    if (it == open_.end()) return;
+    OpenRun &run = it->second;
+    IndexEntry &entry = runs_[run.record].entry;
+    RunEnd end = {};
+
+    FlushSamples(run_id, run);
+    FlushEvents(run_id, run);
+    entry.end_ns = std::max(entry.end_ns, end_ns);
+    entry.complete = 1;
+    end.run_id = run_id;
+    end.end_ns = entry.end_ns;
+    end.samples = entry.samples;
+    end.events = entry.events;
+    scratch_.clear();
+    Append(scratch_, &end, sizeof(end));
+    WriteBlock(BlockType::kRunEnd, scratch_);
+    open_.erase(it);
+}
+
+void TraceWriter::Flush() {
+    if (fd_ < 0) return;
+    for (auto &entry : open_) {
+        FlushSamples(entry.first, entry.second);
+        FlushEvents(entry.first, entry.second);
+    }
+    fdatasync(fd_);
+}
+
+bool TraceWriter::Close() {
+    if (fd_ < 0) return true;
+
+    std::vector<uint32_t> ids;
+    for (const auto &entry : open_) ids.push_back(entry.first);
+    int64_t now = RealtimeNs();
+    for (uint32_t id : ids) EndRun(id, now);
+
+    // INDEX：表项后接全部块偏移
+    IndexHeader header = { static_cast<uint32_t>(runs_.size()), 0 };
+    uint64_t first_chunk = 0;
+    scratch_.clear();
+    Append(scratch_, &header, sizeof(header));
+    for (RunRecord &record : runs_) {
+        record.entry.first_chunk = first_chunk;
+        record.entry.chunk_count = record.chunks.size();
+        first_chunk += record.chunks.size();
+        Append(scratch_, &record.entry, sizeof(record.entry));
+    }
+    for (const RunRecord &record : runs_) {
+        Append(scratch_, record.chunks.data(), 8 * record.chunks.size());
+    }
+    Trailer trailer = {};
+    trailer.index_offset = WriteBlock(BlockType::kIndex, scratch_);
+    memcpy(trailer.magic, kIndexMagic, sizeof(trailer.magic));
+    if (!failed_ && !WriteAll(fd_, &trailer, sizeof(trailer))) {
+        failed_ = true;
+    }
+    offset_ += sizeof(trailer);
+
+    bool ok = !failed_ && fsync(fd_) == 0;
+    close(fd_);
+    fd_ = -1;
+    return ok;
+}
+
+TraceReader::~TraceReader() {
+    Close();
+}
+
+bool TraceReader::Open(const std::string &path) {
+    struct stat st;
+
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path.c_str());
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        fprintf(stderr, "%s: not a trace file\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    base_ = static_cast<const uint8_t *>(map);
+    size_ = static_cast<size_t>(st.st_size);
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(base_);
+    if (memcmp(header->magic, kTraceMagic, sizeof(header->magic)) != 0 ||
+        header->version != kTraceVersion || header->header_size < sizeof(FileHeader)) {
+        fprintf(stderr, "%s: not a trace file\n", path.c_str());
+        Close();
+        return false;
+    }
+    recovered_ = !LoadIndex();
+    if (recovered_) Rebuild();
+    return true;
+}
+
+void TraceReader::Close() {
+    if (base_ != nullptr) {
+        munmap(const_cast<uint8_t *>(base_), size_);
+        base_ = nullptr;
+    }
+    size_ = 0;
+    runs_.clear();
+}
+
+const RunInfo *TraceReader::FindRun(uint32_t run_id) const {
+    for (const RunInfo &run : runs_) {
+        if (run.run_id == run_id) return &run;
+    }
+    return nullptr;
+}
+
+// 块头有效且负载不越界时返回块头
+const BlockHeader *TraceReader::BlockAt(uint64_t offset) const {
+    if (offset % 8 != 0 || offset + sizeof(BlockHeader) > size_) return nullptr;
+    const BlockHeader *block = reinterpret_cast<const BlockHeader *>(base_ + offset);
+    if (block->magic != kBlockMagic || block->size % 8 != 0 ||
+        block->size > size_ - offset - sizeof(BlockHeader)) {
+        return nullptr;
+    }
+    return block;
+}
+
+bool TraceReader::ReadRunBegin(uint64_t offset, RunInfo *run) const {
+    const BlockHeader *block = BlockAt(offset);
+    if (block == nullptr || block->type != static_cast<uint32_t>(BlockType::kRunBegin) ||
+        block->size < sizeof(RunBegin)) {
+        return false;
+    }
+    const RunBegin *begin = reinterpret_cast<const RunBegin *>(block + 1);
+    if (block->size < sizeof(RunBegin) + begin->field_count * kTraceNameSize) return false;
+
+    run->run_id = begin->run_id;
+    run->device = begin->device;
+    run->start_ns = begin->start_ns;
+    run->device_path.assign(begin->device_path, strnlen(begin->device_path, sizeof(begin->device_path)));
+    run->fields.clear();
+    const char *names = reinterpret_cast<const char *>(begin + 1);
+    for (uint16_t k = 0; k < begin->field_count; k++) {
+        const char *name = names + k * kTraceNameSize;
+        run->fields.emplace_back(name, strnlen(name, kTraceNameSize));
+    }
+    return true;
+}
+
+bool TraceReader::LoadIndex() {
+    if (size_ < sizeof(FileHeader) + sizeof(BlockHeader) + sizeof(Trailer)) return false;
+    const Trailer *trailer = reinterpret_cast<const Trailer *>(base_ + size_ - sizeof(Trailer));
+    if (memcmp(trailer->magic, kIndexMagic, sizeof(trailer->magic)) != 0) return false;
+
+    const BlockHeader *block = BlockAt(trailer->index_offset);
+    if (block == nullptr || block->type != static_cast<uint32_t>(BlockType::kIndex) ||
+        block->size < sizeof(IndexHeader)) {
+        return false;
+    }
+    const IndexHeader *header = reinterpret_cast<const IndexHeader *>(block + 1);
+    const IndexEntry *entries = reinterpret_cast<const IndexEntry *>(header + 1);
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(entries + header->run_count);
+    uint64_t available = block->size - sizeof(IndexHeader);
+    if (available < uint64_t(header->run_count) * sizeof(IndexEntry)) return false;
+    uint64_t offset_count = (available - header->run_count * sizeof(IndexEntry)) / 8;
+
+    std::vector<RunInfo> runs;
+    for (uint32_t i = 0; i < header->run_count; i++) {
+        const IndexEntry &entry = entries[i];
+        RunInfo run;
+        if (entry.first_chunk + entry.chunk_count > offset_count || !ReadRunBegin(entry.begin_offset, &run)) {
+            return false;
+        }
+        run.complete = entry.complete != 0;
+        run.end_ns = entry.end_ns;
+        run.samples = entry.samples;
+        run.events = entry.events;
+        run.chunks.assign(offsets + entry.first_chunk, offsets + entry.first_chunk + entry.chunk_count);
+        runs.push_back(std::move(run));
+    }
+    runs_ = std::move(runs);
+    return true;
+}
+
+// 没有索引（写入进程异常退出）：顺序扫描块头，遇到不完整的块为止
+bool TraceReader::Rebuild() {
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(base_);
+    uint64_t offset = Align8(header->header_size);
+    std::unordered_map<uint32_t, size_t> by_id;
+
+    runs_.clear();
+    while (const BlockHeader *block = BlockAt(offset)) {
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(block + 1);
+        switch (static_cast<BlockType>(block->type)) {
+        case BlockType::kRunBegin: {
+            RunInfo run = {};
+            if (ReadRunBegin(offset, &run)) {
+                run.end_ns = run.start_ns;
+                by_id[run.run_id] = runs_.size();
+                runs_.push_back(std::move(run));
+            }
+            break;
+        }
+        case BlockType::kSamples:
+        case BlockType::kEvents: {
+            if (block->size < sizeof(ChunkHeader)) break;
+            const ChunkHeader *chunk = reinterpret_cast<const ChunkHeader *>(payload);
+            auto it = by_id.find(chunk->run_id);
+            if (it == by_id.end()) break;
+            RunInfo &run = runs_[it->second];
+            run.chunks.push_back(offset);
+            if (block->type == static_cast<uint32_t>(BlockType::kSamples)) {
+                run.samples += chunk->rows;
+            } else {
+                run.events += chunk->rows;
+            }
+            run.end_ns = std::max(run.end_ns, chunk->last_ns);
+            break;
+        }
+        case BlockType::kRunEnd: {
+            if (block->size < sizeof(RunEnd)) break;
+            const RunEnd *end = reinterpret_cast<const RunEnd *>(payload);
+            auto it = by_id.find(end->run_id);
+            if (it == by_id.end()) break;
+            runs_[it->second].complete = true;
+            runs_[it->second].end_ns = end->end_ns;
+            break;
+        }
+        default:
+            break;
+        }
+        offset += sizeof(BlockHeader) + block->size;
+    }
+    return true;
+}
+
+bool TraceReader::Scan(const RunInfo &run, const std::function<void(const SampleChunk &)> &on_samples,
+                       const std::function<void(const EventChunk &)> &on_events) const {
+    std::vector<const double *> columns(run.fields.size());
+
+    for (uint64_t offset : run.chunks) {
+        const BlockHeader *block = BlockAt(offset);
+        if (block == nullptr || block->size < sizeof(ChunkHeader)) return false;
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(block + 1);
+        const ChunkHeader *chunk = reinterpret_cast<const ChunkHeader *>(payload);
+        uint32_t rows = chunk->rows;
+        const uint8_t *p = payload + sizeof(ChunkHeader);
+
+        if (block->type == static_cast<uint32_t>(BlockType::kSamples)) {
+            if (block->size < SamplesPayload(rows, columns.size())) return false;
+            SampleChunk samples;
+            samples.rows = rows;
+            samples.t_ns = reinterpret_cast<const int64_t *>(p);
+            p += 8 * rows;
+            samples.tick = reinterpret_cast<const uint32_t *>(p);
+            p += Align8(4 * rows);
+            for (size_t k = 0; k < columns.size(); k++) {
+                columns[k] = reinterpret_cast<const double *>(p);
+                p += 8 * rows;
+            }
+            samples.columns = columns.data();
+            if (on_samples) on_samples(samples);
+        } else if (block->type == static_cast<uint32_t>(BlockType::kEvents)) {
+            if (block->size < EventsPayload(rows)) return false;
+            EventChunk events;
+            events.rows = rows;
+            events.t_ns = reinterpret_cast<const int64_t *>(p);
+            p += 8 * rows;
+            events.tick = reinterpret_cast<const uint32_t *>(p);
+            p += Align8(4 * rows);
+            events.value = reinterpret_cast<const int32_t *>(p);
+            p += Align8(4 * rows);
+            events.type = p;
+            if (on_events) on_events(events);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace tip
@@ -0,0 +1,235 @@
+// tip_trace: 刻蚀记录的分块列式二进制文件（.tip），由 tm_acqd 写入，tm_trace 读取
+//
+// 文件结构（所有整数小端，每个块从8字节对齐的偏移开始）：
+//   FileHeader
+//   Block...                 BlockHeader + 负载（补齐到8字节）
+//     RUN_BEGIN              一次记录开始：设备、字段名
+//     SAMPLES                一个采样块：ChunkHeader + 列 t_ns[i64] tick[u32] 字段k[f64]...
+//     EVENTS                 一个事件块：ChunkHeader + 列 t_ns[i64] tick[u32] value[i32] type[u8]
+//     RUN_END                记录结束与计数
+//     INDEX                  关闭文件时写入：每次记录的位置和全部块偏移
+//   Trailer                  INDEX 块偏移 + 魔数
+//
+// 每列连续存放并按8字节对齐，文件映射后可直接当数组读取，不需要解析。
+// 块头自描述，进程异常退出（没有 INDEX/Trailer）时读取端顺序扫描块头重建索引，
+// 最多丢失最后一个未写出的块。
+
+#ifndef __TIP_TRACE_H__
+#define __TIP_TRACE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tip {
+
+constexpr char kTraceMagic[8] = { 'T', 'I', 'P', 'T', 'R', 'A', 'C', 'E' };
+constexpr char kIndexMagic[8] = { 'T', 'I', 'P', 'I', 'N', 'D', 'E', 'X' };
+constexpr uint32_t kTraceVersion = 1;
+constexpr uint32_t kBlockMagic = 0x4B4C4254;   // "TBLK"
+constexpr size_t kTraceNameSize = 16;          // 字段名（含结尾0）
+constexpr size_t kTracePathSize = 64;          // 设备路径（含结尾0）
+constexpr uint8_t kEventUnknown = 0xFF;
+
+enum class BlockType : uint32_t {
+    kRunBegin = 1,
+    kSamples = 2,
+    kEvents = 3,
+    kRunEnd = 4,
+    kIndex = 5,
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int64_t created_ns;         // CLOCK_REALTIME
+};
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t size;              // 负载字节数（已补齐到8字节）
+};
+
+// RUN_BEGIN 负载：RunBegin + field_count 个字段名
+struct RunBegin {
+    uint32_t run_id;
+    uint16_t device;
+    uint16_t field_count;
+    int64_t start_ns;
+    char device_path[kTracePathSize];
+};
+
+// SAMPLES / EVENTS 负载开头
+struct ChunkHeader {
+    uint32_t run_id;
+    uint32_t rows;
+    int64_t first_ns;
+    int64_t last_ns;
+};
+
+struct RunEnd {
+    uint32_t run_id;
+    uint32_t reserved;
+    int64_t end_ns;
+    uint64_t samples;
+    uint64_t events;
+};
+
+// INDEX 负载：IndexHeader + run_count 个 IndexEntry + 所有块偏移（u64）
+struct IndexHeader {
+    uint32_t run_count;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint32_t run_id;
+    uint16_t device;
+    uint16_t complete;          // 有 RUN_END
+    int64_t start_ns;
+    int64_t end_ns;
+    uint64_t samples;
+    uint64_t events;
+    uint64_t begin_offset;      // RUN_BEGIN 块
+    uint64_t first_chunk;       // 在偏移数组中的下标
+    uint64_t chunk_count;
+};
+
+struct Trailer {
+    uint64_t index_offset;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 24 && sizeof(BlockHeader) == 16 && sizeof(RunBegin) == 80 &&
+              sizeof(ChunkHeader) == 24 && sizeof(RunEnd) == 32 && sizeof(IndexEntry) == 64 &&
+              sizeof(Trailer) == 16, "trace structures must match the file layout");
+
+// 事件名与固件 EventType_t 的顺序一致
+uint8_t EventCode(std::string_view name);
+const char *EventName(uint8_t code);
+
+int64_t RealtimeNs();
+
+class TraceWriter {
+public:
+    static constexpr uint32_t kChunkRows = 4096;
+
+    TraceWriter() = default;
+    ~TraceWriter();
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    bool Open(const std::string &path);
+    // 结束所有未结束的记录，写入索引
+    bool Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    uint32_t BeginRun(uint16_t device, const std::string &device_path,
+                      const std::vector<std::string> &fields, int64_t start_ns);
+    void AddSample(uint32_t run_id, int64_t t_ns, uint32_t tick, const double *values);
+    void AddEvent(uint32_t run_id, int64_t t_ns, uint32_t tick, uint8_t type, int32_t value);
+    void EndRun(uint32_t run_id, int64_t end_ns);
+    // 写出所有未满的块，异常退出时最多丢失上次 Flush 之后的数据
+    void Flush();
+
+    uint64_t BytesWritten() const { return offset_; }
+    bool Failed() const { return failed_; }
+
+private:
+    struct OpenRun {
+        size_t record;                      // runs_ 中的下标
+        size_t field_count;
+        std::vector<int64_t> sample_ns;
+        std::vector<uint32_t> sample_tick;
+        std::vector<double> values;         // 按字段分列：values[k * kChunkRows + row]
+        std::vector<int64_t> event_ns;
+        std::vector<uint32_t> event_tick;
+        std::vector<int32_t> event_value;
+        std::vector<uint8_t> event_type;
+    };
+    struct RunRecord {
+        IndexEntry entry;
+        std::vector<uint64_t> chunks;
+    };
+
+    uint64_t WriteBlock(BlockType type, const std::vector<uint8_t> &payload);
+    void FlushSamples(uint32_t run_id, OpenRun &run);
+    void FlushEvents(uint32_t run_id, OpenRun &run);
+
+    int fd_ = -1;
+    bool failed_ = false;
+    uint64_t offset_ = 0;
+    uint32_t next_run_ = 1;
+    std::unordered_map<uint32_t, OpenRun> open_;
+    std::vector<RunRecord> runs_;                           // 按 run_id 顺序
+    std::vector<uint8_t> scratch_;
+};
+
+struct RunInfo {
+    uint32_t run_id;
+    uint16_t device;
+    bool complete;
+    std::string device_path;
+    std::vector<std::string> fields;
+    int64_t start_ns;
+    int64_t end_ns;
+    uint64_t samples;
+    uint64_t events;
+    std::vector<uint64_t> chunks;       // SAMPLES/EVENTS 块偏移
+};
+
+// 指向映射文件内部的列，Scan 回调期间有效（映射存在期间都有效）
+struct SampleChunk {
+    uint32_t rows;
+    const int64_t *t_ns;
+    const uint32_t *tick;
+    const double *const *columns;       // columns[k][row]
+};
+
+struct EventChunk {
+    uint32_t rows;
+    const int64_t *t_ns;
+    const uint32_t *tick;
+    const int32_t *value;
+    const uint8_t *type;
+};
+
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader &) = delete;
+    TraceReader &operator=(const TraceReader &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    const std::vector<RunInfo> &Runs() const { return runs_; }
+    const RunInfo *FindRun(uint32_t run_id) const;
+    // 没有有效索引，顺序扫描块头重建
+    bool Recovered() const { return recovered_; }
+    size_t Size() const { return size_; }
+
+    bool Scan(const RunInfo &run, const std::function<void(const SampleChunk &)> &on_samples,
+              const std::function<void(const EventChunk &)> &on_events) const;
+
+private:
+    const BlockHeader *BlockAt(uint64_t offset) const;
+    bool LoadIndex();
+    bool Rebuild();
+    bool ReadRunBegin(uint64_t offset, RunInfo *run) const;
+
+    const uint8_t *base_ = nullptr;
+    size_t size_ = 0;
+    bool recovered_ = false;
+    std::vector<RunInfo> runs_;
+};
+
+}  // namespace tip
+
+#endif  // __TIP_TRACE_H__
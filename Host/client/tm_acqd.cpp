@@ -0,0 +1,287 @@
+// tm_acqd: 采集守护进程，连接一个或多个设备，把采样、事件和电机状态写入 .tip 记录文件
+//
+// 用法: tm_acqd -o 记录.tip [-p 周期ms] [-F 字段,...] [-c] [-e 命令]... [-f 刷新s] <设备>...
+//   例: ./tm_acqd -o etch.tip /dev/ttyACM0 /dev/ttyACM1
+//       ./tm_acqd -o test.tip -c -e "START" /tmp/ttyTM        （连接 tm_emu）
+//
+// 连接后依次发送 UNSUBSCRIBE ALL、SET EVENTS 127、SUBSCRIBE <周期> <字段>，然后发送 -e 命令。
+// 默认每次刻蚀序列（SEQ_STATE 离开 0 到回到 0）为一次记录；-c 时每次连接为一次记录。
+// 默认字段 LASTDATA,POSITION,RATE,ROUND，周期 5 ms（固件遥测的最短周期）。
+// 所有设备在同一个 epoll 循环中处理；设备断开后结束其记录，每秒重试连接。
+// 每 -f 秒（默认1）写出未满的块，异常退出时最多丢失这段时间的数据；
+// SIGINT/SIGTERM 时结束所有记录并写入索引。
+
+#include "tip_client.h"
+#include "tip_trace.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr double kRetryUs = 1e6;
+constexpr int kTickMs = 100;
+constexpr uint8_t kEventSeqState = 2;   // EVENT_SEQ_STATE
+
+struct Options {
+    std::string output;
+    uint32_t period_ms = 5;
+    std::vector<std::string> fields = { "LASTDATA", "POSITION", "RATE", "ROUND" };
+    bool continuous = false;
+    std::vector<std::string> commands;
+    double flush_s = 1.0;
+};
+
+struct Device {
+    uint16_t index;
+    std::string path;
+    tip::Client client;
+    bool attached = false;
+    double retry_us = 0;
+    uint32_t telemetry_id = UINT32_MAX;
+    uint32_t run_id = 0;
+    bool have_tick = false;
+    uint32_t last_tick = 0;
+    std::vector<double> values;
+    uint64_t samples = 0;
+    uint64_t events = 0;
+    uint64_t gaps = 0;          // 相邻遥测帧间隔超过1.5个周期（帧被跳过或丢失）
+    uint64_t runs = 0;
+    uint64_t attaches = 0;
+};
+
+Options options;
+tip::TraceWriter writer;
+int epoll_fd = -1;
+
+double ParseValue(std::string_view raw) {
+    double value = NAN;
+    if (raw == "true") return 1;
+    if (raw == "false") return 0;
+    std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    return value;
+}
+
+void BeginRun(Device &dev) {
+    if (dev.run_id != 0) return;
+    dev.run_id = writer.BeginRun(dev.index, dev.path, options.fields, tip::RealtimeNs());
+    dev.have_tick = false;
+    dev.runs++;
+    fprintf(stderr, "tm_acqd: %s run %u started\n", dev.path.c_str(), dev.run_id);
+}
+
+void EndRun(Device &dev) {
+    if (dev.run_id == 0) return;
+    writer.EndRun(dev.run_id, tip::RealtimeNs());
+    fprintf(stderr, "tm_acqd: %s run %u ended\n", dev.path.c_str(), dev.run_id);
+    dev.run_id = 0;
+}
+
+void Detach(Device &dev, const char *reason) {
+    if (!dev.attached) return;
+    fprintf(stderr, "tm_acqd: %s detached (%s)\n", dev.path.c_str(), reason);
+    EndRun(dev);
+    dev.client.Close();     // 关闭后自动从外层 epoll 中移除
+    dev.attached = false;
+    dev.telemetry_id = UINT32_MAX;
+    dev.retry_us = tip::NowUs() + kRetryUs;
+}
+
+void OnTelemetry(Device &dev, const tip::Telemetry &telemetry) {
+    if (telemetry.id != dev.telemetry_id || dev.run_id == 0) return;
+
+    if (dev.have_tick && telemetry.tick - dev.last_tick > options.period_ms * 3 / 2) dev.gaps++;
+    dev.have_tick = true;
+    dev.last_tick = telemetry.tick;
+    for (size_t k = 0; k < options.fields.size(); k++) {
+        dev.values[k] = ParseValue(telemetry.fields.Raw(options.fields[k]));
+    }
+    writer.AddSample(dev.run_id, tip::RealtimeNs(), telemetry.tick, dev.values.data());
+    dev.samples++;
+}
+
+void OnEvent(Device &dev, const tip::Event &event) {
+    uint8_t code = tip::EventCode(event.name);
+
+    if (!options.continuous && code == kEventSeqState && event.value != 0) BeginRun(dev);
+    if (dev.run_id != 0) {
+        writer.AddEvent(dev.run_id, tip::RealtimeNs(), event.tick, code, event.value);
+        dev.events++;
+    }
+    if (!options.continuous && code == kEventSeqState && event.value == 0) EndRun(dev);
+}
+
+void Attach(Device &dev) {
+    if (!dev.client.Open(dev.path)) {
+        dev.retry_us = tip::NowUs() + kRetryUs;
+        return;
+    }
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = dev.index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, dev.client.Fd(), &ev);
+    dev.attached = true;
+    dev.attaches++;
+    dev.values.assign(options.fields.size(), NAN);
+
+    tip::Client &client = dev.client;
+    client.SetWindow(4);
+    client.SetTimeoutMs(2000);
+    client.OnTelemetry([&dev](const tip::Telemetry &t) { OnTelemetry(dev, t); });
+    client.OnEvent([&dev](const tip::Event &e) { OnEvent(dev, e); });
+
+    // 上次异常退出留下的订阅先清除
+    client.UnsubscribeAll(nullptr);
+    client.Set("EVENTS", "127", nullptr);
+    client.Subscribe(options.period_ms, options.fields, [&dev](tip::Outcome outcome, uint32_t id) {
+        if (outcome != tip::Outcome::kSuccess) {
+            Detach(dev, "SUBSCRIBE failed");
+            return;
+        }
+        dev.telemetry_id = id;
+        fprintf(stderr, "tm_acqd: %s attached, telemetry %u\n", dev.path.c_str(), id);
+    });
+    // 连接时序列已在运行（守护进程重启）也从当前开始记录
+    client.Get("SQSTATE", [&dev](tip::Outcome outcome, const tip::ParamValue &value) {
+        if (outcome != tip::Outcome::kSuccess) return;
+        if (options.continuous || value.AsDouble() != 0) BeginRun(dev);
+    });
+    for (const std::string &command : options.commands) {
+        client.Send(command, [&dev, command](const tip::Reply &reply) {
+            if (reply.outcome != tip::Outcome::kSuccess) {
+                fprintf(stderr, "tm_acqd: %s: %s: %s\n", dev.path.c_str(), command.c_str(),
+                        tip::OutcomeName(reply.outcome));
+            }
+        });
+    }
+}
+
+std::vector<std::string> SplitFields(const std::string &list) {
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > pos) fields.push_back(list.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    return fields;
+}
+
+void Usage() {
+    fprintf(stderr, "usage: tm_acqd -o trace.tip [-p period_ms] [-F FIELD,...] [-c] [-e command]... "
+                    "[-f flush_s] <device>...\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:p:F:ce:f:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            options.output = optarg;
+            break;
+        case 'p':
+            options.period_ms = static_cast<uint32_t>(atoi(optarg));
+            break;
+        case 'F':
+            options.fields = SplitFields(optarg);
+            break;
+        case 'c':
+            options.continuous = true;
+            break;
+        case 'e':
+            options.commands.push_back(optarg);
+            break;
+        case 'f':
+            options.flush_s = atof(optarg);
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    // 固件每个订阅最多8个字段
+    if (options.output.empty() || optind >= argc || options.fields.empty() || options.fields.size() > 8) {
+        Usage();
+        return 1;
+    }
+    if (!writer.Open(options.output)) return 1;
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    int signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = UINT32_MAX;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+
+    std::vector<std::unique_ptr<Device>> devices;
+    for (int i = optind; i < argc; i++) {
+        auto dev = std::make_unique<Device>();
+        dev->index = static_cast<uint16_t>(devices.size());
+        dev->path = argv[i];
+        devices.push_back(std::move(dev));
+    }
+    for (auto &dev : devices) Attach(*dev);
+
+    double next_flush_us = tip::NowUs() + options.flush_s * 1e6;
+    bool running = true;
+    while (running) {
+        struct epoll_event events[16];
+        int n = epoll_wait(epoll_fd, events, 16, kTickMs);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == UINT32_MAX) {
+                running = false;
+                continue;
+            }
+            Device &dev = *devices[events[i].data.u32];
+            if (dev.attached && dev.client.Poll(0) < 0) Detach(dev, "read error");
+        }
+
+        // 超时检查、重连与定期写出
+        double now = tip::NowUs();
+        for (auto &dev : devices) {
+            if (dev->attached && dev->client.InFlight() > 0 && dev->client.Poll(0) < 0) {
+                Detach(*dev, "closed");
+            }
+            if (!dev->attached && now >= dev->retry_us) Attach(*dev);
+        }
+        if (now >= next_flush_us) {
+            writer.Flush();
+            next_flush_us = now + options.flush_s * 1e6;
+            if (writer.Failed()) break;
+        }
+    }
+
+    for (auto &dev : devices) EndRun(*dev);
+    bool ok = writer.Close();
+    for (auto &dev : devices) {
+        fprintf(stderr, "tm_acqd: %s: %llu runs, %llu samples, %llu events, %llu gaps, %llu attaches\n",
+                dev->path.c_str(), static_cast<unsigned long long>(dev->runs),
+                static_cast<unsigned long long>(dev->samples), static_cast<unsigned long long>(dev->events),
+                static_cast<unsigned long long>(dev->gaps), static_cast<unsigned long long>(dev->attaches));
+    }
+    fprintf(stderr, "tm_acqd: %s, %llu bytes\n", options.output.c_str(),
+            static_cast<unsigned long long>(writer.BytesWritten()));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,682 @@
+// tm_farm: 多台设备的刻蚀作业调度，所有设备在同一个 epoll 循环中驱动（每台设备不单独开线程）
+//
+// 用法: tm_farm [-d 设备模式]... [-J 作业文件] [-n 次数] [-g 间隔s] [-t 作业超时s]
+//               [-s 数据流.jsonl|-] [-o 记录.tip] [-p 周期ms] [-F 字段,...] [-r 报告间隔s] [设备]...
+//   例: ./tm_farm -J etch.farm -s - > farm.jsonl
+//       ./tm_farm -d '/tmp/ttyF*' -n 40 -o farm.tip          （连接多个 tm_emu）
+//
+// 设备：命令行给出的路径，加上 -d 通配模式（可多次，都没有时为 /dev/ttyACM*）每2秒重新匹配的结果。
+// 连接后先 PING 确认是刻蚀设备，再清除旧订阅、开启全部事件，需要数据流或记录时订阅遥测，
+// 最后读取 SQSTATE：序列正在运行（不是本进程启动的）的设备等其结束后再分配作业。
+//
+// 作业文件与 tm_sim 脚本写法相同：
+//   job <次数> [标签]     以当前命令加入若干个作业
+//   其他行                作为固件命令在 START 之前依次发送（如 SET THRES 40），按出现顺序累积
+// 没有作业文件时 -n 给出不带命令的作业数；都没有时只汇总数据流，直到 Ctrl-C。
+//
+// 空闲设备按顺序从队列取作业：发送命令，全部成功后 START，序列回到 IDLE 时结束。结果：
+//   ok         出现 CUTOFF 后序列结束（得到一根针尖）
+//   no_cutoff  序列结束但没有 CUTOFF
+//   stall      序列中出现 STALL
+//   rejected   命令或 START 被拒绝
+//   timeout    超过 -t 秒（默认600）未结束，断开设备，重新连接后按 SQSTATE 判断状态
+//   lost       设备断开，作业放回队首重新分配（最多3次）
+// 每台设备两次作业之间间隔 -g 秒（默认0，用于更换丝材）。
+//
+// 数据流（-s）每行一个 JSON 对象：设备的遥测帧和事件原样转发并加上 "Dev"、"Job"、"HostMs"，
+// 另有作业开始和结束行（"JobState"）。-o 把每次序列写入 .tip 记录文件（格式同 tm_acqd）。
+// 每台设备每秒 PING 一次，报告往返延迟；每 -r 秒（默认10）输出进度，结束时输出每台设备的
+// 作业数、针尖产率（tips/h）、作业耗时和延迟。
+
+#include "tip_client.h"
+#include "tip_trace.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <glob.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr double kRetryUs = 1e6;
+constexpr double kProbeRetryUs = 30e6;      // PING 无应答（不是刻蚀设备）后的重试间隔
+constexpr double kScanUs = 2e6;
+constexpr double kPingUs = 1e6;
+constexpr double kFlushUs = 1e6;
+constexpr int kTickMs = 100;
+constexpr uint32_t kMaxAttempts = 3;
+constexpr uint8_t kEventCutoff = 0;         // EVENT_CUTOFF
+constexpr uint8_t kEventSeqState = 2;       // EVENT_SEQ_STATE
+constexpr uint8_t kEventStall = 5;          // EVENT_STALL
+
+struct Options {
+    std::vector<std::string> patterns;
+    std::string job_file;
+    uint32_t count = 0;
+    double gap_s = 0;
+    double timeout_s = 600;
+    std::string stream;
+    std::string output;
+    uint32_t period_ms = 5;
+    std::vector<std::string> fields = { "LASTDATA", "POSITION", "RATE", "ROUND" };
+    double report_s = 10;
+};
+
+struct JobSpec {
+    std::string label;
+    std::vector<std::string> commands;
+};
+
+struct Job {
+    uint32_t id;
+    size_t spec;
+    uint32_t attempts;
+};
+
+enum JobOutcome { kOk = 0, kNoCutoff, kStall, kRejected, kTimeout, kLost, kOutcomeCount };
+const char *const kOutcomeNames[] = { "ok", "no_cutoff", "stall", "rejected", "timeout", "lost" };
+
+enum class State {
+    kDetached,
+    kProbing,       // 连接后的初始化命令在途
+    kIdle,
+    kSetup,         // 作业命令在途
+    kRunning,       // 已发送 START
+    kBusy,          // 连接时序列已在运行
+};
+
+struct Device {
+    uint16_t index;
+    std::string path;
+    std::string name;
+    tip::Client client;
+    State state = State::kDetached;
+    double retry_us = 0;
+    double ready_us = 0;            // 下一次可以开始作业的时间（-g）
+    double next_ping_us = 0;
+    uint32_t ping_nonce = 0;
+    uint32_t telemetry_id = UINT32_MAX;
+
+    Job job = {};
+    bool has_job = false;
+    size_t pending = 0;             // 作业命令未收到的应答数
+    bool setup_failed = false;
+    double job_start_us = 0;
+    double cutoff_us = 0;
+    bool stalled = false;
+    bool seq_active = false;
+
+    uint32_t run_id = 0;
+    std::vector<double> values;
+
+    uint64_t jobs = 0;
+    uint64_t outcomes[kOutcomeCount] = {};
+    std::vector<double> job_s;
+    std::vector<double> rtt_us;
+    uint64_t attaches = 0;
+};
+
+Options options;
+std::vector<JobSpec> specs;
+std::deque<Job> queue;
+uint32_t total_jobs = 0;
+uint32_t finished_jobs = 0;
+std::map<std::string, std::array<uint64_t, kOutcomeCount>> label_outcomes;
+
+std::vector<std::unique_ptr<Device>> devices;
+std::map<std::string, size_t> known_paths;
+FILE *stream = nullptr;
+tip::TraceWriter writer;
+int epoll_fd = -1;
+double start_us = 0;
+
+double ParseValue(std::string_view raw) {
+    double value = NAN;
+    if (raw == "true") return 1;
+    if (raw == "false") return 0;
+    std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    return value;
+}
+
+std::string BaseName(const std::string &path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool Streaming() {
+    return stream != nullptr || writer.IsOpen();
+}
+
+// 数据流行头：设备名、当前作业、主机时间；调用者补上其余字段和 "}\n"
+void StreamHead(const Device &dev) {
+    fprintf(stream, "{\"Dev\":\"%s\"", dev.name.c_str());
+    if (dev.has_job) fprintf(stream, ",\"Job\":%u", dev.job.id);
+    fprintf(stream, ",\"HostMs\":%.3f", (tip::NowUs() - start_us) / 1e3);
+}
+
+void StreamLine(const Device &dev, const tip::JsonView &json) {
+    if (stream == nullptr) return;
+    StreamHead(dev);
+    for (size_t i = 0; i < json.Size(); i++) {
+        std::string_view key = json.Key(i), raw = json.Raw(i);
+        fprintf(stream, ",\"%.*s\":%.*s", static_cast<int>(key.size()), key.data(), static_cast<int>(raw.size()),
+                raw.data());
+    }
+    fputs("}\n", stream);
+}
+
+void BeginRun(Device &dev) {
+    if (!writer.IsOpen() || dev.run_id != 0) return;
+    dev.run_id = writer.BeginRun(dev.index, dev.path, options.fields, tip::RealtimeNs());
+}
+
+void EndRun(Device &dev) {
+    if (dev.run_id == 0) return;
+    writer.EndRun(dev.run_id, tip::RealtimeNs());
+    dev.run_id = 0;
+}
+
+void FinishJob(Device &dev, JobOutcome outcome) {
+    if (!dev.has_job) return;
+    const JobSpec &spec = specs[dev.job.spec];
+    double now = tip::NowUs();
+    double seconds = dev.job_start_us > 0 ? (now - dev.job_start_us) / 1e6 : 0;
+
+    if (stream != nullptr) {
+        StreamHead(dev);
+        fprintf(stream, ",\"Label\":\"%s\",\"JobState\":\"end\",\"Outcome\":\"%s\",\"Seconds\":%.3f",
+                spec.label.c_str(), kOutcomeNames[outcome], seconds);
+        if (dev.cutoff_us > 0) fprintf(stream, ",\"CutoffS\":%.3f", (dev.cutoff_us - dev.job_start_us) / 1e6);
+        fputs("}\n", stream);
+    }
+
+    dev.outcomes[outcome]++;
+    if (outcome == kLost && ++dev.job.attempts < kMaxAttempts) {
+        queue.push_front(dev.job);
+    } else {
+        dev.jobs++;
+        if (outcome == kOk) dev.job_s.push_back(seconds);
+        label_outcomes[spec.label][outcome]++;
+        finished_jobs++;
+    }
+    dev.has_job = false;
+    dev.ready_us = now + options.gap_s * 1e6;
+    if (dev.state == State::kSetup || dev.state == State::kRunning) dev.state = State::kIdle;
+}
+
+void Detach(Device &dev, const char *reason, double retry_us) {
+    if (dev.state == State::kDetached) return;
+    fprintf(stderr, "tm_farm: %s detached (%s)\n", dev.name.c_str(), reason);
+    FinishJob(dev, kLost);
+    EndRun(dev);
+    dev.client.Close();     // 关闭后自动从外层 epoll 中移除
+    dev.state = State::kDetached;
+    dev.telemetry_id = UINT32_MAX;
+    dev.retry_us = tip::NowUs() + retry_us;
+}
+
+void OnTelemetry(Device &dev, const tip::Telemetry &telemetry) {
+    if (telemetry.id != dev.telemetry_id) return;
+    StreamLine(dev, telemetry.fields);
+    if (dev.run_id == 0) return;
+    for (size_t k = 0; k < options.fields.size(); k++) {
+        dev.values[k] = ParseValue(telemetry.fields.Raw(options.fields[k]));
+    }
+    writer.AddSample(dev.run_id, tip::RealtimeNs(), telemetry.tick, dev.values.data());
+}
+
+void OnEvent(Device &dev, const tip::Event &event) {
+    uint8_t code = tip::EventCode(event.name);
+
+    if (code == kEventSeqState && event.value != 0) BeginRun(dev);
+    StreamLine(dev, event.fields);
+    if (dev.run_id != 0) writer.AddEvent(dev.run_id, tip::RealtimeNs(), event.tick, code, event.value);
+
+    if (dev.state == State::kRunning) {
+        if (code == kEventCutoff && dev.cutoff_us == 0) dev.cutoff_us = tip::NowUs();
+        if (code == kEventStall) dev.stalled = true;
+        if (code == kEventSeqState && event.value != 0) dev.seq_active = true;
+    }
+    if (code == kEventSeqState && event.value == 0) {
+        EndRun(dev);
+        if (dev.state == State::kBusy) dev.state = State::kIdle;
+        if (dev.state == State::kRunning && dev.seq_active) {
+            FinishJob(dev, dev.stalled ? kStall : dev.cutoff_us > 0 ? kOk : kNoCutoff);
+        }
+    }
+}
+
+void SendStart(Device &dev) {
+    dev.state = State::kRunning;
+    dev.job_start_us = tip::NowUs();
+    dev.client.Start([&dev](tip::Outcome outcome) {
+        if (outcome == tip::Outcome::kSuccess || dev.state != State::kRunning) return;
+        if (outcome == tip::Outcome::kError) {
+            FinishJob(dev, kRejected);
+        } else {
+            Detach(dev, tip::OutcomeName(outcome), kRetryUs);
+        }
+    });
+}
+
+void StartJob(Device &dev, const Job &job) {
+    const JobSpec &spec = specs[job.spec];
+
+    dev.job = job;
+    dev.has_job = true;
+    dev.state = State::kSetup;
+    dev.pending = spec.commands.size();
+    dev.setup_failed = false;
+    dev.job_start_us = 0;
+    dev.cutoff_us = 0;
+    dev.stalled = false;
+    dev.seq_active = false;
+    if (stream != nullptr) {
+        StreamHead(dev);
+        fprintf(stream, ",\"Label\":\"%s\",\"JobState\":\"start\"}\n", spec.label.c_str());
+    }
+    if (dev.pending == 0) {
+        SendStart(dev);
+        return;
+    }
+    // 命令流水线发送，全部成功后才 START
+    for (const std::string &command : spec.commands) {
+        dev.client.Send(command, [&dev, command](const tip::Reply &reply) {
+            if (dev.state != State::kSetup) return;
+            if (reply.outcome == tip::Outcome::kTimeout || reply.outcome == tip::Outcome::kClosed) {
+                Detach(dev, tip::OutcomeName(reply.outcome), kRetryUs);
+                return;
+            }
+            if (reply.outcome != tip::Outcome::kSuccess) {
+                fprintf(stderr, "tm_farm: %s: job %u: %s rejected\n", dev.name.c_str(), dev.job.id, command.c_str());
+                dev.setup_failed = true;
+            }
+            if (--dev.pending > 0) return;
+            if (dev.setup_failed) {
+                FinishJob(dev, kRejected);
+            } else {
+                SendStart(dev);
+            }
+        });
+    }
+}
+
+void Attach(Device &dev) {
+    if (!dev.client.Open(dev.path)) {
+        dev.retry_us = tip::NowUs() + kRetryUs;
+        return;
+    }
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = dev.index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, dev.client.Fd(), &ev);
+    dev.state = State::kProbing;
+    dev.attaches++;
+    dev.values.assign(options.fields.size(), NAN);
+    dev.next_ping_us = tip::NowUs() + kPingUs;
+
+    tip::Client &client = dev.client;
+    client.SetWindow(4);
+    client.SetTimeoutMs(2000);
+    client.OnTelemetry([&dev](const tip::Telemetry &t) { OnTelemetry(dev, t); });
+    client.OnEvent([&dev](const tip::Event &e) { OnEvent(dev, e); });
+    client.OnUnsolicited([&dev](const tip::JsonView &json) { StreamLine(dev, json); });
+
+    client.Ping(++dev.ping_nonce, [&dev](tip::Outcome outcome, const tip::PingResult &) {
+        if (outcome != tip::Outcome::kSuccess) Detach(dev, "no PING reply", kProbeRetryUs);
+    });
+    client.UnsubscribeAll(nullptr);
+    client.Set("EVENTS", "127", nullptr);
+    if (Streaming()) {
+        client.Subscribe(options.period_ms, options.fields, [&dev](tip::Outcome outcome, uint32_t id) {
+            if (outcome == tip::Outcome::kSuccess) dev.telemetry_id = id;
+        });
+    }
+    client.Get("SQSTATE", [&dev](tip::Outcome outcome, const tip::ParamValue &value) {
+        if (dev.state != State::kProbing) return;
+        if (outcome != tip::Outcome::kSuccess) {
+            Detach(dev, "GET SQSTATE failed", kRetryUs);
+            return;
+        }
+        if (value.AsDouble() != 0) {
+            dev.state = State::kBusy;
+            BeginRun(dev);
+        } else {
+            dev.state = State::kIdle;
+        }
+        fprintf(stderr, "tm_farm: %s attached%s\n", dev.name.c_str(), dev.state == State::kBusy ? " (busy)" : "");
+    });
+}
+
+void AddDevice(const std::string &path) {
+    if (known_paths.count(path) != 0) return;
+    auto dev = std::make_unique<Device>();
+    dev->index = static_cast<uint16_t>(devices.size());
+    dev->path = path;
+    dev->name = BaseName(path);
+    known_paths[path] = devices.size();
+    devices.push_back(std::move(dev));
+    Attach(*devices.back());
+}
+
+void Discover() {
+    for (const std::string &pattern : options.patterns) {
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) AddDevice(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+    }
+}
+
+void Ping(Device &dev) {
+    dev.next_ping_us = tip::NowUs() + kPingUs;
+    dev.client.Ping(++dev.ping_nonce, [&dev](tip::Outcome outcome, const tip::PingResult &result) {
+        if (outcome == tip::Outcome::kSuccess) {
+            dev.rtt_us.push_back(result.rtt_us);
+        } else if (outcome == tip::Outcome::kTimeout) {
+            Detach(dev, "PING timeout", kRetryUs);
+        }
+    });
+}
+
+// 空闲设备从队首取作业；设备按编号轮流，避免总由前几台设备承担
+void Schedule(double now) {
+    static size_t next = 0;
+
+    for (size_t n = 0; n < devices.size() && !queue.empty(); n++) {
+        Device &dev = *devices[(next + n) % devices.size()];
+        if (dev.state != State::kIdle || dev.has_job || now < dev.ready_us) continue;
+        Job job = queue.front();
+        queue.pop_front();
+        next = (dev.index + 1) % devices.size();
+        StartJob(dev, job);
+    }
+}
+
+void CheckTimeouts(double now) {
+    for (auto &dev : devices) {
+        if (dev->state != State::kRunning || now - dev->job_start_us < options.timeout_s * 1e6) continue;
+        // 序列状态未知，断开后重新连接并按 SQSTATE 判断
+        FinishJob(*dev, kTimeout);
+        Detach(*dev, "job timeout", kRetryUs);
+    }
+}
+
+size_t CountState(State state) {
+    return static_cast<size_t>(std::count_if(devices.begin(), devices.end(),
+                                             [state](const auto &dev) { return dev->state == state; }));
+}
+
+uint64_t TotalOk() {
+    uint64_t ok = 0;
+    for (const auto &dev : devices) ok += dev->outcomes[kOk];
+    return ok;
+}
+
+void Progress(double now) {
+    double hours = (now - start_us) / 3.6e9;
+    size_t attached = devices.size() - CountState(State::kDetached);
+    fprintf(stderr, "tm_farm: %.0f s, %zu/%zu devices attached, %zu running, jobs %u/%u done, %zu queued, "
+                    "%.1f tips/h\n", (now - start_us) / 1e6, attached, devices.size(),
+            CountState(State::kSetup) + CountState(State::kRunning), finished_jobs, total_jobs, queue.size(),
+            hours > 0 ? TotalOk() / hours : 0.0);
+}
+
+double Percentile(std::vector<double> &values, int pct) {
+    if (values.empty()) return 0;
+    size_t index = std::min(values.size() * static_cast<size_t>(pct) / 100, values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + static_cast<long>(index), values.end());
+    return values[index];
+}
+
+void Report(FILE *out, double now) {
+    double hours = (now - start_us) / 3.6e9;
+
+    fprintf(out, "%-16s %6s %6s %6s %8s %8s %8s %8s %8s %8s\n", "device", "jobs", "ok", "failed", "tips/h", "job_p50",
+           "rtt_p50", "rtt_p99", "rtt_max", "attaches");
+    fprintf(out, "%-16s %6s %6s %6s %8s %8s %8s %8s %8s %8s\n", "", "", "", "", "", "s", "ms", "ms", "ms", "");
+    for (auto &dev : devices) {
+        fprintf(out, "%-16s %6llu %6llu %6llu %8.1f %8.2f %8.2f %8.2f %8.2f %8llu\n", dev->name.c_str(),
+               static_cast<unsigned long long>(dev->jobs), static_cast<unsigned long long>(dev->outcomes[kOk]),
+               static_cast<unsigned long long>(dev->jobs - dev->outcomes[kOk]),
+               hours > 0 ? dev->outcomes[kOk] / hours : 0.0, Percentile(dev->job_s, 50),
+               Percentile(dev->rtt_us, 50) / 1e3, Percentile(dev->rtt_us, 99) / 1e3,
+               Percentile(dev->rtt_us, 100) / 1e3, static_cast<unsigned long long>(dev->attaches));
+    }
+    for (const auto &[label, counts] : label_outcomes) {
+        fprintf(out, "%s:", label.c_str());
+        for (int k = 0; k < kOutcomeCount; k++) {
+            if (counts[k] != 0) fprintf(out, " %s %llu", kOutcomeNames[k], static_cast<unsigned long long>(counts[k]));
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "%u/%u jobs in %.1f s, %llu tips, %.1f tips/h on %zu devices\n", finished_jobs, total_jobs,
+           (now - start_us) / 1e6, static_cast<unsigned long long>(TotalOk()), hours > 0 ? TotalOk() / hours : 0.0,
+           devices.size());
+}
+
+void AddJobs(size_t spec, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) queue.push_back(Job{ ++total_jobs, spec, 0 });
+}
+
+char *Trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    char *end = s + strlen(s);
+    while (end > s && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+    return s;
+}
+
+// 作业文件：与 tm_sim 脚本相同，命令按出现顺序累积，job 行以当前命令加入作业
+bool LoadJobs(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        fprintf(stderr, "tm_farm: %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    std::vector<std::string> commands;
+    char buf[256];
+    int line_no = 0;
+
+    while (fgets(buf, sizeof(buf), file) != nullptr) {
+        char *line = Trim(buf);
+        unsigned count;
+        int label_pos = 0;
+
+        line_no++;
+        if (*line == '\0' || *line == '#') continue;
+        if (sscanf(line, "job %u %n", &count, &label_pos) == 1) {
+            std::string label = label_pos > 0 && line[label_pos] ? line + label_pos : "";
+            if (label.empty()) label = "job" + std::to_string(specs.size() + 1);
+            specs.push_back(JobSpec{ label, commands });
+            AddJobs(specs.size() - 1, count);
+        } else if (strcmp(line, "START") == 0) {
+            fprintf(stderr, "tm_farm: line %d: START is sent by each job\n", line_no);
+            fclose(file);
+            return false;
+        } else {
+            commands.push_back(line);
+        }
+    }
+    fclose(file);
+    if (specs.empty()) {
+        fprintf(stderr, "tm_farm: %s has no job line\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> SplitFields(const std::string &list) {
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > pos) fields.push_back(list.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    return fields;
+}
+
+void Usage() {
+    fprintf(stderr, "usage: tm_farm [-d pattern]... [-J jobs.farm] [-n count] [-g gap_s] [-t timeout_s] "
+                    "[-s stream.jsonl|-] [-o trace.tip] [-p period_ms] [-F FIELD,...] [-r report_s] [device]...\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:J:n:g:t:s:o:p:F:r:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            options.patterns.push_back(optarg);
+            break;
+        case 'J':
+            options.job_file = optarg;
+            break;
+        case 'n':
+            options.count = static_cast<uint32_t>(atoi(optarg));
+            break;
+        case 'g':
+            options.gap_s = atof(optarg);
+            break;
+        case 't':
+            options.timeout_s = atof(optarg);
+            break;
+        case 's':
+            options.stream = optarg;
+            break;
+        case 'o':
+            options.output = optarg;
+            break;
+        case 'p':
+            options.period_ms = static_cast<uint32_t>(atoi(optarg));
+            break;
+        case 'F':
+            options.fields = SplitFields(optarg);
+            break;
+        case 'r':
+            options.report_s = atof(optarg);
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    // 固件每个订阅最多8个字段
+    if (options.fields.empty() || options.fields.size() > 8 || options.report_s <= 0) {
+        Usage();
+        return 1;
+    }
+    if (options.patterns.empty() && optind >= argc) options.patterns.push_back("/dev/ttyACM*");
+
+    if (!options.job_file.empty()) {
+        if (!LoadJobs(options.job_file)) return 1;
+    } else if (options.count > 0) {
+        specs.push_back(JobSpec{ "job", {} });
+        AddJobs(0, options.count);
+    }
+    if (options.stream == "-") {
+        stream = stdout;
+    } else if (!options.stream.empty()) {
+        stream = fopen(options.stream.c_str(), "w");
+        if (stream == nullptr) {
+            fprintf(stderr, "tm_farm: %s: %s\n", options.stream.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+    if (!options.output.empty() && !writer.Open(options.output)) return 1;
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    int signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = UINT32_MAX;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+
+    start_us = tip::NowUs();
+    for (int i = optind; i < argc; i++) AddDevice(argv[i]);
+    Discover();
+
+    double next_scan_us = start_us + kScanUs;
+    double next_flush_us = start_us + kFlushUs;
+    double next_report_us = start_us + options.report_s * 1e6;
+    bool running = true;
+    while (running) {
+        struct epoll_event events[64];
+        int n = epoll_wait(epoll_fd, events, 64, kTickMs);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == UINT32_MAX) {
+                running = false;
+                continue;
+            }
+            Device &dev = *devices[events[i].data.u32];
+            if (dev.state != State::kDetached && dev.client.Poll(0) < 0) Detach(dev, "read error", kRetryUs);
+        }
+
+        // 超时检查、PING、重连、设备发现与作业分配
+        double now = tip::NowUs();
+        for (auto &dev : devices) {
+            if (dev->state == State::kDetached) {
+                // 已拔出的设备不再尝试打开，重新出现后再连接
+                if (now >= dev->retry_us && access(dev->path.c_str(), F_OK) == 0) Attach(*dev);
+                continue;
+            }
+            if (dev->client.InFlight() > 0 && dev->client.Poll(0) < 0) {
+                Detach(*dev, "closed", kRetryUs);
+                continue;
+            }
+            if (dev->state != State::kProbing && now >= dev->next_ping_us) Ping(*dev);
+        }
+        if (now >= next_scan_us) {
+            Discover();
+            next_scan_us = now + kScanUs;
+        }
+        CheckTimeouts(now);
+        Schedule(now);
+
+        if (stream != nullptr) fflush(stream);
+        if (writer.IsOpen() && now >= next_flush_us) {
+            writer.Flush();
+            next_flush_us = now + kFlushUs;
+        }
+        if (now >= next_report_us) {
+            Progress(now);
+            next_report_us = now + options.report_s * 1e6;
+        }
+        // 全部作业结束后退出；没有作业时一直运行到收到信号
+        if (total_jobs > 0 && finished_jobs == total_jobs) running = false;
+    }
+
+    double end_us = tip::NowUs();
+    for (auto &dev : devices) EndRun(*dev);
+    bool ok = !writer.IsOpen() || writer.Close();
+    if (stream != nullptr && stream != stdout) fclose(stream);
+    // 数据流写到标准输出时报告写到标准错误，避免混在一起
+    Report(stream == stdout ? stderr : stdout, end_us);
+    return ok ? 0 : 1;
+}
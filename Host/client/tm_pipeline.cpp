@@ -0,0 +1,137 @@
+// tm_pipeline: 用 tip_client 测量不同流水线深度下的命令吞吐量和往返延迟
+//
+// 用法: tm_pipeline [-n 每档命令数] [-w 窗口1,窗口2,...] [-c 命令] <串口设备>
+//   例: ./tm_pipeline -n 2000 -w 1,2,4,8,16 /dev/ttyACM0
+//       ./tm_pipeline -c "GET FREQ" /tmp/ttyTM        （连接 tm_emu）
+//
+// 每档窗口连续发送 n 条命令，窗口为同时在途的命令数。默认命令为 PING，
+// 此时另外输出固件耗时 (Tx - Rx)。有超时、错误或应答不匹配时返回2。
+
+#include "tip_client.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Series {
+    std::vector<double> rtt_us;
+    std::vector<double> device_us;
+    unsigned failures = 0;
+};
+
+double Percentile(std::vector<double> &values, int pct) {
+    if (values.empty()) return 0;
+    size_t index = values.size() * static_cast<size_t>(pct) / 100;
+    std::nth_element(values.begin(), values.begin() + static_cast<long>(std::min(index, values.size() - 1)),
+                     values.end());
+    return values[std::min(index, values.size() - 1)];
+}
+
+// 保持窗口满载：每收到一个应答就补发一条，直到发满 count 条
+void RunWindow(tip::Client &client, size_t window, const std::string &command, unsigned count,
+               Series &series) {
+    unsigned issued = 0;
+    std::function<void()> issue;
+
+    issue = [&]() {
+        uint32_t nonce = ++issued;
+        if (command.empty()) {
+            client.Ping(nonce, [&, nonce](tip::Outcome outcome, const tip::PingResult &result) {
+                series.rtt_us.push_back(result.rtt_us);
+                series.device_us.push_back(result.device_us());
+                if (outcome != tip::Outcome::kSuccess || result.nonce != nonce) series.failures++;
+                if (issued < count) issue();
+            });
+        } else {
+            client.Send(command, [&](const tip::Reply &reply) {
+                series.rtt_us.push_back(reply.rtt_us);
+                if (reply.outcome != tip::Outcome::kSuccess) series.failures++;
+                if (issued < count) issue();
+            });
+        }
+    };
+
+    client.SetWindow(window);
+    while (issued < count && issued < window) issue();
+    client.RunUntilIdle();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    unsigned count = 2000;
+    std::vector<size_t> windows = { 1, 2, 4, 8, 16 };
+    std::string command;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:c:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = static_cast<unsigned>(atoi(optarg));
+            if (count < 1) count = 1;
+            break;
+        case 'w': {
+            windows.clear();
+            std::string list = optarg;
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                int window = atoi(list.substr(pos, comma - pos).c_str());
+                if (window > 0) windows.push_back(static_cast<size_t>(window));
+                pos = comma + 1;
+            }
+            break;
+        }
+        case 'c':
+            command = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-w w1,w2,...] [-c command] <serial device>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc || windows.empty()) {
+        fprintf(stderr, "usage: %s [-n count] [-w w1,w2,...] [-c command] <serial device>\n", argv[0]);
+        return 1;
+    }
+
+    tip::Client client;
+    if (!client.Open(argv[optind])) return 1;
+
+    printf("%-6s %10s %10s %10s %10s %10s\n", "window", "cmd/s", "rtt p50", "rtt p99", "rtt max",
+           command.empty() ? "fw p50" : "");
+    bool failed = false;
+    for (size_t window : windows) {
+        Series series;
+        double start = tip::NowUs();
+        RunWindow(client, window, command, count, series);
+        double elapsed_s = (tip::NowUs() - start) / 1e6;
+
+        if (!client.IsOpen()) {
+            fprintf(stderr, "connection closed\n");
+            return 2;
+        }
+        printf("%-6zu %10.0f %10.1f %10.1f %10.1f", window, series.rtt_us.size() / elapsed_s,
+               Percentile(series.rtt_us, 50), Percentile(series.rtt_us, 99), Percentile(series.rtt_us, 100));
+        if (!series.device_us.empty()) printf(" %10.1f", Percentile(series.device_us, 50));
+        printf("\n");
+        if (series.failures > 0) {
+            printf("       %u failed\n", series.failures);
+            failed = true;
+        }
+    }
+
+    const tip::Client::Stats &stats = client.GetStats();
+    printf("sent %llu, replies %llu, timeouts %llu, unmatched %llu, telemetry %llu, events %llu\n",
+           static_cast<unsigned long long>(stats.sent), static_cast<unsigned long long>(stats.replies),
+           static_cast<unsigned long long>(stats.timeouts), static_cast<unsigned long long>(stats.unmatched),
+           static_cast<unsigned long long>(stats.telemetry), static_cast<unsigned long long>(stats.events));
+    return failed || stats.timeouts > 0 || stats.unmatched > 0 ? 2 : 0;
+}
@@ -0,0 +1,481 @@
+// tm_replay: 把记录的电流曲线（.tip）回放给固件的断线检测代码，评估不同算法与阈值
+//
+// 用法: tm_replay [-a 算法,...] [-T 阈值列表] [-l 标注.csv] [-m 漏检超时ms] [-F 字段]
+//                 [-j 并行数] [-o 结果.csv] <记录.tip>...
+//   例: ./tm_replay -T 20:80:5 -o sweep.csv traces/*.tip
+//       ./tm_replay -a firmware -T 30,40,50 -l labels.csv etch.tip
+//
+// 检测代码直接链接 libtip_host.a：采样经 SystemState_UpdateCurrent 写入固件的电流缓冲区，
+// 再由各算法判断（firmware 即 SEQ_MONITOR_CURRENT 调用的 SystemState_CurrentBelowThreshold）。
+// 阈值列表可写成 40、30,40,50 或 起:止:步长。
+//
+// 断线时刻（标注）按以下顺序确定：
+//   -l 标注文件，每行 <记录文件名>,<记录号>,<断线tick>（文件名不含目录）
+//   记录中的 CUTOFF 事件（即录制时固件的判断，此时延迟为相对原判断的提前/滞后）
+//   都没有时视为未断线，任何触发都是误触发
+// 从 SEQ_STATE 进入 MONITOR_CURRENT 开始判断（没有该事件时从第一个采样开始），之前的采样只写入缓冲区。
+//
+// 每次记录、每个算法与阈值的结果：
+//   延迟   = 标注到首次触发的时间（ms，分辨率为遥测周期）
+//   误触发 = 首次触发在标注之前；误触发次数为标注前检测结果由假变真的次数（固件只会响应第一次）
+//   漏检   = 标注后 -m ms（默认2000）内未触发
+//   CPU    = 每个采样的写缓冲区与判断耗时（ns）
+// 每个组合在 fork 出的子进程中计算（固件状态为全局变量），记录文件在 fork 前映射，子进程共享页缓存。
+//
+// 注意：记录中的采样是遥测周期（默认5ms）抽样的，固件实际约每1ms得到一个采样，
+// 缓冲区覆盖的时间窗因此比固件上长；CUTOFF 之后电流开关已断开，记录的电流不再反映断线过程。
+
+#include "tip_client.h"
+#include "tip_trace.h"
+
+extern "C" {
+#include "system_state.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t kEventCutoff = 0;         // EVENT_CUTOFF
+constexpr uint8_t kEventSeqState = 2;       // EVENT_SEQ_STATE
+constexpr int32_t kSeqMonitorCurrent = 3;   // SEQ_MONITOR_CURRENT
+constexpr uint32_t kNoTick = UINT32_MAX;
+
+// 候选检测算法：采样已写入 g_system_state.current_buffer，返回是否判定断线
+struct Detector {
+    const char *name;
+    bool (*below)(void);
+};
+
+// 缓冲区均值低于阈值（对单个噪声尖峰不敏感，但对瞬时跌落更敏感）
+bool MeanBelowThreshold() {
+    int32_t sum = 0;
+    for (int i = 0; i < BUFFER_SIZE; i++) sum += g_system_state.current_buffer[i];
+    return sum < static_cast<int32_t>(g_system_state.threshold) * BUFFER_SIZE;
+}
+
+const Detector kDetectors[] = {
+    { "firmware", SystemState_CurrentBelowThreshold },
+    { "mean", MeanBelowThreshold },
+};
+
+enum Outcome : uint32_t { kOk = 0, kFalseTrip, kMissed, kClean, kError };
+const char *const kOutcomeNames[] = { "ok", "false_trip", "missed", "clean", "error" };
+
+struct Options {
+    std::vector<const Detector *> detectors;
+    std::vector<int16_t> thresholds = { 50 };   // SystemState_Init 的默认阈值
+    std::string labels;
+    uint32_t timeout_ms = 2000;
+    std::string field = "LASTDATA";
+    int jobs = 1;
+    std::string output;
+};
+
+// 一次记录的回放输入
+struct Case {
+    size_t trace;
+    const tip::RunInfo *run;
+    size_t column;
+    uint32_t monitor_tick;      // 开始判断的 tick，kNoTick 表示从第一个采样开始
+    uint32_t label_tick;        // 断线时刻，kNoTick 表示未断线
+};
+
+// 子进程通过管道返回，单次写入小于 PIPE_BUF，多个子进程同时写也不会交错
+struct JobResult {
+    uint32_t job;
+    uint32_t outcome;
+    uint32_t trigger_tick;
+    uint32_t false_trips;
+    uint64_t samples;
+    double latency_ms;
+    double ns_per_sample;
+};
+
+Options options;
+std::vector<std::string> trace_paths;
+std::vector<std::unique_ptr<tip::TraceReader>> readers;
+std::vector<Case> cases;
+
+// 作业号 = (算法 * 阈值数 + 阈值) * 记录数 + 记录
+size_t JobCount() {
+    return options.detectors.size() * options.thresholds.size() * cases.size();
+}
+
+// 判断耗时按线程CPU时间统计，不受并行子进程数超过CPU数的影响
+int64_t ClockNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+std::string BaseName(const std::string &path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+int16_t ToCurrent(double value) {
+    if (std::isnan(value)) return 0;
+    return static_cast<int16_t>(std::clamp(std::lround(value), -32768L, 32767L));
+}
+
+void RunJob(uint32_t job, JobResult *result) {
+    size_t per_config = cases.size();
+    const Case &c = cases[job % per_config];
+    size_t config = job / per_config;
+    const Detector *detector = options.detectors[config / options.thresholds.size()];
+    int16_t threshold = options.thresholds[config % options.thresholds.size()];
+    bool labelled = c.label_tick != kNoTick;
+    uint32_t deadline = labelled ? c.label_tick + options.timeout_ms : kNoTick;
+
+    *result = JobResult();
+    result->job = job;
+    result->outcome = labelled ? kMissed : kClean;
+    result->trigger_tick = kNoTick;
+
+    // 每个作业从 SystemState_Init 之后的缓冲区状态开始
+    memset(g_system_state.current_buffer, 0, sizeof(g_system_state.current_buffer));
+    g_system_state.buffer_index = 0;
+    g_system_state.threshold = threshold;
+
+    bool done = false;
+    bool was_below = false;
+    int64_t busy_ns = 0;
+    std::vector<int16_t> current;
+
+    bool ok = readers[c.trace]->Scan(*c.run, [&](const tip::SampleChunk &chunk) {
+        if (done) return;
+        const double *column = chunk.columns[c.column];
+        current.resize(chunk.rows);
+        for (uint32_t i = 0; i < chunk.rows; i++) current[i] = ToCurrent(column[i]);
+
+        int64_t start = ClockNs(CLOCK_THREAD_CPUTIME_ID);
+        uint32_t i = 0;
+        for (; i < chunk.rows && !done; i++) {
+            uint32_t tick = chunk.tick[i];
+            SystemState_UpdateCurrent(static_cast<uint16_t>(current[i]));
+            if (c.monitor_tick != kNoTick && tick < c.monitor_tick) continue;
+
+            bool below = detector->below();
+            if (below && !was_below) {
+                if (tick < c.label_tick) {
+                    if (result->false_trips++ == 0) {
+                        result->outcome = kFalseTrip;
+                        result->trigger_tick = tick;
+                    }
+                } else if (result->outcome == kMissed && tick <= deadline) {
+                    result->outcome = kOk;
+                    result->trigger_tick = tick;
+                    result->latency_ms = tick - c.label_tick;
+                }
+            }
+            was_below = below;
+            // 标注后的首次触发或超时即结束（固件此时已断开电流）
+            if (labelled && (tick > deadline || result->outcome == kOk)) done = true;
+        }
+        busy_ns += ClockNs(CLOCK_THREAD_CPUTIME_ID) - start;
+        result->samples += i;
+    }, nullptr);
+
+    if (!ok) result->outcome = kError;
+    if (result->outcome == kFalseTrip) result->latency_ms = 0;
+    result->ns_per_sample = result->samples ? static_cast<double>(busy_ns) / result->samples : 0;
+}
+
+// 子进程按作业号交错分配，结果逐个写入管道
+bool RunAll(std::vector<JobResult> &results) {
+    size_t count = JobCount();
+    int fds[2];
+    int workers = static_cast<int>(std::min<size_t>(static_cast<size_t>(options.jobs), count));
+
+    results.assign(count, JobResult());
+    for (size_t i = 0; i < count; i++) {
+        results[i].job = static_cast<uint32_t>(i);
+        results[i].outcome = kError;
+        results[i].trigger_tick = kNoTick;
+    }
+    if (pipe(fds) != 0) return false;
+    fflush(nullptr);
+
+    for (int w = 0; w < workers; w++) {
+        pid_t pid = fork();
+        if (pid < 0) return false;
+        if (pid == 0) {
+            close(fds[0]);
+            for (size_t job = static_cast<size_t>(w); job < count; job += static_cast<size_t>(workers)) {
+                JobResult r;
+                RunJob(static_cast<uint32_t>(job), &r);
+                if (write(fds[1], &r, sizeof(r)) != static_cast<ssize_t>(sizeof(r))) _exit(1);
+            }
+            _exit(0);
+        }
+    }
+    close(fds[1]);
+
+    JobResult r;
+    while (read(fds[0], &r, sizeof(r)) == static_cast<ssize_t>(sizeof(r))) {
+        if (r.job < count) results[r.job] = r;
+    }
+    close(fds[0]);
+    while (wait(nullptr) > 0) {
+    }
+    return true;
+}
+
+double Percentile(std::vector<double> &values, int pct) {
+    if (values.empty()) return 0;
+    size_t index = std::min(values.size() * static_cast<size_t>(pct) / 100, values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + static_cast<long>(index), values.end());
+    return values[index];
+}
+
+void Report(const std::vector<JobResult> &results) {
+    size_t per_config = cases.size();
+
+    for (size_t config = 0; config * per_config < results.size(); config++) {
+        const Detector *detector = options.detectors[config / options.thresholds.size()];
+        int16_t threshold = options.thresholds[config % options.thresholds.size()];
+        uint32_t outcomes[5] = { 0 };
+        uint64_t false_trips = 0, samples = 0;
+        double busy_ns = 0, sum = 0;
+        std::vector<double> latency;
+
+        for (size_t k = 0; k < per_config; k++) {
+            const JobResult &r = results[config * per_config + k];
+            outcomes[r.outcome < 5 ? r.outcome : kError]++;
+            false_trips += r.false_trips;
+            samples += r.samples;
+            busy_ns += r.ns_per_sample * r.samples;
+            if (r.outcome == kOk) {
+                latency.push_back(r.latency_ms);
+                sum += r.latency_ms;
+            }
+        }
+
+        printf("%s thres %d: %zu runs, ok %u, false trip %u (%.2f%%, %llu trips), missed %u (%.2f%%)",
+               detector->name, threshold, per_config, outcomes[kOk], outcomes[kFalseTrip],
+               100.0 * outcomes[kFalseTrip] / per_config, static_cast<unsigned long long>(false_trips),
+               outcomes[kMissed], 100.0 * outcomes[kMissed] / per_config);
+        if (outcomes[kClean]) printf(", clean %u", outcomes[kClean]);
+        if (outcomes[kError]) printf(", error %u", outcomes[kError]);
+        printf("\n");
+        if (latency.empty()) {
+            printf("  %-10s -\n", "latency");
+        } else {
+            double mean = sum / latency.size();
+            printf("  %-10s mean %.2f  p50 %.2f  p95 %.2f  max %.2f ms\n", "latency", mean,
+                   Percentile(latency, 50), Percentile(latency, 95), Percentile(latency, 100));
+        }
+        printf("  %-10s %.2f ns/sample (%llu samples)\n", "cpu", samples ? busy_ns / samples : 0.0,
+               static_cast<unsigned long long>(samples));
+    }
+}
+
+bool WriteCsv(const std::vector<JobResult> &results) {
+    FILE *csv = fopen(options.output.c_str(), "w");
+    if (csv == nullptr) {
+        fprintf(stderr, "tm_replay: %s: %s\n", options.output.c_str(), strerror(errno));
+        return false;
+    }
+    size_t per_config = cases.size();
+    fprintf(csv, "algorithm,threshold,trace,run,outcome,label_tick,trigger_tick,latency_ms,false_trips,"
+                 "samples,ns_per_sample\n");
+    for (const JobResult &r : results) {
+        const Case &c = cases[r.job % per_config];
+        size_t config = r.job / per_config;
+        fprintf(csv, "%s,%d,%s,%u,%s,", options.detectors[config / options.thresholds.size()]->name,
+                options.thresholds[config % options.thresholds.size()], trace_paths[c.trace].c_str(),
+                c.run->run_id, kOutcomeNames[r.outcome < 5 ? r.outcome : kError]);
+        if (c.label_tick != kNoTick) fprintf(csv, "%u", c.label_tick);
+        fprintf(csv, ",");
+        if (r.trigger_tick != kNoTick) fprintf(csv, "%u", r.trigger_tick);
+        fprintf(csv, ",%.1f,%u,%llu,%.2f\n", r.latency_ms, r.false_trips,
+                static_cast<unsigned long long>(r.samples), r.ns_per_sample);
+    }
+    return fclose(csv) == 0;
+}
+
+// 标注文件：<记录文件名>,<记录号>,<断线tick>，# 开头的行和无法解析的行（如表头）忽略
+bool LoadLabels(std::map<std::pair<std::string, uint32_t>, uint32_t> &labels) {
+    FILE *file = fopen(options.labels.c_str(), "r");
+    if (file == nullptr) {
+        fprintf(stderr, "tm_replay: %s: %s\n", options.labels.c_str(), strerror(errno));
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char name[200];
+        unsigned run, tick;
+        if (line[0] == '#' || sscanf(line, " %199[^,],%u,%u", name, &run, &tick) != 3) continue;
+        labels[{ BaseName(name), run }] = tick;
+    }
+    fclose(file);
+    return true;
+}
+
+// 读取每次记录的事件，确定开始判断的时刻和标注
+bool LoadCases() {
+    std::map<std::pair<std::string, uint32_t>, uint32_t> labels;
+    if (!options.labels.empty() && !LoadLabels(labels)) return false;
+
+    for (size_t t = 0; t < trace_paths.size(); t++) {
+        auto reader = std::make_unique<tip::TraceReader>();
+        if (!reader->Open(trace_paths[t])) return false;
+        if (reader->Recovered()) fprintf(stderr, "tm_replay: %s: no index, rebuilt from blocks\n",
+                                         trace_paths[t].c_str());
+
+        for (const tip::RunInfo &run : reader->Runs()) {
+            auto field = std::find(run.fields.begin(), run.fields.end(), options.field);
+            if (field == run.fields.end()) {
+                fprintf(stderr, "tm_replay: %s run %u: no %s field, skipped\n", trace_paths[t].c_str(),
+                        run.run_id, options.field.c_str());
+                continue;
+            }
+            Case c = { t, &run, static_cast<size_t>(field - run.fields.begin()), kNoTick, kNoTick };
+            reader->Scan(run, nullptr, [&c](const tip::EventChunk &chunk) {
+                for (uint32_t i = 0; i < chunk.rows; i++) {
+                    if (chunk.type[i] == kEventSeqState && chunk.value[i] == kSeqMonitorCurrent &&
+                        c.monitor_tick == kNoTick) {
+                        c.monitor_tick = chunk.tick[i];
+                    }
+                    if (chunk.type[i] == kEventCutoff && c.label_tick == kNoTick) c.label_tick = chunk.tick[i];
+                }
+            });
+            auto label = labels.find({ BaseName(trace_paths[t]), run.run_id });
+            if (label != labels.end()) c.label_tick = label->second;
+            cases.push_back(c);
+        }
+        readers.push_back(std::move(reader));
+    }
+    return true;
+}
+
+bool ParseThresholds(const char *text) {
+    int from, to, step;
+    options.thresholds.clear();
+    if (sscanf(text, "%d:%d:%d", &from, &to, &step) == 3) {
+        if (step <= 0 || from > to) return false;
+        for (int v = from; v <= to; v += step) options.thresholds.push_back(static_cast<int16_t>(v));
+        return true;
+    }
+    for (const char *p = text; *p != '\0';) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p) return false;
+        options.thresholds.push_back(static_cast<int16_t>(v));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !options.thresholds.empty();
+}
+
+bool ParseDetectors(const char *text) {
+    std::string list = text;
+    size_t pos = 0;
+    options.detectors.clear();
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        std::string name = list.substr(pos, comma - pos);
+        auto found = std::find_if(std::begin(kDetectors), std::end(kDetectors),
+                                  [&name](const Detector &d) { return name == d.name; });
+        if (found == std::end(kDetectors)) {
+            fprintf(stderr, "tm_replay: unknown algorithm %s\n", name.c_str());
+            return false;
+        }
+        options.detectors.push_back(found);
+        pos = comma + 1;
+    }
+    return true;
+}
+
+void Usage() {
+    fprintf(stderr, "usage: tm_replay [-a algorithm,...] [-T thresholds] [-l labels.csv] [-m timeout_ms] "
+                    "[-F field] [-j jobs] [-o results.csv] <trace.tip>...\n"
+                    "algorithms:");
+    for (const Detector &d : kDetectors) fprintf(stderr, " %s", d.name);
+    fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    options.jobs = cpus > 0 ? static_cast<int>(cpus) : 1;
+    for (const Detector &d : kDetectors) options.detectors.push_back(&d);
+
+    while ((opt = getopt(argc, argv, "a:T:l:m:F:j:o:h")) != -1) {
+        switch (opt) {
+        case 'a':
+            if (!ParseDetectors(optarg)) return 1;
+            break;
+        case 'T':
+            if (!ParseThresholds(optarg)) {
+                fprintf(stderr, "tm_replay: bad threshold list %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'l':
+            options.labels = optarg;
+            break;
+        case 'm':
+            options.timeout_ms = static_cast<uint32_t>(atoi(optarg));
+            break;
+        case 'F':
+            options.field = optarg;
+            break;
+        case 'j':
+            options.jobs = std::max(1, atoi(optarg));
+            break;
+        case 'o':
+            options.output = optarg;
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        Usage();
+        return 1;
+    }
+    for (int i = optind; i < argc; i++) trace_paths.push_back(argv[i]);
+
+    if (!LoadCases()) return 1;
+    if (cases.empty()) {
+        fprintf(stderr, "tm_replay: no runs to replay\n");
+        return 1;
+    }
+
+    int64_t start = ClockNs(CLOCK_MONOTONIC);
+    std::vector<JobResult> results;
+    if (!RunAll(results)) {
+        fprintf(stderr, "tm_replay: fork: %s\n", strerror(errno));
+        return 1;
+    }
+    double elapsed_s = (ClockNs(CLOCK_MONOTONIC) - start) / 1e9;
+
+    Report(results);
+    uint64_t samples = 0;
+    for (const JobResult &r : results) samples += r.samples;
+    printf("%zu runs x %zu configs, %llu samples replayed in %.2f s on %d workers\n", cases.size(),
+           results.size() / cases.size(), static_cast<unsigned long long>(samples), elapsed_s,
+           std::min<int>(options.jobs, static_cast<int>(results.size())));
+
+    if (!options.output.empty() && !WriteCsv(results)) return 1;
+    return 0;
+}
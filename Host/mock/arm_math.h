@@ -0,0 +1,50 @@
+// 主机端替身：CMSIS-DSP中App用到的部分。
+// 与Cortex-M3目标（未定义ARM_MATH_DSP）的实现相同，arm_pid_init_q15.c 直接使用CMSIS源文件。
+
+#ifndef _ARM_MATH_H
+#define _ARM_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+static inline int32_t __SSAT(int32_t val, uint32_t sat) {
+    int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    int32_t min = -1 - max;
+    return val > max ? max : (val < min ? min : val);
+}
+
+typedef struct {
+    q15_t A0;
+    q15_t A1;
+    q15_t A2;
+    q15_t state[3];
+    q15_t Kp;
+    q15_t Ki;
+    q15_t Kd;
+} arm_pid_instance_q15;
+
+void arm_pid_init_q15(arm_pid_instance_q15 *S, int32_t resetStateFlag);
+void arm_pid_reset_q15(arm_pid_instance_q15 *S);
+
+static inline q15_t arm_pid_q15(arm_pid_instance_q15 *S, q15_t in) {
+    q63_t acc;
+    q15_t out;
+
+    acc = ((q31_t)S->A0) * in;
+    acc += (q31_t)S->A1 * S->state[0];
+    acc += (q31_t)S->A2 * S->state[1];
+    acc += (q31_t)S->state[2] << 15;
+    out = (q15_t)(__SSAT((q31_t)(acc >> 15), 16));
+
+    S->state[1] = S->state[0];
+    S->state[0] = in;
+    S->state[2] = out;
+    return out;
+}
+
+#endif /* _ARM_MATH_H */
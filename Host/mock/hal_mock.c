@@ -0,0 +1,479 @@
+#include "hal_mock.h"
+#include "usbd_cdc_if.h"
+#include "command_parser.h"
+#include "ina236.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// 链接脚本中的栈符号，perf_monitor.c 只取其地址
+__asm__(".globl _estack\n"
+        ".set _estack, 0x20005000\n"
+        ".globl _Min_Stack_Size\n"
+        ".set _Min_Stack_Size, 0x400\n");
+
+uint32_t SystemCoreClock = MOCK_CORE_CLOCK_HZ;
+uint32_t mock_primask;
+uint32_t mock_msp;
+
+GPIO_TypeDef mock_gpioa;
+GPIO_TypeDef mock_gpiob;
+GPIO_TypeDef mock_gpioc;
+TIM_TypeDef mock_tim1;
+TIM_TypeDef mock_tim2;
+EXTI_TypeDef mock_exti;
+RCC_TypeDef mock_rcc;
+DWT_Type mock_dwt;
+CoreDebug_Type mock_coredebug;
+I2C_TypeDef mock_i2c1;
+
+TIM_HandleTypeDef htim1 = { .Instance = TIM1 };
+TIM_HandleTypeDef htim2 = { .Instance = TIM2 };
+I2C_HandleTypeDef hi2c1 = { .Instance = I2C1 };
+
+static uint64_t now_us;
+static uint32_t tick_ms;
+static uint32_t tim1_pwm_channels;
+static uint32_t tim2_ic_channels;
+
+static uint8_t ina236_regs_pointer;
+static uint16_t ina236_regs[0x40];
+static uint32_t i2c_fail_count;
+static uint32_t i2c_transactions;
+
+static bool flash_locked = true;
+static uint32_t flash_writes;
+
+static uint8_t cdc_rx_pending[4096];
+static uint32_t cdc_rx_len;
+static bool cdc_rx_paused;
+
+static uint8_t cdc_tx_buf[APP_TX_DATA_SIZE];
+static uint32_t cdc_tx_len;
+static uint32_t cdc_tx_staged;
+static bool cdc_tx_dropped;
+static uint16_t cdc_tx_high_water;
+static uint32_t cdc_tx_overflow;
+static bool cdc_tx_full;           // 自上次主机读取后出现过队列满
+static uint32_t cdc_tx_full_tick;
+static bool cdc_tx_stalled;        // 主机超过 CDC_TX_TIMEOUT_MS 未读取
+
+static void Mock_MapFixed(uintptr_t base, size_t size, uint8_t fill) {
+    void *p = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p == MAP_FAILED || (uintptr_t)p != base) {
+        // 已映射（重复调用 Mock_Init）时直接复用
+        if (p != MAP_FAILED) munmap(p, size);
+        p = (void *)base;
+    }
+    memset(p, fill, size);
+}
+
+void Mock_Init(void) {
+    Mock_MapFixed(FLASH_BASE, MOCK_FLASH_SIZE, 0xFF);
+    Mock_MapFixed(MOCK_SRAM_BASE, MOCK_SRAM_SIZE, 0x00);
+
+    memset(&mock_gpioa, 0, sizeof(mock_gpioa));
+    memset(&mock_gpiob, 0, sizeof(mock_gpiob));
+    memset(&mock_gpioc, 0, sizeof(mock_gpioc));
+    memset(&mock_tim1, 0, sizeof(mock_tim1));
+    memset(&mock_tim2, 0, sizeof(mock_tim2));
+    memset(&mock_exti, 0, sizeof(mock_exti));
+    memset(&mock_rcc, 0, sizeof(mock_rcc));
+    memset(&mock_dwt, 0, sizeof(mock_dwt));
+    memset(&mock_coredebug, 0, sizeof(mock_coredebug));
+
+    mock_primask = 0;
+    mock_msp = MOCK_SRAM_BASE + MOCK_SRAM_SIZE - MOCK_STACK_USED;
+    now_us = 0;
+    tick_ms = 0;
+    tim1_pwm_channels = 0;
+    tim2_ic_channels = 0;
+
+    memset(ina236_regs, 0, sizeof(ina236_regs));
+    ina236_regs_pointer = 0;
+    i2c_fail_count = 0;
+    i2c_transactions = 0;
+
+    flash_locked = true;
+    flash_writes = 0;
+
+    cdc_rx_len = 0;
+    cdc_rx_paused = false;
+    cdc_tx_len = 0;
+    cdc_tx_staged = 0;
+    cdc_tx_dropped = false;
+    cdc_tx_high_water = 0;
+    cdc_tx_overflow = 0;
+    cdc_tx_full = false;
+    cdc_tx_stalled = false;
+}
+
+/* ---------------- 时间 ---------------- */
+
+void Mock_AdvanceUs(uint32_t us) {
+    uint64_t next = now_us + us;
+
+    tick_ms += (uint32_t)(next / 1000 - now_us / 1000);
+    if (mock_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+        mock_dwt.CYCCNT += us * (MOCK_CORE_CLOCK_HZ / 1000000);
+    }
+    now_us = next;
+}
+
+uint64_t Mock_NowUs(void) {
+    return now_us;
+}
+
+uint32_t HAL_GetTick(void) {
+    return tick_ms;
+}
+
+void HAL_Delay(uint32_t Delay) {
+    Mock_AdvanceUs(Delay * 1000);
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+    return MOCK_CORE_CLOCK_HZ;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+    (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+    (void)IRQn;
+}
+
+void MX_USB_DEVICE_Init(void) {
+}
+
+/* ---------------- GPIO ---------------- */
+
+// BSRR高16位复位、低16位置位（同时写时置位优先），BRR复位
+static void Mock_GpioLatch(GPIO_TypeDef *port) {
+    uint32_t bsrr = port->BSRR;
+
+    port->ODR &= ~((bsrr >> 16) | port->BRR);
+    port->ODR |= bsrr & 0xFFFFU;
+    port->BSRR = 0;
+    port->BRR = 0;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    Mock_GpioLatch(GPIOx);
+    if (PinState != GPIO_PIN_RESET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    Mock_GpioLatch(GPIOx);
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+bool Mock_GpioOutput(GPIO_TypeDef *port, uint16_t pin) {
+    Mock_GpioLatch(port);
+    return (port->ODR & pin) != 0;
+}
+
+void Mock_GpioSetInput(GPIO_TypeDef *port, uint16_t pin, bool level) {
+    if (level) {
+        port->IDR |= pin;
+    } else {
+        port->IDR &= ~(uint32_t)pin;
+    }
+}
+
+bool Mock_GpioEdge(GPIO_TypeDef *port, uint16_t pin, bool level) {
+    bool old = (port->IDR & pin) != 0;
+
+    Mock_GpioSetInput(port, pin, level);
+    if (old == level) return false;
+    mock_exti.PR |= pin;
+    return true;
+}
+
+/* ---------------- TIM ---------------- */
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    htim->Instance->DIER |= TIM_IT_UPDATE;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+    htim->Instance->DIER &= ~TIM_IT_UPDATE;
+    htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    if (htim == &htim1) tim1_pwm_channels |= 1U << (Channel >> 2);
+    htim->Instance->CCER |= 1U << Channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    if (htim == &htim1) tim1_pwm_channels &= ~(1U << (Channel >> 2));
+    htim->Instance->CCER &= ~(1U << Channel);
+    if ((htim->Instance->CCER & 0x1111U) == 0) {
+        htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    if (htim == &htim2) tim2_ic_channels |= 1U << (Channel >> 2);
+    htim->Instance->DIER |= TIM_IT_CC1 << (Channel >> 2);
+    htim->Instance->CCER |= 1U << Channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+bool Mock_TimPwmRunning(TIM_HandleTypeDef *htim, uint32_t channel) {
+    return (htim->Instance->CCER & (1U << channel)) && (htim->Instance->CR1 & TIM_CR1_CEN);
+}
+
+/* ---------------- I2C (INA236) ---------------- */
+
+void Mock_Ina236SetShunt(int16_t raw) {
+    ina236_regs[INA236_REG_SHUNT_VOLT] = (uint16_t)raw;
+}
+
+uint16_t Mock_Ina236Config(void) {
+    return ina236_regs[INA236_REG_CONFIG];
+}
+
+void Mock_I2CFailNext(uint32_t count) {
+    i2c_fail_count = count;
+}
+
+uint32_t Mock_I2CTransactions(void) {
+    return i2c_transactions;
+}
+
+static bool Mock_I2CAck(uint16_t DevAddress) {
+    i2c_transactions++;
+    if (i2c_fail_count > 0) {
+        i2c_fail_count--;
+        return false;
+    }
+    return DevAddress == INA236_ADDRESS;
+}
+
+// 1字节：设置寄存器指针；3字节：写寄存器（高字节在前）
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                          uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    (void)hi2c;
+    (void)Timeout;
+    if (!Mock_I2CAck(DevAddress) || Size == 0) return HAL_ERROR;
+
+    ina236_regs_pointer = pData[0] & 0x3F;
+    if (Size >= 3) {
+        ina236_regs[ina236_regs_pointer] = (uint16_t)((pData[1] << 8) | pData[2]);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                         uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    uint16_t value = ina236_regs[ina236_regs_pointer];
+
+    (void)hi2c;
+    (void)Timeout;
+    if (!Mock_I2CAck(DevAddress)) return HAL_ERROR;
+
+    for (uint16_t i = 0; i < Size; i++) {
+        pData[i] = (i % 2 == 0) ? (uint8_t)(value >> 8) : (uint8_t)value;
+    }
+    return HAL_OK;
+}
+
+/* ---------------- Flash ---------------- */
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+    flash_locked = false;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+    flash_locked = true;
+    return HAL_OK;
+}
+
+// 与F1一致：按半字编程，目标半字未擦除时失败
+static HAL_StatusTypeDef Mock_FlashProgramHalfWord(uint32_t address, uint16_t data) {
+    volatile uint16_t *cell = (volatile uint16_t *)(uintptr_t)address;
+
+    if (*cell != 0xFFFF) return HAL_ERROR;
+    *cell = data;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data) {
+    uint32_t halfwords = TypeProgram == FLASH_TYPEPROGRAM_WORD ? 2 : 1;
+
+    if (flash_locked || Address < FLASH_BASE || (Address & 1U) ||
+        Address + halfwords * 2 > FLASH_BASE + MOCK_FLASH_SIZE) {
+        return HAL_ERROR;
+    }
+    for (uint32_t i = 0; i < halfwords; i++) {
+        if (Mock_FlashProgramHalfWord(Address + i * 2, (uint16_t)(Data >> (16 * i))) != HAL_OK) {
+            return HAL_ERROR;
+        }
+    }
+    flash_writes++;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError) {
+    const uint32_t page_size = 1024;
+    uint32_t start = pEraseInit->PageAddress;
+    uint32_t size = pEraseInit->NbPages * page_size;
+
+    *PageError = 0xFFFFFFFFU;
+    if (flash_locked || start < FLASH_BASE || start % page_size != 0 ||
+        start + size > FLASH_BASE + MOCK_FLASH_SIZE) {
+        *PageError = start;
+        return HAL_ERROR;
+    }
+    memset((void *)(uintptr_t)start, 0xFF, size);
+    return HAL_OK;
+}
+
+void Mock_FlashErase(void) {
+    memset((void *)(uintptr_t)FLASH_BASE, 0xFF, MOCK_FLASH_SIZE);
+}
+
+uint32_t Mock_FlashWrites(void) {
+    return flash_writes;
+}
+
+/* ---------------- USB CDC ---------------- */
+
+// 模拟OUT端点：逐包交给解析器，返回false后暂停，直到 CDC_ResumeReceive_FS()
+static void Mock_CdcDeliver(void) {
+    while (!cdc_rx_paused && cdc_rx_len > 0) {
+        uint8_t packet[MOCK_CDC_PACKET_SIZE];
+        uint32_t len = cdc_rx_len < sizeof(packet) ? cdc_rx_len : sizeof(packet);
+
+        memcpy(packet, cdc_rx_pending, len);
+        memmove(cdc_rx_pending, cdc_rx_pending + len, cdc_rx_len - len);
+        cdc_rx_len -= len;
+        if (!CommandParser_USBReceiveCallback(packet, len)) {
+            cdc_rx_paused = true;
+        }
+    }
+}
+
+void Mock_CdcReceive(const uint8_t *data, uint32_t len) {
+    if (len > sizeof(cdc_rx_pending) - cdc_rx_len) {
+        fprintf(stderr, "hal_mock: CDC RX pending buffer full, %u bytes dropped\n",
+                (unsigned)(len - (sizeof(cdc_rx_pending) - cdc_rx_len)));
+        len = sizeof(cdc_rx_pending) - cdc_rx_len;
+    }
+    memcpy(cdc_rx_pending + cdc_rx_len, data, len);
+    cdc_rx_len += len;
+    Mock_CdcDeliver();
+}
+
+uint32_t Mock_CdcRxPending(void) {
+    return cdc_rx_len;
+}
+
+void CDC_ResumeReceive_FS(void) {
+    cdc_rx_paused = false;
+    Mock_CdcDeliver();
+}
+
+// 发送队列与目标相同为 APP_TX_DATA_SIZE 字节，主机通过 Mock_CdcRead() 读取；
+// 放不下的消息整条丢弃并计数（与目标相同，不等待）。
+// Mock_CdcRead() 相当于目标上的一次发送完成；队列持续满且 MOCK_CDC_TX_TIMEOUT_MS 内
+// 未读取时视为主机停止读取，CDC_TxReady_FS() 返回真，使命令照常执行、应答丢弃
+static void Mock_CdcTxFull(void) {
+    if (!cdc_tx_full) {
+        cdc_tx_full_tick = HAL_GetTick();
+        cdc_tx_full = true;
+    } else if (HAL_GetTick() - cdc_tx_full_tick >= MOCK_CDC_TX_TIMEOUT_MS) {
+        cdc_tx_stalled = true;
+    }
+}
+
+void CDC_BeginMessage_FS(void) {
+    cdc_tx_staged = 0;
+    cdc_tx_dropped = false;
+}
+
+void CDC_Append_FS(const uint8_t* Buf, uint16_t Len) {
+    if (cdc_tx_dropped) return;
+    if (cdc_tx_len + cdc_tx_staged + Len > sizeof(cdc_tx_buf)) {
+        Mock_CdcTxFull();
+        cdc_tx_dropped = true;
+        return;
+    }
+    memcpy(cdc_tx_buf + cdc_tx_len + cdc_tx_staged, Buf, Len);
+    cdc_tx_staged += Len;
+}
+
+uint8_t CDC_EndMessage_FS(void) {
+    if (cdc_tx_dropped) {
+        cdc_tx_overflow++;
+        return USBD_BUSY;
+    }
+    cdc_tx_len += cdc_tx_staged;
+    cdc_tx_staged = 0;
+    if (cdc_tx_len > cdc_tx_high_water) {
+        cdc_tx_high_water = (uint16_t)cdc_tx_len;
+    }
+    return USBD_OK;
+}
+
+uint8_t CDC_Write_FS(const uint8_t* Buf, uint16_t Len) {
+    CDC_BeginMessage_FS();
+    CDC_Append_FS(Buf, Len);
+    return CDC_EndMessage_FS();
+}
+
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len) {
+    return CDC_Write_FS(Buf, Len);
+}
+
+void CDC_GetTxStats_FS(uint16_t *high_water, uint32_t *overflow) {
+    *high_water = cdc_tx_high_water;
+    *overflow = cdc_tx_overflow;
+}
+
+uint8_t CDC_TxReady_FS(uint16_t Len) {
+    if (cdc_tx_stalled || cdc_tx_len + cdc_tx_staged + Len <= sizeof(cdc_tx_buf)) {
+        return 1;
+    }
+    Mock_CdcTxFull();
+    return cdc_tx_stalled;
+}
+
+uint32_t Mock_CdcRead(uint8_t *buf, uint32_t size) {
+    uint32_t len = cdc_tx_len < size ? cdc_tx_len : size;
+
+    memcpy(buf, cdc_tx_buf, len);
+    memmove(cdc_tx_buf, cdc_tx_buf + len, cdc_tx_len + cdc_tx_staged - len);
+    cdc_tx_len -= len;
+    if (len > 0) {
+        cdc_tx_full = false;
+        cdc_tx_stalled = false;
+    }
+    return len;
+}
+
+uint32_t Mock_CdcTxQueued(void) {
+    return cdc_tx_len;
+}
@@ -0,0 +1,56 @@
+// 主机端HAL替身的控制接口：推进时间、驱动输入、注入故障、读取输出
+//
+// 使用前调用 Mock_Init()。Flash模拟区映射在 0x08000000，栈填充区映射在 0x20000000，
+// 使 eeprom_emulation.c 和 perf_monitor.c 中的绝对地址在主机上同样有效（需 -no-pie 链接）。
+
+#ifndef __HAL_MOCK_H__
+#define __HAL_MOCK_H__
+
+#include "stm32f1xx_hal.h"
+
+#define MOCK_CORE_CLOCK_HZ   72000000UL
+#define MOCK_FLASH_SIZE      0x20000UL     // 128KB
+#define MOCK_SRAM_BASE       0x20000000UL
+#define MOCK_SRAM_SIZE       0x5000UL      // 20KB，_estack 位于末尾
+#define MOCK_STACK_USED      256           // __get_MSP() 返回 _estack 减去该值
+#define MOCK_CDC_PACKET_SIZE 64
+#define MOCK_CDC_TX_TIMEOUT_MS 10          // 与 usbd_cdc_if.c 的 CDC_TX_TIMEOUT_MS 相同
+
+// 外设句柄（目标上定义在 main.c 中）
+extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim2;
+extern I2C_HandleTypeDef hi2c1;
+
+void Mock_Init(void);
+
+// 时间：同时推进 HAL_GetTick() 和 DWT->CYCCNT
+void Mock_AdvanceUs(uint32_t us);
+uint64_t Mock_NowUs(void);
+
+// GPIO：输出电平（先折算BSRR/BRR写入），设置输入电平
+bool Mock_GpioOutput(GPIO_TypeDef *port, uint16_t pin);
+void Mock_GpioSetInput(GPIO_TypeDef *port, uint16_t pin, bool level);
+// 设置输入电平，电平变化时置位对应EXTI挂起位，返回是否产生了边沿
+bool Mock_GpioEdge(GPIO_TypeDef *port, uint16_t pin, bool level);
+
+// TIM：PWM输出通道是否开启
+bool Mock_TimPwmRunning(TIM_HandleTypeDef *htim, uint32_t channel);
+
+// I2C：INA236分流电压寄存器原始值、后续count次传输失败、传输计数
+void Mock_Ina236SetShunt(int16_t raw);
+uint16_t Mock_Ina236Config(void);
+void Mock_I2CFailNext(uint32_t count);
+uint32_t Mock_I2CTransactions(void);
+
+// Flash：擦除全部模拟区，统计编程次数
+void Mock_FlashErase(void);
+uint32_t Mock_FlashWrites(void);
+
+// USB CDC：主机发送数据，按64字节包交给命令解析器，解析器暂停接收时保留在待发队列中
+void Mock_CdcReceive(const uint8_t *data, uint32_t len);
+uint32_t Mock_CdcRxPending(void);
+// 取走设备已发送的数据，返回字节数；取走数据相当于目标上的一次发送完成
+uint32_t Mock_CdcRead(uint8_t *buf, uint32_t size);
+uint32_t Mock_CdcTxQueued(void);
+
+#endif /* __HAL_MOCK_H__ */
@@ -0,0 +1,272 @@
+// 主机端HAL替身：只提供App层用到的类型、寄存器和函数，寄存器为普通内存。
+// 通过 -IHost/mock 放在 Core/Inc 之前，使 main.h 包含的是本文件。
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define __IO volatile
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+
+typedef enum {
+    USB_LP_CAN1_RX0_IRQn = 20,
+    TIM1_UP_IRQn = 25,
+    TIM1_CC_IRQn = 27,
+    TIM2_IRQn = 28,
+    EXTI4_IRQn = 10,
+    SysTick_IRQn = -1
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock;
+
+/* ---------------- 寄存器模型 ---------------- */
+
+typedef struct {
+    __IO uint32_t CRL;
+    __IO uint32_t CRH;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;   // 写入后由 Mock_GpioOutput() 折算到 ODR
+    __IO uint32_t BRR;
+    __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t IMR;
+    __IO uint32_t EMR;
+    __IO uint32_t RTSR;
+    __IO uint32_t FTSR;
+    __IO uint32_t SWIER;
+    __IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR;
+    __IO uint32_t CFGR;
+} RCC_TypeDef;
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR;
+    __IO uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    uint32_t dummy;
+} I2C_TypeDef;
+
+extern GPIO_TypeDef mock_gpioa;
+extern GPIO_TypeDef mock_gpiob;
+extern GPIO_TypeDef mock_gpioc;
+extern TIM_TypeDef mock_tim1;
+extern TIM_TypeDef mock_tim2;
+extern EXTI_TypeDef mock_exti;
+extern RCC_TypeDef mock_rcc;
+extern DWT_Type mock_dwt;
+extern CoreDebug_Type mock_coredebug;
+extern I2C_TypeDef mock_i2c1;
+
+#define GPIOA       (&mock_gpioa)
+#define GPIOB       (&mock_gpiob)
+#define GPIOC       (&mock_gpioc)
+#define TIM1        (&mock_tim1)
+#define TIM2        (&mock_tim2)
+#define EXTI        (&mock_exti)
+#define RCC         (&mock_rcc)
+#define DWT         (&mock_dwt)
+#define CoreDebug   (&mock_coredebug)
+#define I2C1        (&mock_i2c1)
+
+#define RCC_CFGR_PPRE2                  (0x7UL << 11)
+#define RCC_CFGR_PPRE2_DIV1             0x00000000UL
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+/* ---------------- CMSIS内核函数 ---------------- */
+
+extern uint32_t mock_primask;
+extern uint32_t mock_msp;
+
+static inline uint32_t __get_PRIMASK(void) { return mock_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { mock_primask = primask; }
+static inline void __disable_irq(void) { mock_primask = 1; }
+static inline void __enable_irq(void) { mock_primask = 0; }
+static inline uint32_t __get_MSP(void) { return mock_msp; }
+static inline void __NOP(void) { }
+
+/* ---------------- GPIO ---------------- */
+
+#define GPIO_PIN_0      ((uint16_t)0x0001)
+#define GPIO_PIN_1      ((uint16_t)0x0002)
+#define GPIO_PIN_2      ((uint16_t)0x0004)
+#define GPIO_PIN_3      ((uint16_t)0x0008)
+#define GPIO_PIN_4      ((uint16_t)0x0010)
+#define GPIO_PIN_5      ((uint16_t)0x0020)
+#define GPIO_PIN_6      ((uint16_t)0x0040)
+#define GPIO_PIN_7      ((uint16_t)0x0080)
+#define GPIO_PIN_8      ((uint16_t)0x0100)
+#define GPIO_PIN_9      ((uint16_t)0x0200)
+#define GPIO_PIN_10     ((uint16_t)0x0400)
+#define GPIO_PIN_11     ((uint16_t)0x0800)
+#define GPIO_PIN_12     ((uint16_t)0x1000)
+#define GPIO_PIN_13     ((uint16_t)0x2000)
+#define GPIO_PIN_14     ((uint16_t)0x4000)
+#define GPIO_PIN_15     ((uint16_t)0x8000)
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+// EXTI挂起位为写1清零
+#define __HAL_GPIO_EXTI_GET_IT(__EXTI_LINE__)   (EXTI->PR & (__EXTI_LINE__))
+#define __HAL_GPIO_EXTI_CLEAR_IT(__EXTI_LINE__) (EXTI->PR &= ~(uint32_t)(__EXTI_LINE__))
+
+/* ---------------- TIM ---------------- */
+
+#define TIM_CHANNEL_1   0x00000000U
+#define TIM_CHANNEL_2   0x00000004U
+#define TIM_CHANNEL_3   0x00000008U
+#define TIM_CHANNEL_4   0x0000000CU
+
+#define TIM_SR_UIF      (1UL << 0)
+#define TIM_SR_CC1IF    (1UL << 1)
+#define TIM_SR_CC2IF    (1UL << 2)
+#define TIM_SR_CC3IF    (1UL << 3)
+#define TIM_SR_CC4IF    (1UL << 4)
+#define TIM_SR_CC4OF    (1UL << 12)
+
+#define TIM_FLAG_UPDATE TIM_SR_UIF
+#define TIM_FLAG_CC1    TIM_SR_CC1IF
+#define TIM_FLAG_CC2    TIM_SR_CC2IF
+#define TIM_FLAG_CC3    TIM_SR_CC3IF
+#define TIM_FLAG_CC4    TIM_SR_CC4IF
+#define TIM_FLAG_CC4OF  TIM_SR_CC4OF
+
+#define TIM_IT_UPDATE   (1UL << 0)
+#define TIM_IT_CC1      (1UL << 1)
+#define TIM_IT_CC2      (1UL << 2)
+#define TIM_IT_CC3      (1UL << 3)
+#define TIM_IT_CC4      (1UL << 4)
+
+#define TIM_EGR_UG      (1UL << 0)
+#define TIM_CR1_CEN     (1UL << 0)
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+// 状态位为写0清零，这里直接清除对应位
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__) \
+    (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->Instance->SR &= ~(uint32_t)(__FLAG__))
+#define __HAL_TIM_CLEAR_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->SR &= ~(uint32_t)(__INTERRUPT__))
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER |= (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER &= ~(uint32_t)(__INTERRUPT__))
+#define __HAL_TIM_GET_IT_SOURCE(__HANDLE__, __INTERRUPT__) \
+    ((((__HANDLE__)->Instance->DIER & (__INTERRUPT__)) == (__INTERRUPT__)) ? SET : RESET)
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__) ((__HANDLE__)->Instance->PSC = (__PRESC__))
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) ((__HANDLE__)->Instance->CNT = (__COUNTER__))
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) \
+    do { \
+        (__HANDLE__)->Instance->ARR = (__AUTORELOAD__); \
+        (__HANDLE__)->Init.Period = (__AUTORELOAD__); \
+    } while (0)
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+    (*(&(__HANDLE__)->Instance->CCR1 + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+
+/* ---------------- I2C ---------------- */
+
+typedef struct {
+    I2C_TypeDef *Instance;
+} I2C_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                          uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                         uint8_t *pData, uint16_t Size, uint32_t Timeout);
+
+/* ---------------- Flash ---------------- */
+
+#define FLASH_BASE                 0x08000000UL
+#define FLASH_TYPEPROGRAM_HALFWORD 0x01U
+#define FLASH_TYPEPROGRAM_WORD     0x02U
+#define FLASH_TYPEERASE_PAGES      0x00U
+
+typedef struct {
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t PageAddress;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+
+/* ---------------- 系统 ---------------- */
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+#endif /* __STM32F1xx_HAL_H */
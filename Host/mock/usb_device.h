@@ -0,0 +1,11 @@
+// 主机端替身：USB设备初始化由 hal_mock 完成
+
+#ifndef __USB_DEVICE__H__
+#define __USB_DEVICE__H__
+
+// 与目标相同，经 usbd_conf.h 间接包含 main.h（引脚定义）
+#include "main.h"
+
+void MX_USB_DEVICE_Init(void);
+
+#endif /* __USB_DEVICE__H__ */
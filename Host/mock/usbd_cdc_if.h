@@ -0,0 +1,25 @@
+// 主机端替身：与 USB_DEVICE/App/usbd_cdc_if.h 导出相同的发送接口，
+// 发送的数据由 hal_mock 截获，见 Mock_CdcRead()
+
+#ifndef __USBD_CDC_IF_H__
+#define __USBD_CDC_IF_H__
+
+#include "stm32f1xx_hal.h"
+
+#define APP_RX_DATA_SIZE  64
+#define APP_TX_DATA_SIZE  1024
+
+#define USBD_OK    0U
+#define USBD_BUSY  1U
+#define USBD_FAIL  3U
+
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
+void CDC_ResumeReceive_FS(void);
+uint8_t CDC_Write_FS(const uint8_t* Buf, uint16_t Len);
+void CDC_BeginMessage_FS(void);
+void CDC_Append_FS(const uint8_t* Buf, uint16_t Len);
+uint8_t CDC_EndMessage_FS(void);
+void CDC_GetTxStats_FS(uint16_t *high_water, uint32_t *overflow);
+uint8_t CDC_TxReady_FS(uint16_t Len);
+
+#endif /* __USBD_CDC_IF_H__ */
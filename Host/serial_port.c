@@ -0,0 +1,74 @@
+#include "serial_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static int serial_fd = -1;
+
+double Serial_NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int Serial_Open(const char *path) {
+    struct termios tio;
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH);
+    serial_fd = fd;
+    return 0;
+}
+
+void Serial_Close(void) {
+    if (serial_fd >= 0) {
+        close(serial_fd);
+        serial_fd = -1;
+    }
+}
+
+int Serial_ReadByte(uint8_t *byte) {
+    struct pollfd pfd = { serial_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, SERIAL_READ_TIMEOUT_MS) <= 0) return -1;
+    return read(serial_fd, byte, 1) == 1 ? 0 : -1;
+}
+
+int Serial_WriteAll(const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(serial_fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 读取一行ASCII应答（以\n结尾），返回读取的字节数
+int Serial_ReadLine(char *buf, size_t size) {
+    size_t len = 0;
+    uint8_t byte;
+    while (Serial_ReadByte(&byte) == 0) {
+        if (len + 1 < size) buf[len] = (char)byte;
+        len++;
+        if (byte == '\n') {
+            buf[len < size ? len : size - 1] = '\0';
+            return (int)len;
+        }
+    }
+    return -1;
+}
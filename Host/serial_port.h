@@ -0,0 +1,20 @@
+// 主机端工具共用的串口(USB CDC)读写函数，同一时刻只打开一个设备
+
+#ifndef __SERIAL_PORT_H__
+#define __SERIAL_PORT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERIAL_READ_TIMEOUT_MS 1000
+
+int Serial_Open(const char *path);
+void Serial_Close(void);
+int Serial_ReadByte(uint8_t *byte);
+int Serial_WriteAll(const uint8_t *data, size_t len);
+int Serial_ReadLine(char *buf, size_t size);
+
+// CLOCK_MONOTONIC 微秒
+double Serial_NowUs(void);
+
+#endif /* __SERIAL_PORT_H__ */
@@ -0,0 +1,130 @@
+#include "etch_model.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    size_t offset;
+} ParamName_t;
+
+#define PARAM(field) { #field, offsetof(EtchParams_t, field) }
+
+// 脚本中 "model <名称> <值>" 使用的名称，即字段名
+static const ParamName_t param_names[] = {
+    PARAM(i0_ua),
+    PARAM(break_ua),
+    PARAM(residual_ua),
+    PARAM(break_s),
+    PARAM(break_jitter_s),
+    PARAM(shape),
+    PARAM(tail_ms),
+    PARAM(lift_ua_per_mm),
+    PARAM(mm_per_step),
+    PARAM(noise_ua),
+    PARAM(glitch_per_s),
+    PARAM(glitch_depth),
+    PARAM(glitch_ms),
+};
+#define PARAM_NAME_COUNT (sizeof(param_names) / sizeof(param_names[0]))
+
+void EtchModel_Defaults(EtchParams_t *params) {
+    params->i0_ua = 600;
+    params->break_ua = 200;
+    params->residual_ua = 15;
+    params->break_s = 60;
+    params->break_jitter_s = 5;
+    params->shape = 0.5;
+    params->tail_ms = 2;
+    params->lift_ua_per_mm = 10;
+    params->mm_per_step = 0.005;
+    params->noise_ua = 8;
+    params->glitch_per_s = 0.05;
+    params->glitch_depth = 0.8;
+    params->glitch_ms = 3;
+}
+
+int EtchModel_SetParam(EtchParams_t *params, const char *name, double value) {
+    for (size_t i = 0; i < PARAM_NAME_COUNT; i++) {
+        if (strcmp(name, param_names[i].name) == 0) {
+            *(double *)((char *)params + param_names[i].offset) = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void EtchModel_Print(const EtchParams_t *params) {
+    for (size_t i = 0; i < PARAM_NAME_COUNT; i++) {
+        printf("%s%s=%g", i ? " " : "", param_names[i].name,
+               *(const double *)((const char *)params + param_names[i].offset));
+    }
+    printf("\n");
+}
+
+// xorshift64*，每次刻蚀独立的随机序列
+static double EtchCell_Uniform(EtchCell_t *cell) {
+    cell->rng ^= cell->rng >> 12;
+    cell->rng ^= cell->rng << 25;
+    cell->rng ^= cell->rng >> 27;
+    return ((cell->rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double EtchCell_Gauss(EtchCell_t *cell) {
+    double u1 = EtchCell_Uniform(cell);
+    double u2 = EtchCell_Uniform(cell);
+
+    if (u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static void EtchCell_NextGlitch(EtchCell_t *cell, double after_s) {
+    if (cell->p.glitch_per_s <= 0) {
+        cell->glitch_start_s = INFINITY;
+        return;
+    }
+    cell->glitch_start_s = after_s - log(1.0 - EtchCell_Uniform(cell)) / cell->p.glitch_per_s;
+}
+
+void EtchCell_Start(EtchCell_t *cell, const EtchParams_t *params, uint64_t seed) {
+    cell->p = *params;
+    // splitmix64 打散种子，避免相邻种子的序列相关
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    cell->rng = (seed ^ (seed >> 31)) | 1;
+
+    cell->break_s = params->break_s + params->break_jitter_s * EtchCell_Gauss(cell);
+    if (cell->break_s < 0.1 * params->break_s) cell->break_s = 0.1 * params->break_s;
+    EtchCell_NextGlitch(cell, 0);
+}
+
+double EtchCell_Current(EtchCell_t *cell, double t_s, int32_t steps, bool powered, uint32_t avg) {
+    const EtchParams_t *p = &cell->p;
+    double current;
+
+    if (!powered) return 0;
+
+    if (t_s < cell->break_s) {
+        double neck = pow(1.0 - t_s / cell->break_s, p->shape);
+        current = p->break_ua + (p->i0_ua - p->break_ua) * neck;
+        current -= p->lift_ua_per_mm * p->mm_per_step * (steps > 0 ? steps : 0);
+        if (current < p->break_ua) current = p->break_ua;
+    } else {
+        double tail = p->tail_ms > 0 ? exp(-(t_s - cell->break_s) * 1000.0 / p->tail_ms) : 0;
+        current = p->residual_ua + (p->break_ua - p->residual_ua) * tail;
+    }
+
+    // 瞬时跌落（仅断线前，断线后电流已很小）
+    while (t_s >= cell->glitch_start_s + p->glitch_ms / 1000.0) {
+        EtchCell_NextGlitch(cell, cell->glitch_start_s + p->glitch_ms / 1000.0);
+    }
+    if (t_s >= cell->glitch_start_s && t_s < cell->break_s) {
+        current *= 1.0 - p->glitch_depth;
+    }
+
+    current += p->noise_ua / sqrt(avg ? avg : 1) * EtchCell_Gauss(cell);
+    return current;
+}
@@ -0,0 +1,43 @@
+// 刻蚀池电流模型：颈缩阶段电流随时间下降，断线后按时间常数跌落到残余电流，
+// 叠加高斯噪声和气泡引起的瞬时跌落。时间单位为秒，电流单位为uA（与固件一致）。
+
+#ifndef __ETCH_MODEL_H__
+#define __ETCH_MODEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    double i0_ua;           // 开始时电流
+    double break_ua;        // 断线前一刻的电流
+    double residual_ua;     // 断线后残余电流
+    double break_s;         // 断线时间均值
+    double break_jitter_s;  // 断线时间标准差
+    double shape;           // 颈缩曲线指数：I = break + (i0 - break) * (1 - t/T)^shape
+    double tail_ms;         // 断线后电流下降时间常数
+    double lift_ua_per_mm;  // 提拉使浸入面积减小引起的电流下降
+    double mm_per_step;     // 每步提拉距离
+    double noise_ua;        // 单次采样噪声标准差（INA236平均后按sqrt(N)减小）
+    double glitch_per_s;    // 瞬时跌落平均每秒次数
+    double glitch_depth;    // 跌落比例（0~1）
+    double glitch_ms;       // 跌落持续时间
+} EtchParams_t;
+
+typedef struct {
+    EtchParams_t p;
+    uint64_t rng;
+    double break_s;         // 本次刻蚀的实际断线时间
+    double glitch_start_s;  // 下一次（或当前）跌落的开始时间
+} EtchCell_t;
+
+void EtchModel_Defaults(EtchParams_t *params);
+// 按名称设置参数，未知名称返回-1
+int EtchModel_SetParam(EtchParams_t *params, const char *name, double value);
+void EtchModel_Print(const EtchParams_t *params);
+
+// 开始一次刻蚀：抽取断线时间，seed相同则结果相同
+void EtchCell_Start(EtchCell_t *cell, const EtchParams_t *params, uint64_t seed);
+// t_s时刻、提拉steps步后的测量电流；powered为电流开关状态，avg为INA236平均次数
+double EtchCell_Current(EtchCell_t *cell, double t_s, int32_t steps, bool powered, uint32_t avg);
+
+#endif /* __ETCH_MODEL_H__ */
@@ -0,0 +1,220 @@
+#define _GNU_SOURCE
+#include "sim_batch.h"
+#include "sim_core.h"
+#include "hal_mock.h"
+#include "usbd_cdc_if.h"
+#include "stepper_motor.h"
+#include "sequence_controller.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const char *const outcome_names[] = { "ok", "false_trip", "missed", "error" };
+
+const char *SimBatch_OutcomeName(uint32_t outcome) {
+    return outcome_names[outcome < RUN_OUTCOME_COUNT ? outcome : RUN_ERROR];
+}
+
+void SimBatch_Defaults(Scenario_t *sc) {
+    memset(sc, 0, sizeof(*sc));
+    sc->loop_us = 500;
+    sc->timeout_s = 10;
+    sc->seed = 1;
+    EtchModel_Defaults(&sc->model);
+}
+
+char *SimBatch_Trim(char *s) {
+    char *end;
+
+    while (*s == ' ' || *s == '\t') s++;
+    end = s + strlen(s);
+    while (end > s && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+        *--end = '\0';
+    }
+    return s;
+}
+
+int SimBatch_AddCommand(Scenario_t *sc, const char *command) {
+    if (sc->command_count >= SIM_MAX_COMMANDS || strlen(command) >= SIM_MAX_LINE) return -1;
+    strcpy(sc->commands[sc->command_count++], command);
+    return 0;
+}
+
+int SimBatch_ParseLine(Scenario_t *sc, const char *line, int line_no) {
+    const char *tool = program_invocation_short_name;
+    char name[64];
+    double value;
+
+    if (sscanf(line, "model %63s %lf", name, &value) == 2) {
+        if (EtchModel_SetParam(&sc->model, name, value) != 0) {
+            fprintf(stderr, "%s: line %d: unknown model parameter %s\n", tool, line_no, name);
+            return -1;
+        }
+    } else if (sscanf(line, "sim %63s %lf", name, &value) == 2) {
+        if (strcmp(name, "loop_us") == 0 && value >= 1) {
+            sc->loop_us = (uint32_t)value;
+        } else if (strcmp(name, "timeout_s") == 0 && value > 0) {
+            sc->timeout_s = value;
+        } else if (strcmp(name, "seed") == 0) {
+            sc->seed = (uint64_t)value;
+        } else {
+            fprintf(stderr, "%s: line %d: invalid sim setting %s\n", tool, line_no, name);
+            return -1;
+        }
+    } else if (SimBatch_AddCommand(sc, line) != 0) {
+        fprintf(stderr, "%s: line %d: too many or too long firmware commands\n", tool, line_no);
+        return -1;
+    }
+    return 0;
+}
+
+static uint64_t loop_next_ns;
+
+// 执行到下一次主循环的外设事件，再执行一遍主循环
+static void Sim_StepLoop(const Scenario_t *sc) {
+    SimCore_RunUntil(loop_next_ns);
+    SimCore_MainLoop();
+    loop_next_ns = SimCore_Now() + (uint64_t)sc->loop_us * 1000;
+}
+
+// 发送一条命令并运行主循环直到收到应答，应答为错误时返回-1
+static int Sim_Command(const Scenario_t *sc, const char *cmd) {
+    char reply[APP_TX_DATA_SIZE + 1];
+    uint32_t len = 0;
+    char line[SIM_MAX_LINE + 2];
+    int n = snprintf(line, sizeof(line), "%s\n", cmd);
+
+    Mock_CdcReceive((const uint8_t *)line, (uint32_t)n);
+    for (int pass = 0; pass < 100; pass++) {
+        Sim_StepLoop(sc);
+        len += Mock_CdcRead((uint8_t *)reply + len, APP_TX_DATA_SIZE - len);
+        reply[len] = '\0';
+        if (strstr(reply, "\"Cmd\"") != NULL && strchr(reply, '\n') != NULL) {
+            if (strstr(reply, "\"Status\": \"Error\"") == NULL) return 0;
+            fprintf(stderr, "%s: \"%s\" -> %s", program_invocation_short_name, cmd, reply);
+            return -1;
+        }
+    }
+    fprintf(stderr, "%s: no reply to \"%s\"\n", program_invocation_short_name, cmd);
+    return -1;
+}
+
+void SimBatch_Run(const Scenario_t *sc, uint32_t index, RunResult_t *result) {
+    uint8_t discard[APP_TX_DATA_SIZE];
+    uint64_t on_ns = 0;
+    uint64_t break_ns = UINT64_MAX;
+    uint64_t cut_ns = 0;
+    int32_t break_pos = 0;
+    int32_t stop_pos = 0;
+    bool break_seen = false;
+
+    memset(result, 0, sizeof(*result));
+    result->index = index;
+    result->outcome = RUN_ERROR;
+    result->cut_s = -1;
+
+    loop_next_ns = 0;
+    SimCore_Init(&sc->model, sc->seed * 1000003ULL + index);
+    result->break_s = SimCore_Cell()->break_s;
+
+    for (int i = 0; i < sc->command_count; i++) {
+        if (Sim_Command(sc, sc->commands[i]) != 0) return;
+    }
+    if (Sim_Command(sc, "START") != 0) return;
+
+    for (;;) {
+        SequenceState_t state = SequenceController_GetState();
+        uint64_t now_ns;
+
+        // 主循环执行FINAL_MOVE时停止提拉，之前记录的位置即为停止位置
+        if (state == SEQ_FINAL_MOVE) stop_pos = StepperMotor_GetPosition();
+        Sim_StepLoop(sc);
+        Mock_CdcRead(discard, sizeof(discard));
+        now_ns = SimCore_Now();
+
+        if (on_ns == 0 && SimCore_PoweredAt() != 0) {
+            on_ns = SimCore_PoweredAt();
+            break_ns = on_ns + (uint64_t)(result->break_s * 1e9);
+        }
+        if (!break_seen && now_ns >= break_ns) {
+            break_seen = true;
+            break_pos = StepperMotor_GetPosition();
+        }
+        if (on_ns != 0 && cut_ns == 0 && !SimCore_Powered()) {
+            cut_ns = now_ns;
+        }
+
+        state = SequenceController_GetState();
+        if (state == SEQ_COMPLETE || (on_ns != 0 && state == SEQ_IDLE)) break;
+        if (break_seen && now_ns > break_ns + (uint64_t)(sc->timeout_s * 1e9)) break;
+        if (on_ns == 0 && now_ns > (uint64_t)1e9) return;  // 电流开关始终未接通
+    }
+
+    result->virtual_s = (double)SimCore_Now() / 1e9;
+    if (cut_ns == 0) {
+        result->outcome = RUN_MISSED;
+        return;
+    }
+    result->cut_s = (double)(cut_ns - on_ns) / 1e9;
+    if (cut_ns < break_ns) {
+        result->outcome = RUN_FALSE_TRIP;
+        return;
+    }
+    result->outcome = RUN_OK;
+    result->latency_ms = (double)(cut_ns - break_ns) / 1e6;
+    result->overshoot_steps = stop_pos - break_pos;
+}
+
+
+/* ---------------- 并行执行 ---------------- */
+
+static void Sim_Collect(int fd, RunResult_t *results, uint32_t count) {
+    RunResult_t r;
+
+    while (read(fd, &r, sizeof(r)) == (ssize_t)sizeof(r)) {
+        if (r.index < count) results[r.index] = r;
+    }
+}
+
+// 每次刻蚀fork一个子进程，保证固件静态变量从初始状态开始
+int SimBatch_RunMany(const Scenario_t *sc, uint32_t count, int jobs, RunResult_t *results) {
+    int fds[2];
+    int active = 0;
+
+    if (pipe(fds) != 0) return -1;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    for (uint32_t i = 0; i < count; i++) {
+        results[i].index = i;
+        results[i].outcome = RUN_ERROR;
+        results[i].cut_s = -1;
+    }
+    fflush(NULL);
+
+    for (uint32_t i = 0; i < count || active > 0;) {
+        if (i < count && active < jobs) {
+            pid_t pid = fork();
+            if (pid < 0) return -1;
+            if (pid == 0) {
+                RunResult_t r;
+                close(fds[0]);
+                SimBatch_Run(sc, i, &r);
+                if (write(fds[1], &r, sizeof(r)) != (ssize_t)sizeof(r)) _exit(1);
+                _exit(0);
+            }
+            active++;
+            i++;
+            continue;
+        }
+        if (wait(NULL) > 0) active--;
+        Sim_Collect(fds[0], results, count);
+    }
+    Sim_Collect(fds[0], results, count);
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
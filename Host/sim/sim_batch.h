@@ -0,0 +1,62 @@
+// sim_batch: 在仿真中运行一批刻蚀（每次刻蚀一个子进程），tm_sim 与 tm_opt 共用
+//
+// 每次刻蚀：SimCore_Init（种子 seed*1000003+序号）→ 依次发送命令 → START → 运行到序列结束或超时。
+// 结果：
+//   延迟   = 断线到电流开关断开的时间
+//   过冲   = 断线到提拉停止之间多走的步数
+//   误触发 = 断线之前电流开关已断开
+//   漏检   = 断线后 timeout_s 内未断开
+
+#ifndef __SIM_BATCH_H__
+#define __SIM_BATCH_H__
+
+#include "etch_model.h"
+
+#include <stdint.h>
+
+#define SIM_MAX_COMMANDS 32
+#define SIM_MAX_LINE     128
+
+typedef struct {
+    uint32_t loop_us;
+    double timeout_s;
+    uint64_t seed;
+    EtchParams_t model;
+    char commands[SIM_MAX_COMMANDS][SIM_MAX_LINE];
+    int command_count;
+} Scenario_t;
+
+typedef enum {
+    RUN_OK = 0,
+    RUN_FALSE_TRIP,
+    RUN_MISSED,
+    RUN_ERROR,
+    RUN_OUTCOME_COUNT
+} RunOutcome_t;
+
+typedef struct {
+    uint32_t index;
+    uint32_t outcome;
+    double break_s;          // 相对电流开关接通的断线时间
+    double cut_s;            // 电流开关断开时间，未断开为-1
+    double latency_ms;
+    int32_t overshoot_steps;
+    double virtual_s;        // 本次仿真的虚拟时长
+} RunResult_t;
+
+const char *SimBatch_OutcomeName(uint32_t outcome);
+
+// loop_us 500，timeout_s 10，seed 1，刻蚀模型取默认值，没有命令
+void SimBatch_Defaults(Scenario_t *sc);
+// 脚本中与运行方式无关的一行：model / sim / 其他行作为固件命令；出错时输出原因并返回-1
+int SimBatch_ParseLine(Scenario_t *sc, const char *line, int line_no);
+int SimBatch_AddCommand(Scenario_t *sc, const char *command);
+// 去掉首尾空白和行尾（原地修改）
+char *SimBatch_Trim(char *s);
+
+// 在当前进程中运行一次刻蚀（会重新初始化固件）
+void SimBatch_Run(const Scenario_t *sc, uint32_t index, RunResult_t *result);
+// 以最多 jobs 个子进程运行序号 0..count-1 的刻蚀，出错返回-1
+int SimBatch_RunMany(const Scenario_t *sc, uint32_t count, int jobs, RunResult_t *results);
+
+#endif /* __SIM_BATCH_H__ */
@@ -0,0 +1,236 @@
+#include "sim_core.h"
+#include "hal_mock.h"
+#include "main.h"
+#include "eeprom_emulation.h"
+#include "system_state.h"
+#include "stepper_motor.h"
+#include "ina236.h"
+#include "command_parser.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "telemetry.h"
+#include "event_queue.h"
+#include "perf_monitor.h"
+
+#include <math.h>
+
+#define SIM_NEVER        UINT64_MAX
+#define TIM2_TICK_NS     100000ULL   // TIM2预分频后10kHz
+
+static uint64_t now_ns;
+static uint64_t tim1_next_ns;
+static uint64_t tim2_overflow_ns;
+static uint64_t conv_next_ns;
+
+static EtchCell_t cell;
+static EtchParams_t cell_params;
+static uint64_t cell_seed;
+static uint32_t cell_count;
+static uint32_t ina236_avg;
+static bool powered;
+static uint64_t powered_at_ns;
+static int32_t powered_at_pos;
+
+static void SimCore_AdvanceTo(uint64_t t_ns) {
+    uint32_t delta_us = (uint32_t)(t_ns / 1000 - now_ns / 1000);
+
+    if (delta_us != 0) Mock_AdvanceUs(delta_us);
+    now_ns = t_ns;
+}
+
+// TIM1计数时钟72MHz，一个更新周期为 (PSC+1)*(ARR+1) 个计数
+static uint64_t SimCore_Tim1PeriodNs(void) {
+    uint64_t ticks = (uint64_t)(TIM1->PSC + 1) * (TIM1->ARR + 1);
+    return ticks * 1000 / (MOCK_CORE_CLOCK_HZ / 1000000);
+}
+
+static bool SimCore_Tim1Running(void) {
+    return (TIM1->CR1 & TIM_CR1_CEN) && (TIM1->DIER & TIM_IT_UPDATE);
+}
+
+// 主循环或中断可能启停TIM1，每次处理后重新核对调度
+static void SimCore_Tim1Reschedule(void) {
+    if (!SimCore_Tim1Running()) {
+        tim1_next_ns = SIM_NEVER;
+    } else if (tim1_next_ns == SIM_NEVER) {
+        tim1_next_ns = now_ns + SimCore_Tim1PeriodNs();
+    }
+}
+
+static void SimCore_Tim2SyncCounter(void) {
+    TIM2->CNT = (uint32_t)((now_ns / TIM2_TICK_NS) & 0xFFFF);
+}
+
+// 圈信号上升沿：捕获当前计数，读取CCR4即清除CC4IF
+static void SimCore_RoundEdge(void) {
+    SimCore_Tim2SyncCounter();
+    TIM2->CCR4 = TIM2->CNT;
+    TIM2->SR |= TIM_FLAG_CC4;
+    RoundMonitor_TIM2_IRQHandler();
+    TIM2->SR &= ~TIM_FLAG_CC4;
+}
+
+static int32_t FloorDiv(int32_t a, int32_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static void SimCore_Tim1Update(void) {
+    int32_t before = StepperMotor_GetPosition();
+    int32_t after;
+    uint16_t ppr = g_system_state.pulses_per_rev;
+
+    TIM1->SR |= TIM_FLAG_UPDATE;
+    StepperMotor_TIM1_Update_IRQHandler();
+    tim1_next_ns = SIM_NEVER;
+    SimCore_Tim1Reschedule();
+
+    // 机械上无失步，每走过一个整圈位置产生一次圈信号
+    after = StepperMotor_GetPosition();
+    if (ppr != 0 && after != before) {
+        int32_t lo = before < after ? before : after;
+        int32_t hi = before < after ? after : before;
+        if (FloorDiv(hi, ppr) != FloorDiv(lo, ppr)) {
+            SimCore_RoundEdge();
+        }
+    }
+}
+
+static void SimCore_Tim2Overflow(void) {
+    SimCore_Tim2SyncCounter();
+    TIM2->SR |= TIM_FLAG_UPDATE;
+    RoundMonitor_TIM2_IRQHandler();
+    tim2_overflow_ns += 65536 * TIM2_TICK_NS;
+}
+
+// INA236转换周期：MODE选择分流/总线通道，每通道转换时间乘以平均次数
+static uint64_t SimCore_Ina236PeriodNs(uint32_t *avg) {
+    static const uint16_t conv_us[8] = { 140, 204, 332, 588, 1100, 2116, 4156, 8244 };
+    static const uint16_t avg_count[8] = { 1, 4, 16, 64, 128, 256, 512, 1024 };
+    uint16_t config = Mock_Ina236Config();
+    uint16_t mode = config & 0x7;
+    uint64_t us = 0;
+
+    *avg = avg_count[(config >> 9) & 0x7];
+    if (mode & 0x1) us += conv_us[(config >> 3) & 0x7];
+    if (mode & 0x2) us += conv_us[(config >> 6) & 0x7];
+    if (mode == 0 || mode == 4 || us == 0) return 0;
+    return us * *avg * 1000;
+}
+
+static void SimCore_Convert(void) {
+    double t_s = powered_at_ns ? (double)(now_ns - powered_at_ns) / 1e9 : 0;
+    double ua = EtchCell_Current(&cell, t_s, StepperMotor_GetPosition() - powered_at_pos, powered, ina236_avg);
+    double raw = round(ua * 4);  // 固件按 raw * 250 / 1000 换算为uA
+
+    if (raw > 32767) raw = 32767;
+    if (raw < -32768) raw = -32768;
+    Mock_Ina236SetShunt((int16_t)raw);
+    conv_next_ns = now_ns + SimCore_Ina236PeriodNs(&ina236_avg);
+}
+
+void SimCore_Init(const EtchParams_t *model, uint64_t seed) {
+    now_ns = 0;
+    tim1_next_ns = SIM_NEVER;
+    tim2_overflow_ns = 65536 * TIM2_TICK_NS;
+    conv_next_ns = SIM_NEVER;
+    ina236_avg = 1;
+    powered = false;
+    powered_at_ns = 0;
+    powered_at_pos = 0;
+    cell_params = *model;
+    cell_seed = seed;
+    cell_count = 0;
+
+    Mock_Init();
+    PerfMonitor_Init();
+    EventQueue_Init();
+    EE_Init();
+    SystemState_Init();
+    StepperMotor_Init();
+    INA236_Init();
+    CommandParser_Init();
+    SequenceController_Init();
+    Homing_Init();
+    RoundMonitor_Init();
+    EtchControl_Init();
+    Telemetry_Init();
+
+    EtchCell_Start(&cell, model, seed);
+}
+
+// 电流开关每次由断开变为接通都视为装入了新丝：第一次使用初始化时抽取的断线时间，
+// 之后每次以 seed+次数 重新开始一次刻蚀（tm_emu 上可以连续运行多次序列）
+static void SimCore_UpdatePower(void) {
+    bool on = Mock_GpioOutput(SWITCH_CURRENT_GPIO_Port, SWITCH_CURRENT_Pin);
+
+    if (on && !powered) {
+        if (cell_count++ > 0) EtchCell_Start(&cell, &cell_params, cell_seed + cell_count);
+        powered_at_ns = now_ns;
+        powered_at_pos = StepperMotor_GetPosition();
+    }
+    powered = on;
+}
+
+// 时间相同时依次为TIM1、TIM2、INA236
+void SimCore_RunUntil(uint64_t t_ns) {
+    for (;;) {
+        uint64_t next = tim1_next_ns;
+
+        if (tim2_overflow_ns < next) next = tim2_overflow_ns;
+        if (conv_next_ns < next) next = conv_next_ns;
+        if (next > t_ns) break;
+        SimCore_AdvanceTo(next);
+
+        if (next == tim1_next_ns) {
+            SimCore_Tim1Update();
+        } else if (next == tim2_overflow_ns) {
+            SimCore_Tim2Overflow();
+        } else {
+            SimCore_Convert();
+        }
+    }
+    SimCore_AdvanceTo(t_ns);
+}
+
+void SimCore_MainLoop(void) {
+    uint16_t current;
+
+    SimCore_Tim2SyncCounter();
+    if (INA236_ReadCurrent(&current)) {
+        SystemState_UpdateCurrent(current);
+        EtchControl_Sample((int16_t)current);
+    }
+    SystemState_ZeroPoint();
+    StepperMotor_Process();
+    SequenceController_Process();
+    Homing_Process();
+    RoundMonitor_Process();
+    CommandParser_Poll();
+    EventQueue_Process();
+    Telemetry_Process();
+
+    SimCore_Tim1Reschedule();
+    if (conv_next_ns == SIM_NEVER) {
+        uint64_t period = SimCore_Ina236PeriodNs(&ina236_avg);
+        if (period != 0) conv_next_ns = now_ns + period;
+    }
+    SimCore_UpdatePower();
+}
+
+uint64_t SimCore_Now(void) {
+    return now_ns;
+}
+
+bool SimCore_Powered(void) {
+    return powered;
+}
+
+uint64_t SimCore_PoweredAt(void) {
+    return powered_at_ns;
+}
+
+const EtchCell_t *SimCore_Cell(void) {
+    return &cell;
+}
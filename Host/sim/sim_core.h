@@ -0,0 +1,27 @@
+// sim_core: 固件（libtip_host.a）与外设事件在虚拟时间中运行，tm_sim 与 tm_emu 共用
+//
+// 外设事件：INA236按配置寄存器的转换周期更新分流寄存器（电流来自 etch_model），
+// TIM1按PSC/ARR产生更新中断（步进脉冲），每圈一次TIM2输入捕获，以及TIM2溢出。
+// 主循环何时执行由调用者决定（仿真按固定周期，仿真终端按实际时间）。
+
+#ifndef __SIM_CORE_H__
+#define __SIM_CORE_H__
+
+#include "etch_model.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 复位HAL替身并按 main.c 的顺序初始化固件，时间从0开始
+void SimCore_Init(const EtchParams_t *model, uint64_t seed);
+// 依次执行时间不晚于t_ns的外设事件，然后把时间推进到t_ns
+void SimCore_RunUntil(uint64_t t_ns);
+// 在当前时间执行一遍主循环（与 main.c 相同）
+void SimCore_MainLoop(void);
+
+uint64_t SimCore_Now(void);
+bool SimCore_Powered(void);          // 电流开关状态（主循环后更新）
+uint64_t SimCore_PoweredAt(void);    // 电流开关最近一次接通的时间，0表示尚未接通
+const EtchCell_t *SimCore_Cell(void);
+
+#endif /* __SIM_CORE_H__ */
@@ -0,0 +1,240 @@
+// tm_emu: 在伪终端后运行固件，主机端工具和脚本可以像连接 /dev/ttyACM0 一样连接
+//
+// 用法: tm_emu [-l 链接路径] [-u 主循环us] [-p 每帧包数] [-m 模型参数=值]...
+//   例: ./tm_emu -l /tmp/ttyTM &  然后  ./tm_ping -n 1000 /tmp/ttyTM
+//
+// 启动后在标准输出打印伪终端路径。固件与外设事件由 sim_core 驱动，虚拟时间跟随实际时间，
+// 因此 HAL_GetTick()、DWT周期计数（PING）和遥测周期都与实际时间一致。
+//
+// USB CDC 行为与目标一致：
+//   - OUT：每次最多读取64字节作为一个包交给 CommandParser_USBReceiveCallback()，
+//     解析器暂停接收（环形缓冲区将满）时不再读取伪终端，主机写入随之阻塞，相当于NAK
+//   - IN：发送队列按64字节分包写入伪终端，主机未读取导致写入失败时相当于 USBD_BUSY，
+//     发送队列满后解析器停止处理命令
+//   - 每个1ms帧内OUT、IN各最多传输 -p 个包（默认19，全速批量传输的上限）
+// Ctrl-C 退出时输出收发统计。
+
+#define _GNU_SOURCE
+#include "sim_core.h"
+#include "hal_mock.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define EMU_FRAME_NS  1000000ULL
+
+typedef struct {
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t rx_pauses;     // 解析器暂停接收的次数
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t tx_busy;       // 主机未读取，IN包未能发出的次数
+    uint64_t loops;
+} EmuStats_t;
+
+static volatile sig_atomic_t stop_requested;
+
+static void Emu_Signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t Emu_WallNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 打开伪终端主设备，并保持从设备打开（无客户端时主设备读取不会返回EIO）
+static int Emu_OpenPty(int *slave_fd, char *slave_name, size_t size) {
+    struct termios tio;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0) return -1;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 ||
+        ptsname_r(master, slave_name, size) != 0) {
+        close(master);
+        return -1;
+    }
+    *slave_fd = open(slave_name, O_RDWR | O_NOCTTY);
+    if (*slave_fd < 0) {
+        close(master);
+        return -1;
+    }
+    // 客户端打开前先设为原始模式，避免回显和换行转换
+    if (tcgetattr(*slave_fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(*slave_fd, TCSANOW, &tio);
+    }
+    fcntl(master, F_SETFL, O_NONBLOCK);
+    return master;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "usage: tm_emu [-l link] [-u loop_us] [-p packets_per_frame] [-m name=value]...\n");
+}
+
+int main(int argc, char *argv[]) {
+    EtchParams_t model;
+    EmuStats_t stats = { 0 };
+    const char *link_path = NULL;
+    uint32_t loop_us = 500;
+    uint32_t packets_per_frame = 19;
+    char slave_name[64];
+    int slave_fd;
+    int master;
+    int opt;
+    uint8_t tx_packet[MOCK_CDC_PACKET_SIZE];
+    uint32_t tx_len = 0;
+    uint32_t tx_off = 0;
+    uint64_t start_ns;
+    uint64_t next_loop_ns = 0;
+    uint64_t frame = 0;
+    uint32_t rx_budget = 0;
+    uint32_t tx_budget = 0;
+
+    EtchModel_Defaults(&model);
+    while ((opt = getopt(argc, argv, "l:u:p:m:h")) != -1) {
+        switch (opt) {
+        case 'l':
+            link_path = optarg;
+            break;
+        case 'u':
+            loop_us = (uint32_t)atoi(optarg);
+            if (loop_us < 1) loop_us = 1;
+            break;
+        case 'p':
+            packets_per_frame = (uint32_t)atoi(optarg);
+            if (packets_per_frame < 1) packets_per_frame = 1;
+            break;
+        case 'm': {
+            char name[64];
+            double value;
+            if (sscanf(optarg, "%63[^=]=%lf", name, &value) != 2 ||
+                EtchModel_SetParam(&model, name, value) != 0) {
+                fprintf(stderr, "tm_emu: invalid model parameter %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    if (optind != argc) {
+        Usage();
+        return 1;
+    }
+
+    master = Emu_OpenPty(&slave_fd, slave_name, sizeof(slave_name));
+    if (master < 0) {
+        perror("tm_emu: pty");
+        return 1;
+    }
+    if (link_path != NULL) {
+        unlink(link_path);
+        if (symlink(slave_name, link_path) != 0) {
+            perror("tm_emu: symlink");
+            return 1;
+        }
+    }
+    signal(SIGINT, Emu_Signal);
+    signal(SIGTERM, Emu_Signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    SimCore_Init(&model, (uint64_t)time(NULL));
+    printf("%s\n", slave_name);
+    fflush(stdout);
+    start_ns = Emu_WallNs();
+
+    while (!stop_requested) {
+        uint64_t now = Emu_WallNs() - start_ns;
+        uint64_t wake;
+        struct pollfd pfd = { .fd = master, .events = 0 };
+        struct timespec timeout;
+
+        SimCore_RunUntil(now);
+
+        // 新的USB帧，重置每帧包数
+        if (now / EMU_FRAME_NS != frame) {
+            frame = now / EMU_FRAME_NS;
+            rx_budget = packets_per_frame;
+            tx_budget = packets_per_frame;
+        }
+
+        // OUT：解析器未暂停时每次读取一个包
+        while (rx_budget > 0 && Mock_CdcRxPending() == 0) {
+            uint8_t packet[MOCK_CDC_PACKET_SIZE];
+            ssize_t n = read(master, packet, sizeof(packet));
+            if (n <= 0) break;
+            rx_budget--;
+            stats.rx_packets++;
+            stats.rx_bytes += (uint64_t)n;
+            Mock_CdcReceive(packet, (uint32_t)n);
+            if (Mock_CdcRxPending() != 0) stats.rx_pauses++;
+        }
+
+        if (now >= next_loop_ns) {
+            SimCore_MainLoop();
+            stats.loops++;
+            next_loop_ns = now + (uint64_t)loop_us * 1000;
+        }
+
+        // IN：发送队列按64字节分包，主机未读取时保留当前包下次重试
+        while (tx_budget > 0) {
+            ssize_t n;
+            if (tx_off == tx_len) {
+                tx_len = Mock_CdcRead(tx_packet, sizeof(tx_packet));
+                tx_off = 0;
+                if (tx_len == 0) break;
+            }
+            n = write(master, tx_packet + tx_off, tx_len - tx_off);
+            if (n < 0) {
+                if (errno == EAGAIN) stats.tx_busy++;
+                break;
+            }
+            tx_off += (uint32_t)n;
+            if (tx_off == tx_len) {
+                tx_budget--;
+                stats.tx_packets++;
+                stats.tx_bytes += tx_len;
+            }
+        }
+
+        // 等待到下一次主循环、下一帧（本帧配额已用完时）或伪终端可读写
+        wake = next_loop_ns;
+        if ((rx_budget == 0 || tx_budget == 0) && (frame + 1) * EMU_FRAME_NS < wake) {
+            wake = (frame + 1) * EMU_FRAME_NS;
+        }
+        if (rx_budget > 0 && Mock_CdcRxPending() == 0) pfd.events |= POLLIN;
+        if (tx_budget > 0 && (tx_off < tx_len || Mock_CdcTxQueued() > 0)) pfd.events |= POLLOUT;
+        now = Emu_WallNs() - start_ns;
+        if (wake > now) {
+            timeout.tv_sec = (time_t)((wake - now) / 1000000000ULL);
+            timeout.tv_nsec = (long)((wake - now) % 1000000000ULL);
+            ppoll(&pfd, 1, &timeout, NULL);
+        }
+    }
+
+    fprintf(stderr,
+            "tm_emu: %.1f s, %llu loops, rx %llu packets %llu bytes (%llu pauses), "
+            "tx %llu packets %llu bytes (%llu busy)\n",
+            (double)(Emu_WallNs() - start_ns) / 1e9, (unsigned long long)stats.loops,
+            (unsigned long long)stats.rx_packets, (unsigned long long)stats.rx_bytes,
+            (unsigned long long)stats.rx_pauses, (unsigned long long)stats.tx_packets,
+            (unsigned long long)stats.tx_bytes, (unsigned long long)stats.tx_busy);
+    if (link_path != NULL) unlink(link_path);
+    close(slave_fd);
+    close(master);
+    return 0;
+}
@@ -0,0 +1,199 @@
+// tm_sim: 刻蚀过程离散事件仿真，固件的序列控制与断线检测代码在虚拟时间中运行
+//
+// 用法: tm_sim [-j 并行数] [-o 结果.csv] <脚本|->
+//   例: ./tm_sim -o runs.csv sim/example.sim
+//
+// 固件部分直接链接 libtip_host.a（App层 + HAL替身），外设事件见 sim_core.c。
+// 每隔一个主循环周期（默认500us，约为100kHz I2C读一次INA236的时间）执行一遍主循环，
+// 事件之间直接跳过，不逐微秒推进。每次刻蚀在独立的子进程中运行，固件状态互不影响。
+//
+// 脚本每行一条：
+//   model <参数> <值>     刻蚀模型参数（见 etch_model.h）
+//   sim <参数> <值>       loop_us / timeout_s / seed
+//   run <次数> [标签]     以当前设置运行若干次刻蚀并输出统计
+//   其他行                作为固件命令在START之前依次发送（如 SET THRES 40），按出现顺序累积
+//
+// 每次刻蚀的结果：
+//   延迟   = 断线到电流开关断开的时间
+//   过冲   = 断线到提拉停止之间多走的步数
+//   误触发 = 断线之前电流开关已断开
+//   漏检   = 断线后 timeout_s 内未断开
+
+#include "sim_batch.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static int CompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void PrintStats(const char *name, const char *unit, double *v, uint32_t n) {
+    double sum = 0;
+
+    if (n == 0) {
+        printf("  %-10s -\n", name);
+        return;
+    }
+    qsort(v, n, sizeof(double), CompareDouble);
+    for (uint32_t i = 0; i < n; i++) sum += v[i];
+    printf("  %-10s mean %.2f  p50 %.2f  p95 %.2f  max %.2f %s\n", name,
+           sum / n, v[n / 2], v[(n * 95) / 100 < n ? (n * 95) / 100 : n - 1], v[n - 1], unit);
+}
+
+static void Report(const char *label, const RunResult_t *results, uint32_t count, double host_s) {
+    uint32_t outcomes[RUN_OUTCOME_COUNT] = { 0 };
+    double *latency = malloc(count * sizeof(double));
+    double *overshoot = malloc(count * sizeof(double));
+    double virtual_s = 0;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const RunResult_t *r = &results[i];
+        outcomes[r->outcome < RUN_OUTCOME_COUNT ? r->outcome : RUN_ERROR]++;
+        virtual_s += r->virtual_s;
+        if (r->outcome == RUN_OK) {
+            latency[n] = r->latency_ms;
+            overshoot[n] = r->overshoot_steps;
+            n++;
+        }
+    }
+
+    printf("%s: %u runs, ok %u, false trip %u (%.2f%%), missed %u (%.2f%%)",
+           label, count, outcomes[RUN_OK], outcomes[RUN_FALSE_TRIP],
+           100.0 * outcomes[RUN_FALSE_TRIP] / count, outcomes[RUN_MISSED],
+           100.0 * outcomes[RUN_MISSED] / count);
+    if (outcomes[RUN_ERROR]) printf(", error %u", outcomes[RUN_ERROR]);
+    printf("\n");
+    PrintStats("latency", "ms", latency, n);
+    PrintStats("overshoot", "steps", overshoot, n);
+    printf("  %.0f s simulated in %.2f s (%.0fx)\n", virtual_s, host_s,
+           host_s > 0 ? virtual_s / host_s : 0);
+
+    free(latency);
+    free(overshoot);
+}
+
+static void WriteCsv(FILE *csv, const char *label, const RunResult_t *results, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        const RunResult_t *r = &results[i];
+        fprintf(csv, "%s,%u,%s,%.4f,%.4f,%.3f,%d\n", label, r->index,
+                SimBatch_OutcomeName(r->outcome),
+                r->break_s, r->cut_s, r->latency_ms, r->overshoot_steps);
+    }
+}
+
+/* ---------------- 脚本 ---------------- */
+
+static double NowS(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int RunScript(FILE *script, int jobs, FILE *csv) {
+    Scenario_t sc;
+    char buf[256];
+    int line_no = 0;
+    int blocks = 0;
+
+    SimBatch_Defaults(&sc);
+
+    while (fgets(buf, sizeof(buf), script) != NULL) {
+        char *line = SimBatch_Trim(buf);
+        unsigned count;
+        int label_pos = 0;
+
+        line_no++;
+        if (*line == '\0' || *line == '#') continue;
+
+        if (sscanf(line, "run %u %n", &count, &label_pos) == 1) {
+            char label[64];
+            RunResult_t *results;
+            double start;
+
+            if (count == 0) continue;
+            snprintf(label, sizeof(label), "%s", label_pos > 0 && line[label_pos] ? line + label_pos : "");
+            if (label[0] == '\0') snprintf(label, sizeof(label), "run%d", blocks + 1);
+
+            results = calloc(count, sizeof(RunResult_t));
+            if (results == NULL) return -1;
+            start = NowS();
+            if (SimBatch_RunMany(&sc, count, jobs, results) != 0) {
+                perror("tm_sim");
+                free(results);
+                return -1;
+            }
+            Report(label, results, count, NowS() - start);
+            if (csv != NULL) WriteCsv(csv, label, results, count);
+            free(results);
+            blocks++;
+        } else if (SimBatch_ParseLine(&sc, line, line_no) != 0) {
+            return -1;
+        }
+    }
+
+    if (blocks == 0) {
+        fprintf(stderr, "tm_sim: script has no run line\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "usage: tm_sim [-j jobs] [-o runs.csv] <script|->\n");
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = cpus > 0 ? (int)cpus : 1;
+    const char *csv_path = NULL;
+    FILE *script;
+    FILE *csv = NULL;
+    int opt;
+    int ret;
+
+    while ((opt = getopt(argc, argv, "j:o:h")) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1) jobs = 1;
+            break;
+        case 'o':
+            csv_path = optarg;
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        Usage();
+        return 1;
+    }
+
+    script = strcmp(argv[optind], "-") == 0 ? stdin : fopen(argv[optind], "r");
+    if (script == NULL) {
+        fprintf(stderr, "tm_sim: %s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            fprintf(stderr, "tm_sim: %s: %s\n", csv_path, strerror(errno));
+            return 1;
+        }
+        fprintf(csv, "label,run,outcome,break_s,cut_s,latency_ms,overshoot_steps\n");
+    }
+
+    ret = RunScript(script, jobs, csv);
+    if (csv != NULL) fclose(csv);
+    if (script != stdin) fclose(script);
+    return ret == 0 ? 0 : 1;
+}
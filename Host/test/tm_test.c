@@ -0,0 +1,495 @@
+// tm_test: 在主机上运行App层的行为测试（模拟HAL），全部通过时返回0
+//
+// 用法: tm_test          （通常通过 make -C Host test 运行）
+//
+// 每个用例只依赖公开接口和 hal_mock 的控制接口，失败时打印文件行号和条件。
+
+#include "hal_mock.h"
+#include "ring_buffer.h"
+#include "cobs.h"
+#include "crc16.h"
+#include "param_registry.h"
+#include "command_parser.h"
+#include "stepper_motor.h"
+#include "system_state.h"
+#include "perf_monitor.h"
+#include "event_queue.h"
+#include "eeprom_emulation.h"
+#include "ina236.h"
+#include "sequence_controller.h"
+#include "homing.h"
+#include "round_monitor.h"
+#include "etch_control.h"
+#include "telemetry.h"
+#include "usbd_cdc_if.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned test_checks;
+static unsigned test_failures;
+
+#define CHECK(cond) do { \
+    test_checks++; \
+    if (!(cond)) { \
+        test_failures++; \
+        printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+#define TEST_EEPROM_PAGE      0x0801FC00UL  // 与 eeprom_emulation.c 相同
+#define TEST_EEPROM_PAGE_SIZE 1024
+
+// 按 main.c 的顺序初始化各模块
+static void Test_InitModules(void) {
+    PerfMonitor_Init();
+    EventQueue_Init();
+    EE_Init();
+    SystemState_Init();
+    StepperMotor_Init();
+    INA236_Init();
+    CommandParser_Init();
+    SequenceController_Init();
+    Homing_Init();
+    RoundMonitor_Init();
+    EtchControl_Init();
+    Telemetry_Init();
+}
+
+static void Test_InitFirmware(void) {
+    Mock_Init();
+    Test_InitModules();
+}
+
+// 重新上电：模拟HAL复位，EEPROM页内容保留
+static void Test_PowerCycle(void) {
+    static uint8_t page[TEST_EEPROM_PAGE_SIZE];
+
+    memcpy(page, (const void *)TEST_EEPROM_PAGE, sizeof(page));
+    Mock_Init();
+    memcpy((void *)TEST_EEPROM_PAGE, page, sizeof(page));
+    Test_InitModules();
+}
+
+// 执行一条命令并取出应答
+static const char *Test_Command(const char *cmd) {
+    static char reply[1024];
+    uint32_t len;
+
+    Mock_CdcRead((uint8_t *)reply, sizeof(reply));
+    CommandParser_Process(cmd);
+    len = Mock_CdcRead((uint8_t *)reply, sizeof(reply) - 1);
+    reply[len] = '\0';
+    return reply;
+}
+
+static int32_t Test_GetParam(const char *name) {
+    return ParamRegistry_GetValue(ParamRegistry_Find(name));
+}
+
+// ---- RingBuffer ----
+
+static void Test_RingBufferWrap(void) {
+    uint8_t storage[8];
+    uint8_t out[8];
+    uint8_t *peek;
+    RingBuffer_t rb;
+
+    RingBuffer_Init(&rb, storage, sizeof(storage));
+    CHECK(RingBuffer_Write(&rb, (const uint8_t *)"abcdef", 6) == 6);
+    CHECK(RingBuffer_Read(&rb, out, 5) == 5);
+
+    // 写指针越过缓冲区末尾，数据分两段存放
+    CHECK(RingBuffer_Write(&rb, (const uint8_t *)"ghijk", 5) == 5);
+    CHECK(RingBuffer_Count(&rb) == 6);
+    CHECK(RingBuffer_Peek(&rb, &peek) == 3);  // 只返回到末尾的连续部分
+    CHECK(memcmp(peek, "fgh", 3) == 0);
+    CHECK(RingBuffer_Read(&rb, out, sizeof(out)) == 6);
+    CHECK(memcmp(out, "fghijk", 6) == 0);
+    CHECK(RingBuffer_Count(&rb) == 0);
+
+    // 索引跨过16位回绕后计数仍正确
+    rb.head = rb.tail = 0xFFFE;
+    CHECK(RingBuffer_Write(&rb, (const uint8_t *)"1234", 4) == 4);
+    CHECK(RingBuffer_Count(&rb) == 4);
+    CHECK(RingBuffer_Read(&rb, out, 4) == 4);
+    CHECK(memcmp(out, "1234", 4) == 0);
+}
+
+static void Test_RingBufferFull(void) {
+    uint8_t storage[8];
+    uint8_t byte;
+    RingBuffer_t rb;
+
+    RingBuffer_Init(&rb, storage, sizeof(storage));
+    CHECK(RingBuffer_Write(&rb, (const uint8_t *)"0123456789", 10) == 8);
+    CHECK(RingBuffer_Free(&rb) == 0);
+    CHECK(RingBuffer_Write(&rb, (const uint8_t *)"x", 1) == 0);
+    CHECK(RingBuffer_Get(&rb, &byte) && byte == '0');
+
+    // 暂存写入：放不下时整段拒绝，提交前消费者不可见
+    CHECK(!RingBuffer_Stage(&rb, 0, (const uint8_t *)"ab", 2));
+    CHECK(RingBuffer_Stage(&rb, 0, (const uint8_t *)"a", 1));
+    CHECK(RingBuffer_Count(&rb) == 7);
+    CHECK(!RingBuffer_Stage(&rb, 1, (const uint8_t *)"b", 1));
+    RingBuffer_Commit(&rb, 1);
+    CHECK(RingBuffer_Count(&rb) == 8);
+
+    while (RingBuffer_Get(&rb, &byte)) {
+    }
+    CHECK(byte == 'a');
+    CHECK(RingBuffer_Free(&rb) == 8);
+}
+
+// ---- COBS ----
+
+static void Test_CobsRoundTrip(const uint8_t *data, size_t len) {
+    uint8_t encoded[COBS_MAX_ENCODED_SIZE(600)];
+    uint8_t decoded[600];
+    size_t encoded_len = Cobs_Encode(data, len, encoded);
+
+    CHECK(encoded_len <= COBS_MAX_ENCODED_SIZE(len));
+    CHECK(memchr(encoded, 0, encoded_len) == NULL);
+    CHECK(Cobs_Decode(encoded, encoded_len, decoded) == len);
+    CHECK(memcmp(decoded, data, len) == 0);
+}
+
+static void Test_Cobs(void) {
+    static const uint8_t zeros[] = { 0x00, 0x00 };
+    static const uint8_t mixed[] = { 0x11, 0x22, 0x00, 0x33 };
+    static const uint8_t mixed_encoded[] = { 0x03, 0x11, 0x22, 0x02, 0x33 };
+    uint8_t encoded[8];
+    uint8_t data[600];
+
+    Test_CobsRoundTrip(zeros, sizeof(zeros));
+    Test_CobsRoundTrip(mixed, sizeof(mixed));
+    CHECK(Cobs_Encode(mixed, sizeof(mixed), encoded) == sizeof(mixed_encoded));
+    CHECK(memcmp(encoded, mixed_encoded, sizeof(mixed_encoded)) == 0);
+
+    // 254/255个非零字节分别落在组长度上限两侧
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i % 255 + 1);
+    }
+    Test_CobsRoundTrip(data, 254);
+    Test_CobsRoundTrip(data, 255);
+    for (size_t i = 0; i < sizeof(data); i += 7) {
+        data[i] = 0;
+    }
+    Test_CobsRoundTrip(data, sizeof(data));
+
+    // 格式错误：组长度越界、数据中含0x00
+    CHECK(Cobs_Decode((const uint8_t *)"\x05\x11\x22", 3, data) == 0);
+    CHECK(Cobs_Decode((const uint8_t *)"\x03\x11\x00", 3, data) == 0);
+}
+
+// ---- CRC16 ----
+
+static void Test_Crc16(void) {
+    uint16_t crc;
+
+    // CRC-16/CCITT-FALSE 标准校验值
+    CHECK(Crc16_Update(CRC16_INIT, (const uint8_t *)"123456789", 9) == 0x29B1);
+    CHECK(Crc16_Update(CRC16_INIT, NULL, 0) == 0xFFFF);
+    CHECK(Crc16_Update(CRC16_INIT, (const uint8_t *)"A", 1) == 0xB915);
+
+    // 分段计算与一次计算结果相同
+    crc = Crc16_Update(CRC16_INIT, (const uint8_t *)"1234", 4);
+    crc = Crc16_Update(crc, (const uint8_t *)"56789", 5);
+    CHECK(crc == 0x29B1);
+}
+
+// ---- 批量SET ----
+
+static void Test_BatchRollback(void) {
+    const char *reply;
+    int32_t freq;
+    int32_t thres;
+
+    Test_InitFirmware();
+    freq = Test_GetParam("FREQ");
+    thres = Test_GetParam("THRES");
+
+    // 第二条超出范围：整批拒绝，第一条也不写入
+    reply = Test_Command("SET THRES 123;SET WINDOW 9");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    CHECK(strstr(reply, "\"Index\": 1") != NULL);
+    CHECK(Test_GetParam("THRES") == thres);
+    CHECK(Test_GetParam("WINDOW") == BUFFER_SIZE);
+
+    // 未知参数和非SET命令同样整批拒绝
+    reply = Test_Command("SET FREQ 12.5;SET NOPE 1");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    CHECK(Test_GetParam("FREQ") == freq);
+    reply = Test_Command("SET FREQ 12.5;MOVE CW 10");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    CHECK(Test_GetParam("FREQ") == freq);
+    CHECK(!StepperMotor_IsMoving());
+
+    reply = Test_Command("SET FREQ 12.5;SET THRES 123;SET WINDOW 3");
+    CHECK(strstr(reply, "\"Status\": \"Success\"") != NULL);
+    CHECK(strstr(reply, "\"Count\": 3") != NULL);
+    CHECK(Test_GetParam("FREQ") == 12500);
+    CHECK(Test_GetParam("THRES") == 123);
+    CHECK(Test_GetParam("WINDOW") == 3);
+}
+
+// ---- EEPROM ----
+
+static uint32_t Test_ReadSlot(uint16_t virt_address) {
+    uint32_t data;
+
+    return EE_ReadVariable(virt_address, &data) == 0 ? data : 0xFFFFFFFF;
+}
+
+// 只改一个参数后再次SAVE：页擦除后其余参数必须随之重新写入
+static void Test_SaveKeepsSlots(void) {
+    const char *reply;
+
+    Test_InitFirmware();
+    Test_Command("SET FREQ 12.5");
+    Test_Command("SET LEVEL 2");
+    Test_Command("SET THRES 300");
+    reply = Test_Command("SAVE");
+    CHECK(strstr(reply, "\"Status\": \"Success\"") != NULL);
+    CHECK(Test_ReadSlot(EE_ADDR_FREQ_MHZ) == 12500);
+    CHECK(Test_ReadSlot(EE_ADDR_DEBUG_LEVEL) == 2);
+    CHECK(Test_ReadSlot(EE_ADDR_THRES) == 300);
+
+    Test_Command("SET THRES 77");
+    Test_Command("SAVE");
+    CHECK(Test_ReadSlot(EE_ADDR_FREQ_MHZ) == 12500);
+    CHECK(Test_ReadSlot(EE_ADDR_DEBUG_LEVEL) == 2);
+    CHECK(Test_ReadSlot(EE_ADDR_THRES) == 77);
+
+    // 未改变时不再写Flash
+    uint32_t writes = Mock_FlashWrites();
+    Test_Command("SAVE");
+    CHECK(Mock_FlashWrites() == writes);
+}
+
+// 上电时加载保存的参数；旧版只有整数Hz的FREQ时换算为mHz，之后保存到新地址
+static void Test_LoadAndMigrate(void) {
+    Test_InitFirmware();
+    Test_Command("SET FREQ 12.5");
+    Test_Command("SET THRES 300");
+    Test_Command("SET LEVEL 2");
+    Test_Command("SAVE");
+    Test_PowerCycle();
+    CHECK(Test_GetParam("FREQ") == 12500);
+    CHECK(Test_GetParam("THRES") == 300);
+    CHECK(Test_GetParam("LEVEL") == 2);
+
+    Test_InitFirmware();
+    CHECK(EE_WriteVariable(EE_ADDR_FREQ_HZ, 40) == 0);
+    CHECK(EE_WriteVariable(EE_ADDR_THRES, 120) == 0);
+    Test_PowerCycle();
+    CHECK(Test_GetParam("FREQ") == 40000);
+    CHECK(Test_GetParam("THRES") == 120);
+
+    Test_Command("SET THRES 80");
+    Test_Command("SAVE");
+    CHECK(Test_ReadSlot(EE_ADDR_FREQ_MHZ) == 40000);
+    Test_PowerCycle();
+    CHECK(Test_GetParam("FREQ") == 40000);
+    CHECK(Test_GetParam("THRES") == 80);
+
+    // 超出范围的保存值不加载
+    Test_InitFirmware();
+    CHECK(EE_WriteVariable(EE_ADDR_DEBUG_LEVEL, 9) == 0);
+    Test_PowerCycle();
+    CHECK(Test_GetParam("LEVEL") == 0);
+}
+
+// ---- 手动运动 ----
+
+// 回零或序列运行中，MOVE/SPEED 会打乱其运动状态，必须拒绝
+static void Test_MotionGuard(void) {
+    const char *reply;
+
+    Test_InitFirmware();
+    reply = Test_Command("HOME CW");
+    CHECK(strstr(reply, "\"Status\": \"Success\"") != NULL);
+    CHECK(Homing_IsRunning());
+    reply = Test_Command("MOVE CCW 100");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    reply = Test_Command("SPEED 10");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    CHECK(StepperMotor_GetRate() == HOME_FAST_RATE_MHZ);
+    CHECK(Homing_IsRunning());
+
+    Test_InitFirmware();
+    Test_Command("START");
+    CHECK(SequenceController_IsRunning());
+    reply = Test_Command("MOVE CW 100");
+    CHECK(strstr(reply, "\"Status\": \"Error\"") != NULL);
+    CHECK(SequenceController_IsRunning());
+
+    Test_InitFirmware();
+    reply = Test_Command("MOVE CW 100");
+    CHECK(strstr(reply, "\"Status\": \"Success\"") != NULL);
+    reply = Test_Command("SPEED 10");
+    CHECK(strstr(reply, "\"Status\": \"Success\"") != NULL);
+}
+
+// ---- 发送队列 ----
+
+// 主机停止读取：队列满时命令先暂停；超过 MOCK_CDC_TX_TIMEOUT_MS 仍无发送完成后，
+// 命令照常执行、应答丢弃；主机重新读取后恢复正常应答
+static void Test_TxStalledHost(void) {
+    static const uint8_t filler[64] = { 0 };
+    static const char cmd[] = "SET WINDOW 3\n";
+    char reply[256];
+    uint32_t queued;
+    uint32_t len;
+
+    Test_InitFirmware();
+    while (CDC_TxReady_FS(sizeof(filler)) && Mock_CdcTxQueued() + sizeof(filler) <= APP_TX_DATA_SIZE) {
+        CDC_Write_FS(filler, sizeof(filler));
+    }
+    CHECK(!CDC_TxReady_FS(CMD_TX_RESERVE));
+    queued = Mock_CdcTxQueued();
+
+    Mock_CdcReceive((const uint8_t *)cmd, sizeof(cmd) - 1);
+    CommandParser_Poll();
+    CHECK(Test_GetParam("WINDOW") == BUFFER_SIZE);
+
+    Mock_AdvanceUs(MOCK_CDC_TX_TIMEOUT_MS * 1000 - 1000);
+    CommandParser_Poll();
+    CHECK(Test_GetParam("WINDOW") == BUFFER_SIZE);
+
+    Mock_AdvanceUs(1000);
+    CommandParser_Poll();
+    CHECK(Test_GetParam("WINDOW") == 3);
+    CHECK(Mock_CdcTxQueued() == queued);  // 应答被丢弃
+
+    // 主机读取后不再视为停止，应答正常发出
+    while (Mock_CdcRead((uint8_t *)reply, sizeof(reply)) > 0) {
+    }
+    CommandParser_Process("GET WINDOW");
+    len = Mock_CdcRead((uint8_t *)reply, sizeof(reply) - 1);
+    reply[len] = '\0';
+    CHECK(strstr(reply, "\"Value\": 3") != NULL);
+}
+
+// ---- 步进定时 ----
+
+// 在电机停止时设置速率，再驱动N个更新中断，检查PSC/ARR范围和小数抖动后的平均周期
+static void Test_StepTiming(uint32_t rate_mhz, uint32_t expected_mhz) {
+    const uint32_t periods = 1000;
+    uint64_t counts = 0;
+    uint32_t psc;
+
+    CHECK(StepperMotor_SetRate(rate_mhz) == expected_mhz);
+    psc = TIM1->PSC;
+    CHECK(TIM1->ARR >= 1 && TIM1->ARR <= 65534);  // 留一个计数给小数抖动
+
+    TIM1->DIER |= TIM_IT_UPDATE;
+    for (uint32_t n = 0; n < periods; n++) {
+        TIM1->SR |= TIM_FLAG_UPDATE;
+        StepperMotor_TIM1_Update_IRQHandler();
+        CHECK(TIM1->PSC == psc);
+        counts += TIM1->ARR + 1;
+    }
+    TIM1->DIER &= ~TIM_IT_UPDATE;
+
+    // periods 个周期的总时长与理想值相差不超过一个计数
+    uint64_t actual = counts * (psc + 1) * expected_mhz;
+    uint64_t ideal = (uint64_t)MOCK_CORE_CLOCK_HZ * 1000 * periods;
+    uint64_t error = actual > ideal ? actual - ideal : ideal - actual;
+    CHECK(error <= (uint64_t)(psc + 1) * expected_mhz);
+}
+
+static void Test_StepperTiming(void) {
+    Test_InitFirmware();
+
+    Test_StepTiming(STEPPER_RATE_MIN_MHZ, STEPPER_RATE_MIN_MHZ);
+    CHECK(TIM1->PSC >= 50000);  // 最低速率需要接近最大的预分频
+    Test_StepTiming(STEPPER_RATE_MAX_MHZ, STEPPER_RATE_MAX_MHZ);
+    CHECK(TIM1->PSC == 0 && TIM1->ARR == MOCK_CORE_CLOCK_HZ / 50000 - 1);
+    Test_StepTiming(1000, 1000);        // 1Hz，需要小数周期
+    Test_StepTiming(33333, 33333);      // 不能整除的速率
+    Test_StepTiming(1098632, 1098632);  // 预分频由1变为2附近
+
+    // 超出范围时限幅
+    Test_StepTiming(0, STEPPER_RATE_MIN_MHZ);
+    Test_StepTiming(STEPPER_RATE_MAX_MHZ + 1, STEPPER_RATE_MAX_MHZ);
+}
+
+// ---- 断线检测 ----
+
+static void Test_Samples(const uint16_t *samples, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        SystemState_UpdateCurrent(samples[i]);
+    }
+}
+
+static void Test_BreakDetector(void) {
+    static const uint16_t high[BUFFER_SIZE] = { 500, 500, 500, 500, 500, 500, 500, 500 };
+    static const uint16_t low[BUFFER_SIZE] = { 10, 10, 10, 10, 10, 10, 10, 10 };
+    static const uint16_t at_threshold[1] = { 100 };
+
+    Test_InitFirmware();
+    g_system_state.threshold = 100;
+    g_system_state.window = BUFFER_SIZE;
+
+    Test_Samples(high, BUFFER_SIZE);
+    CHECK(!SystemState_CurrentBelowThreshold());
+
+    // 低于阈值的采样不满一个窗口时不判断为断线
+    Test_Samples(low, BUFFER_SIZE - 1);
+    CHECK(!SystemState_CurrentBelowThreshold());
+    Test_Samples(low, 1);
+    CHECK(SystemState_CurrentBelowThreshold());
+
+    // 等于阈值不算低于，任一采样回升即复位
+    Test_Samples(at_threshold, 1);
+    CHECK(!SystemState_CurrentBelowThreshold());
+
+    // 缩短窗口：只看最近 window 个采样，跨过缓冲区回绕处
+    g_system_state.window = 3;
+    Test_Samples(low, 2);
+    CHECK(!SystemState_CurrentBelowThreshold());
+    Test_Samples(low, 1);
+    CHECK(SystemState_CurrentBelowThreshold());
+    g_system_state.window = BUFFER_SIZE;
+    CHECK(!SystemState_CurrentBelowThreshold());
+
+    g_system_state.window = 1;
+    Test_Samples(high, 1);
+    CHECK(!SystemState_CurrentBelowThreshold());
+    Test_Samples(low, 1);
+    CHECK(SystemState_CurrentBelowThreshold());
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} TestCase_t;
+
+static const TestCase_t tests[] = {
+    { "ring_buffer_wrap", Test_RingBufferWrap },
+    { "ring_buffer_full", Test_RingBufferFull },
+    { "cobs", Test_Cobs },
+    { "crc16", Test_Crc16 },
+    { "batch_rollback", Test_BatchRollback },
+    { "save_keeps_slots", Test_SaveKeepsSlots },
+    { "load_and_migrate", Test_LoadAndMigrate },
+    { "motion_guard", Test_MotionGuard },
+    { "tx_stalled_host", Test_TxStalledHost },
+    { "stepper_timing", Test_StepperTiming },
+    { "break_detector", Test_BreakDetector },
+};
+
+int main(void) {
+    unsigned failed_tests = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        unsigned failures = test_failures;
+
+        tests[i].run();
+        printf("%-20s %s\n", tests[i].name, test_failures == failures ? "ok" : "FAILED");
+        if (test_failures != failures) failed_tests++;
+    }
+    printf("%u checks, %u failed in %u test(s)\n", test_checks, test_failures, failed_tests);
+    return test_failures == 0 ? 0 : 1;
+}
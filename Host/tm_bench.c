@@ -0,0 +1,179 @@
+// tm_bench: 比较ASCII/JSON命令与二进制(COBS+CRC16)命令的往返延迟和字节数
+//
+// 用法: tm_bench <串口设备> [次数]
+//   例: ./tm_bench /dev/ttyACM0 1000
+
+#include "binary_protocol.h"
+#include "param_registry.h"
+#include "cobs.h"
+#include "crc16.h"
+#include "serial_port.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    double *rtt_us;
+    int count;
+    unsigned long tx_bytes;
+    unsigned long rx_bytes;
+    int errors;
+} BenchResult_t;
+
+// 读取一个二进制应答帧并解码，返回线上字节数（含分隔符）
+static int ReadFrame(uint8_t *message, size_t *message_len) {
+    uint8_t frame[BIN_MAX_FRAME + 1];
+    size_t len = 0;
+    int wire = 0;
+    uint8_t byte;
+
+    // 跳过帧前的ASCII输出和分隔符
+    do {
+        if (Serial_ReadByte(&byte) != 0) return -1;
+        wire++;
+    } while (byte != 0x00);
+    for (;;) {
+        if (Serial_ReadByte(&byte) != 0) return -1;
+        wire++;
+        if (byte == 0x00) {
+            if (len == 0) continue;
+            break;
+        }
+        if (len < sizeof(frame)) frame[len++] = byte;
+    }
+    *message_len = Cobs_Decode(frame, len, message);
+    if (*message_len < sizeof(BinResponseHeader_t) + 2) return -1;
+    if (Crc16_Update(CRC16_INIT, message, *message_len - 2) !=
+        (uint16_t)(message[*message_len - 2] | (message[*message_len - 1] << 8))) {
+        return -1;
+    }
+    return wire;
+}
+
+static size_t BuildFrame(uint8_t opcode, uint8_t seq, const void *body, size_t body_len, uint8_t *out) {
+    uint8_t message[BIN_MAX_MESSAGE];
+    BinHeader_t header = { opcode, seq };
+    size_t len = 0;
+    uint16_t crc;
+
+    memcpy(message, &header, sizeof(header));
+    len += sizeof(header);
+    if (body_len > 0) {
+        memcpy(message + len, body, body_len);
+        len += body_len;
+    }
+    crc = Crc16_Update(CRC16_INIT, message, len);
+    message[len++] = (uint8_t)crc;
+    message[len++] = (uint8_t)(crc >> 8);
+
+    out[0] = 0x00;
+    len = 1 + Cobs_Encode(message, len, out + 1);
+    out[len++] = 0x00;
+    return len;
+}
+
+static void RunAscii(BenchResult_t *result, const char *cmd, int iterations) {
+    char line[512];
+    size_t cmd_len = strlen(cmd);
+
+    for (int i = 0; i < iterations; i++) {
+        double start = Serial_NowUs();
+        if (Serial_WriteAll((const uint8_t *)cmd, cmd_len) != 0) break;
+        int n = Serial_ReadLine(line, sizeof(line));
+        if (n < 0 || strstr(line, "\"Success\"") == NULL) {
+            result->errors++;
+            continue;
+        }
+        result->rtt_us[result->count++] = Serial_NowUs() - start;
+        result->tx_bytes += cmd_len;
+        result->rx_bytes += (unsigned long)n;
+    }
+}
+
+static void RunBinary(BenchResult_t *result, uint8_t opcode, const void *body, size_t body_len,
+                      int iterations) {
+    uint8_t frame[BIN_MAX_FRAME + 2];
+    uint8_t message[BIN_MAX_FRAME];
+    size_t message_len;
+
+    for (int i = 0; i < iterations; i++) {
+        uint8_t seq = (uint8_t)i;
+        size_t frame_len = BuildFrame(opcode, seq, body, body_len, frame);
+        double start = Serial_NowUs();
+        if (Serial_WriteAll(frame, frame_len) != 0) break;
+        int n = ReadFrame(message, &message_len);
+        BinResponseHeader_t header;
+        if (n < 0) {
+            result->errors++;
+            continue;
+        }
+        memcpy(&header, message, sizeof(header));
+        if (header.opcode != (opcode | BIN_RESPONSE_FLAG) || header.seq != seq || header.status != BIN_OK) {
+            result->errors++;
+            continue;
+        }
+        result->rtt_us[result->count++] = Serial_NowUs() - start;
+        result->tx_bytes += frame_len;
+        result->rx_bytes += (unsigned long)n;
+    }
+}
+
+static int CompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void Report(BenchResult_t *result) {
+    if (result->count == 0) {
+        printf("%-16s no successful exchanges (%d errors)\n", result->name, result->errors);
+        return;
+    }
+    qsort(result->rtt_us, result->count, sizeof(double), CompareDouble);
+    printf("%-16s n=%-5d min=%7.1f p50=%7.1f p99=%7.1f max=%7.1f us  tx=%5.1f rx=%5.1f B/cmd  err=%d\n",
+           result->name, result->count,
+           result->rtt_us[0], result->rtt_us[result->count / 2],
+           result->rtt_us[(result->count * 99) / 100], result->rtt_us[result->count - 1],
+           (double)result->tx_bytes / result->count, (double)result->rx_bytes / result->count,
+           result->errors);
+}
+
+int main(int argc, char **argv) {
+    int iterations = 1000;
+    BinGetRequest_t get_freq = { PARAM_ID_FREQ };
+    BinSetRequest_t set_thres = { PARAM_ID_THRES, 50 };
+    BenchResult_t results[6] = {
+        { .name = "ascii GET FREQ" }, { .name = "bin GET FREQ" },
+        { .name = "ascii SET THRES" }, { .name = "bin SET THRES" },
+        { .name = "ascii STATUS" }, { .name = "bin STATUS" },
+    };
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <serial device> [iterations]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) iterations = atoi(argv[2]);
+    if (iterations <= 0) iterations = 1;
+
+    if (Serial_Open(argv[1]) < 0) return 1;
+
+    for (int i = 0; i < 6; i++) {
+        results[i].rtt_us = calloc((size_t)iterations, sizeof(double));
+    }
+
+    RunAscii(&results[0], "GET FREQ\r\n", iterations);
+    RunBinary(&results[1], BIN_OP_GET, &get_freq, sizeof(get_freq), iterations);
+    RunAscii(&results[2], "SET THRES 50\r\n", iterations);
+    RunBinary(&results[3], BIN_OP_SET, &set_thres, sizeof(set_thres), iterations);
+    RunAscii(&results[4], "STATUS\r\n", iterations);
+    RunBinary(&results[5], BIN_OP_STATUS, NULL, 0, iterations);
+
+    for (int i = 0; i < 6; i++) {
+        Report(&results[i]);
+        free(results[i].rtt_us);
+    }
+    Serial_Close();
+    return 0;
+}
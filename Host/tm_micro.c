@@ -0,0 +1,196 @@
+// tm_micro: 在主机上运行固件热点路径微基准（App/Src/bench.c），结果单位为纳秒
+//
+// 用法: tm_micro [-b 每次采样调用次数] [-o 结果.json]
+//       tm_micro -c 基线.json 新结果.json [-t 允许增幅%]
+//   例: ./tm_micro -o base.json  修改代码后  ./tm_micro -o new.json && ./tm_micro -c base.json new.json
+//
+// 每项结果一行JSON，格式与设备上 BENCH 命令的输出相同（设备上单位为DWT周期）。
+// 主机上有副作用的项（运动、SAVE、Flash擦写）也会运行，固件运行在模拟HAL上。
+// 比较模式按中位数比较，任一项增幅超过 -t（默认10%）时返回2，可用于回归检查。
+
+#define _GNU_SOURCE
+#include "sim_core.h"
+#include "hal_mock.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MICRO_MAX_RESULTS 64
+
+typedef struct {
+    char key[96];       // "<group>/<name>"
+    uint32_t median;
+} MicroResult_t;
+
+static FILE *output;
+
+static uint32_t Micro_ClockNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+// 结果写入模拟的发送队列后立即取出，每次都在空队列上格式化
+static void Micro_Report(const BenchResult_t *result) {
+    uint8_t buf[256];
+    uint32_t len;
+
+    Bench_WriteResult(result, "ns");
+    while ((len = Mock_CdcRead(buf, sizeof(buf))) > 0) {
+        fwrite(buf, 1, len, output);
+    }
+}
+
+// 从JSON行中取出 "key": "<字符串>"
+static int JsonString(const char *line, const char *key, char *value, size_t size) {
+    char pattern[32];
+    const char *p;
+    const char *end;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    p = strstr(line, pattern);
+    if (p == NULL) return -1;
+    p += strlen(pattern);
+    end = strchr(p, '"');
+    if (end == NULL || (size_t)(end - p) >= size) return -1;
+    memcpy(value, p, (size_t)(end - p));
+    value[end - p] = '\0';
+    return 0;
+}
+
+static int Micro_Load(const char *path, MicroResult_t *results, int *count) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+    char group[32];
+    char name[64];
+    const char *median;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    *count = 0;
+    while (fgets(line, sizeof(line), f) != NULL && *count < MICRO_MAX_RESULTS) {
+        median = strstr(line, "\"Median\": ");
+        if (median == NULL ||
+            JsonString(line, "Bench", group, sizeof(group)) != 0 ||
+            JsonString(line, "Name", name, sizeof(name)) != 0) {
+            continue;  // 跳过的项
+        }
+        snprintf(results[*count].key, sizeof(results[*count].key), "%s/%s", group, name);
+        results[*count].median = (uint32_t)strtoul(median + strlen("\"Median\": "), NULL, 10);
+        (*count)++;
+    }
+    fclose(f);
+    return 0;
+}
+
+static int Micro_Compare(const char *base_path, const char *new_path, double limit_pct) {
+    static MicroResult_t base[MICRO_MAX_RESULTS];
+    static MicroResult_t current[MICRO_MAX_RESULTS];
+    int base_count, current_count;
+    int regressions = 0;
+
+    if (Micro_Load(base_path, base, &base_count) != 0 ||
+        Micro_Load(new_path, current, &current_count) != 0) {
+        return 1;
+    }
+
+    printf("%-40s %10s %10s %8s\n", "benchmark", "base", "new", "change");
+    for (int i = 0; i < current_count; i++) {
+        const MicroResult_t *old = NULL;
+        double change;
+
+        for (int j = 0; j < base_count; j++) {
+            if (strcmp(base[j].key, current[i].key) == 0) {
+                old = &base[j];
+                break;
+            }
+        }
+        if (old == NULL) {
+            printf("%-40s %10s %10u %8s\n", current[i].key, "-", current[i].median, "new");
+            continue;
+        }
+        // 基线为0时按1计算，避免除零
+        change = 100.0 * ((double)current[i].median - old->median) / (old->median ? old->median : 1);
+        printf("%-40s %10u %10u %+7.1f%%%s\n", current[i].key, old->median, current[i].median,
+               change, change > limit_pct ? "  REGRESSION" : "");
+        if (change > limit_pct) regressions++;
+    }
+
+    if (regressions > 0) {
+        printf("%d regression(s) over %.1f%%\n", regressions, limit_pct);
+        return 2;
+    }
+    return 0;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "usage: tm_micro [-b batch] [-o results.json]\n"
+                    "       tm_micro -c base.json new.json [-t limit_pct]\n");
+}
+
+int main(int argc, char *argv[]) {
+    EtchParams_t model;
+    const char *out_path = NULL;
+    bool compare = false;
+    double limit_pct = 10.0;
+    uint16_t batch = 1000;
+    BenchResult_t result;
+    uint8_t skipped = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:ct:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            batch = (uint16_t)atoi(optarg);
+            if (batch < 1) batch = 1;
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        case 'c':
+            compare = true;
+            break;
+        case 't':
+            limit_pct = atof(optarg);
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+
+    if (compare) {
+        if (argc - optind != 2) {
+            Usage();
+            return 1;
+        }
+        return Micro_Compare(argv[optind], argv[optind + 1], limit_pct);
+    }
+
+    output = stdout;
+    if (out_path != NULL) {
+        output = fopen(out_path, "w");
+        if (output == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    EtchModel_Defaults(&model);
+    SimCore_Init(&model, 1);
+    Bench_Begin(Micro_ClockNs, batch, true);
+    while (Bench_Next(&result)) {
+        if (result.skipped) skipped++;
+        Micro_Report(&result);
+    }
+
+    if (output != stdout) fclose(output);
+    return skipped == 0 ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+// tm_ping: 用 PING 命令测量USB CDC往返延迟，并用设备时间戳区分固件处理时间和传输时间
+//
+// 用法: tm_ping [-n 次数] [-o 样本.csv] [-l p99上限us] <串口设备>
+//   例: ./tm_ping -n 5000 -o ping.csv /dev/ttyACM0
+//
+// 往返   = 主机发出命令到读到应答
+// 固件   = 设备上命令最后一个字节到达到应答写入发送队列 (Tx - Rx)
+// 传输   = 往返 - 固件（USB轮询、主机驱动和主循环等待）
+// 指定 -l 时，往返p99超过上限则返回2，可用于回归检查。
+
+#include "serial_port.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HIST_BAR_WIDTH 50
+
+// 直方图区间上限（us），按1-2-5分档
+static const double hist_edges[] = {
+    10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+#define HIST_BINS (sizeof(hist_edges) / sizeof(hist_edges[0]) + 1)
+
+typedef struct {
+    const char *name;
+    double *us;
+    int count;
+} Series_t;
+
+// 从JSON应答中取出 "key": <无符号整数>
+static int JsonUint(const char *line, const char *key, uint32_t *value) {
+    char pattern[32];
+    const char *p;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    p = strstr(line, pattern);
+    if (p == NULL) return -1;
+    *value = (uint32_t)strtoul(p + strlen(pattern), NULL, 10);
+    return 0;
+}
+
+// 发送一次PING并等待对应的应答，跳过期间的遥测和事件输出
+static int Ping(uint32_t nonce, double *rtt_us, double *device_us) {
+    char cmd[32];
+    char line[512];
+    uint32_t reply_nonce, mhz, rx, tx;
+    int len = snprintf(cmd, sizeof(cmd), "PING %u\r\n", nonce);
+    double start = Serial_NowUs();
+
+    if (Serial_WriteAll((const uint8_t *)cmd, (size_t)len) != 0) return -1;
+
+    for (;;) {
+        if (Serial_ReadLine(line, sizeof(line)) < 0) return -1;
+        if (strstr(line, "\"Cmd\": \"PING\"") == NULL) continue;
+        if (JsonUint(line, "Nonce", &reply_nonce) != 0 || reply_nonce != nonce) continue;
+        break;
+    }
+    *rtt_us = Serial_NowUs() - start;
+
+    if (JsonUint(line, "Mhz", &mhz) != 0 || mhz == 0 ||
+        JsonUint(line, "Rx", &rx) != 0 || JsonUint(line, "Tx", &tx) != 0) {
+        return -1;
+    }
+    // DWT周期计数器为32位，相减自动处理回绕
+    *device_us = (double)(uint32_t)(tx - rx) / mhz;
+    return 0;
+}
+
+static int CompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double Percentile(const Series_t *series, int pct) {
+    long index = ((long)series->count * pct) / 100;
+    return series->us[index < series->count ? index : series->count - 1];
+}
+
+// 输出统计值和直方图，调用前样本须已排序
+static void Report(const Series_t *series) {
+    unsigned long bins[HIST_BINS] = { 0 };
+    unsigned long peak = 0;
+    double sum = 0;
+
+    printf("\n%s (n=%d)\n", series->name, series->count);
+    if (series->count == 0) return;
+
+    for (int i = 0; i < series->count; i++) {
+        size_t bin = 0;
+        while (bin < HIST_BINS - 1 && series->us[i] >= hist_edges[bin]) bin++;
+        bins[bin]++;
+        sum += series->us[i];
+    }
+    printf("  min=%.1f p50=%.1f p90=%.1f p99=%.1f max=%.1f mean=%.1f us\n",
+           series->us[0], Percentile(series, 50), Percentile(series, 90),
+           Percentile(series, 99), series->us[series->count - 1], sum / series->count);
+
+    for (size_t bin = 0; bin < HIST_BINS; bin++) {
+        if (bins[bin] > peak) peak = bins[bin];
+    }
+    for (size_t bin = 0; bin < HIST_BINS; bin++) {
+        char label[32];
+        int width;
+
+        if (bins[bin] == 0) continue;
+        if (bin == 0) {
+            snprintf(label, sizeof(label), "< %g", hist_edges[0]);
+        } else if (bin == HIST_BINS - 1) {
+            snprintf(label, sizeof(label), ">= %g", hist_edges[bin - 1]);
+        } else {
+            snprintf(label, sizeof(label), "%g - %g", hist_edges[bin - 1], hist_edges[bin]);
+        }
+        width = (int)((bins[bin] * HIST_BAR_WIDTH + peak - 1) / peak);
+        printf("  %16s us %7lu %.*s\n", label, bins[bin], width,
+               "##################################################");
+    }
+}
+
+int main(int argc, char **argv) {
+    int iterations = 1000;
+    const char *csv_path = NULL;
+    double p99_limit_us = 0;
+    Series_t rtt = { .name = "round trip" };
+    Series_t device = { .name = "firmware (Rx -> Tx)" };
+    Series_t transport = { .name = "transport (round trip - firmware)" };
+    FILE *csv = NULL;
+    int lost = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:l:")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg); break;
+            case 'o': csv_path = optarg; break;
+            case 'l': p99_limit_us = atof(optarg); break;
+            default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-n count] [-o samples.csv] [-l p99_limit_us] <serial device>\n",
+                argv[0]);
+        return 1;
+    }
+    if (iterations <= 0) iterations = 1;
+
+    if (Serial_Open(argv[optind]) < 0) return 1;
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            perror(csv_path);
+            Serial_Close();
+            return 1;
+        }
+        fprintf(csv, "nonce,rtt_us,firmware_us\n");
+    }
+
+    rtt.us = calloc((size_t)iterations, sizeof(double));
+    device.us = calloc((size_t)iterations, sizeof(double));
+    transport.us = calloc((size_t)iterations, sizeof(double));
+
+    for (int i = 0; i < iterations; i++) {
+        double rtt_us, device_us;
+
+        if (Ping((uint32_t)i, &rtt_us, &device_us) != 0) {
+            lost++;
+            continue;
+        }
+        rtt.us[rtt.count++] = rtt_us;
+        device.us[device.count++] = device_us;
+        transport.us[transport.count++] = rtt_us - device_us;
+        if (csv != NULL) fprintf(csv, "%d,%.1f,%.2f\n", i, rtt_us, device_us);
+    }
+
+    qsort(rtt.us, rtt.count, sizeof(double), CompareDouble);
+    qsort(device.us, device.count, sizeof(double), CompareDouble);
+    qsort(transport.us, transport.count, sizeof(double), CompareDouble);
+
+    printf("%d pings, %d lost\n", iterations, lost);
+    Report(&rtt);
+    Report(&device);
+    Report(&transport);
+
+    int status = 0;
+    if (rtt.count == 0) {
+        status = 2;
+    } else if (p99_limit_us > 0 && Percentile(&rtt, 99) > p99_limit_us) {
+        printf("\nFAIL: round trip p99 %.1f us > limit %.1f us\n", Percentile(&rtt, 99), p99_limit_us);
+        status = 2;
+    }
+
+    if (csv != NULL) fclose(csv);
+    free(rtt.us);
+    free(device.us);
+    free(transport.us);
+    Serial_Close();
+    return status;
+}
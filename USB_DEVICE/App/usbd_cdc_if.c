@@ -22,7 +22,8 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+#include "command_parser.h"
+#include "ring_buffer.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -62,6 +63,8 @@
   */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+// 发送队列持续满且无发送完成超过该时间（ms）即认为主机未读取
+#define CDC_TX_TIMEOUT_MS  10
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -94,6 +97,16 @@ uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
+// 发送环形队列（以 UserTxBufferFS 为存储）：主循环写入，发送完成中断取走
+static RingBuffer_t tx_ring = { UserTxBufferFS, APP_TX_DATA_SIZE - 1, 0, 0 };
+static volatile uint16_t tx_inflight = 0;  // 正在传输、尚未释放的字节数
+static volatile bool tx_stalled = false;   // 主机长时间未读取，消息直接丢弃
+static volatile bool tx_full = false;      // 自上次发送完成后出现过队列满
+static uint32_t tx_full_tick = 0;         // 首次队列满的时刻
+static uint16_t tx_staged = 0;            // 当前消息已暂存、尚未发布的字节数
+static bool tx_message_dropped = false;
+static uint16_t tx_high_water = 0;
+static uint32_t tx_overflow = 0;
 
 /* USER CODE END PRIVATE_VARIABLES */
 
@@ -125,10 +138,12 @@ static int8_t CDC_Init_FS(void);
 static int8_t CDC_DeInit_FS(void);
 static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t CDC_Receive_FS(uint8_t* pbuf, uint32_t *Len);
+static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
-// 声明外部接收回调函数
-extern void CommandParser_USBReceiveCallback(uint8_t *buf, uint32_t len);
+static void CDC_TxKick_FS(void);
+static void CDC_TxFull_FS(void);
+
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
 
 /**
@@ -140,7 +155,8 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_FS =
   CDC_Init_FS,
   CDC_DeInit_FS,
   CDC_Control_FS,
-  CDC_Receive_FS
+  CDC_Receive_FS,
+  CDC_TransmitCplt_FS
 };
 
 /* Private functions ---------------------------------------------------------*/
@@ -154,6 +170,10 @@ static int8_t CDC_Init_FS(void)
   /* Set Application Buffers */
   USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+
+  // 重新枚举后，未确认完成的数据从队列中重新发送
+  tx_inflight = 0;
+  CDC_TxKick_FS();
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -260,11 +280,12 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
-  // 调用命令解析器
-  CommandParser_USBReceiveCallback(Buf, *Len);
-
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  // 数据拷贝到命令接收缓冲区，解析在主循环中进行
+  // 缓冲区将满时不重新使能端点，由 CDC_ResumeReceive_FS() 恢复
+  if (CommandParser_USBReceiveCallback(Buf, *Len)) {
+    USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -295,6 +316,206 @@ uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+  * @brief  CDC_TransmitCplt_FS
+  *         Called from the USB interrupt once a transfer (including any
+  *         terminating ZLP) has completed. Releases the sent bytes and
+  *         starts the next transfer from the TX queue.
+  * @param  Buf: Buffer of data that was transmitted
+  * @param  Len: Number of data transmitted (in bytes)
+  * @param  epnum: Endpoint number
+  * @retval Result of the operation: USBD_OK
+  */
+static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+  UNUSED(Buf);
+  UNUSED(Len);
+  UNUSED(epnum);
+
+  RingBuffer_Skip(&tx_ring, tx_inflight);
+  tx_inflight = 0;
+  tx_stalled = false;
+  tx_full = false;
+  CDC_TxKick_FS();
+  return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_TxKick_FS
+  *         Start a transfer of all contiguous queued bytes if the IN endpoint
+  *         is idle. Queued messages are coalesced into full 64-byte packets;
+  *         the class driver appends a ZLP when the length is a multiple of 64.
+  *         Must not be preempted by the USB interrupt.
+  * @retval None
+  */
+static void CDC_TxKick_FS(void)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  uint8_t *data;
+  uint16_t len;
+
+  if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED || hcdc == NULL) {
+    return;
+  }
+  if (hcdc->TxState != 0 || tx_inflight != 0) {
+    return;
+  }
+
+  len = RingBuffer_Peek(&tx_ring, &data);
+  if (len == 0) {
+    return;
+  }
+  tx_inflight = len;
+  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, data, len);
+  USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+}
+
+/**
+  * @brief  CDC_BeginMessage_FS
+  *         Start a message that is appended piecewise with CDC_Append_FS()
+  *         and published by CDC_EndMessage_FS() (thread context only).
+  *         Appended bytes are not visible to the USB interrupt until the
+  *         message ends, so a message is either sent whole or dropped whole.
+  * @retval None
+  */
+void CDC_BeginMessage_FS(void)
+{
+  tx_staged = 0;
+  tx_message_dropped = false;
+}
+
+/**
+  * @brief  CDC_Append_FS
+  *         Append data to the current message. Never waits: if the queue
+  *         is full after one attempt to start a transfer, the whole message
+  *         is marked as dropped.
+  * @param  Buf: Buffer of data to be sent
+  * @param  Len: Number of data to be sent (in bytes)
+  * @retval None
+  */
+void CDC_Append_FS(const uint8_t* Buf, uint16_t Len)
+{
+  if (tx_message_dropped || Len == 0) {
+    return;
+  }
+
+  if (!RingBuffer_Stage(&tx_ring, tx_staged, Buf, Len)) {
+    HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
+    CDC_TxKick_FS();
+    HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+    if (!RingBuffer_Stage(&tx_ring, tx_staged, Buf, Len)) {
+      CDC_TxFull_FS();
+      tx_message_dropped = true;
+      return;
+    }
+  }
+  tx_staged += Len;
+}
+
+/**
+  * @brief  CDC_EndMessage_FS
+  *         Publish the current message to the TX queue and start sending.
+  * @retval USBD_OK if queued, USBD_BUSY if the message was dropped
+  */
+uint8_t CDC_EndMessage_FS(void)
+{
+  uint16_t count;
+
+  if (tx_message_dropped) {
+    tx_overflow++;
+    return USBD_BUSY;
+  }
+
+  RingBuffer_Commit(&tx_ring, tx_staged);
+  tx_staged = 0;
+  count = RingBuffer_Count(&tx_ring);
+  if (count > tx_high_water) {
+    tx_high_water = count;
+  }
+
+  HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
+  CDC_TxKick_FS();
+  HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+  return USBD_OK;
+}
+
+/**
+  * @brief  CDC_Write_FS
+  *         Queue a complete message for transmission (thread context only).
+  * @param  Buf: Buffer of data to be sent
+  * @param  Len: Number of data to be sent (in bytes)
+  * @retval USBD_OK if queued, USBD_BUSY if dropped
+  */
+uint8_t CDC_Write_FS(const uint8_t* Buf, uint16_t Len)
+{
+  CDC_BeginMessage_FS();
+  CDC_Append_FS(Buf, Len);
+  return CDC_EndMessage_FS();
+}
+
+/**
+  * @brief  CDC_GetTxStats_FS
+  *         TX queue statistics for sizing APP_TX_DATA_SIZE.
+  * @param  high_water: Maximum number of bytes ever queued
+  * @param  overflow: Number of messages dropped because the queue was full
+  * @retval None
+  */
+void CDC_GetTxStats_FS(uint16_t *high_water, uint32_t *overflow)
+{
+  *high_water = tx_high_water;
+  *overflow = tx_overflow;
+}
+
+/**
+  * @brief  CDC_TxReady_FS
+  *         Check whether a message of Len bytes can be queued without
+  *         being dropped. Also true while the host is not reading
+  *         (tx_stalled), so that commands keep running with their replies
+  *         dropped instead of waiting for a host that never reads.
+  * @param  Len: Expected message length (in bytes)
+  * @retval 1 if the caller may write now, 0 if it should retry later
+  */
+uint8_t CDC_TxReady_FS(uint16_t Len)
+{
+  if (tx_stalled || RingBuffer_Free(&tx_ring) - tx_staged >= Len) {
+    return 1;
+  }
+  CDC_TxFull_FS();
+  return tx_stalled;
+}
+
+/**
+  * @brief  CDC_TxFull_FS
+  *         Called whenever the TX queue has no room for a message. When the
+  *         queue stays full without any transfer completing for
+  *         CDC_TX_TIMEOUT_MS, the host is considered not reading
+  *         (tx_stalled) until the next transfer completes.
+  * @retval None
+  */
+static void CDC_TxFull_FS(void)
+{
+  if (!tx_full) {
+    tx_full_tick = HAL_GetTick();
+    tx_full = true;
+  } else if (HAL_GetTick() - tx_full_tick >= CDC_TX_TIMEOUT_MS) {
+    tx_stalled = true;
+  }
+}
+
+/**
+  * @brief  CDC_ResumeReceive_FS
+  *         Re-arm the OUT endpoint after CDC_Receive_FS() left it paused.
+  *         Called from thread context; the USB interrupt is masked so the
+  *         endpoint registers are not modified concurrently.
+  * @retval None
+  */
+void CDC_ResumeReceive_FS(void)
+{
+  HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
+  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+}
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
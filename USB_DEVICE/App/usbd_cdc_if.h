@@ -109,6 +109,13 @@ extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+void CDC_ResumeReceive_FS(void);
+uint8_t CDC_Write_FS(const uint8_t* Buf, uint16_t Len);
+void CDC_BeginMessage_FS(void);
+void CDC_Append_FS(const uint8_t* Buf, uint16_t Len);
+uint8_t CDC_EndMessage_FS(void);
+void CDC_GetTxStats_FS(uint16_t *high_water, uint32_t *overflow);
+uint8_t CDC_TxReady_FS(uint16_t Len);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 